@@ -33,6 +33,33 @@
  * from the OVSDB and it informs ops-switchd to flush those entries from the ASIC
  * L2 MAC table
  *
+ * Several ops-l2macd instances may run at once.  The one holding the
+ * "ops_l2macd" OVSDB lock is active, the others stand by: they keep their
+ * cache in sync but only record the flushes.  When the lock moves to a
+ * standby instance, it sends again the flushes recorded in the last
+ * L2MACD_TAKEOVER_REPLAY_MSEC and carries on without a cold start.  A lone
+ * instance records the flushes found before its first lock reply and sends
+ * all of them once the lock is granted.  The role, takeover latency and
+ * replayed flushes are reported by "ops-l2macd/dump".
+ *
+ * While ops-switchd restarts or the switch warm boots, interface link
+ * states may bounce.  ops-switchd is watched through its pidfile: while it
+ * is not running, and until its pid has been stable for a few seconds, the
+ * flushes are held and collapsed, and sent in one transaction once
+ * ops-switchd is ready, for the ports and VLANs which are still down.
+ *
+ * The MAC age-time set in System:other_config and VLAN:other_config is
+ * validated and the value in effect published in System:status and
+ * VLAN:status, see l2macd_age.h.
+ *
+ * With --mac-monitor, the MACs of the table, of every VLAN and of every
+ * port are counted as they are learned and published in the status
+ * columns, with the state of the table watermarks, see l2macd_mac.h.
+ *
+ * With --warm-macs, "ops-l2macd/save-macs" saves the learned MACs before a
+ * planned restart and they are written to a seed file for ops-switchd on
+ * boot, see l2macd_warm.h.
+ *
  *
  * Public APIs
  *
@@ -47,6 +74,22 @@
  *       --pidfile[=FILE]        create pidfile (default: /var/run/openvswitch/ops-l2macd.pid)
  *       --overwrite-pidfile     with --pidfile, start even if already running
  *
+ *     Checkpoint options:
+ *       --checkpoint=FILE       cache checkpoint file
+ *                               (default: /var/run/openvswitch/ops-l2macd.ckpt)
+ *       --no-checkpoint         do not save nor restore the cache
+ *
+ *     Metrics options:
+ *       --metrics-file=FILE     write Prometheus metrics to FILE
+ *       --metrics-interval=MSEC time between two writes (default: 15000)
+ *
+ *     MAC options:
+ *       --mac-monitor           detect MAC moves and dampen flapping MACs
+ *       --warm-macs[=FILE]      save the learned MACs on request and hand
+ *                               them to ops-switchd on boot, implies
+ *                               --mac-monitor
+ *                               (default: /etc/openvswitch/ops-l2macd.macs)
+ *
  *     Logging options:
  *       -vSPEC, --verbose=SPEC   set logging levels
  *       -v, --verbose            set maximum verbosity level
@@ -64,8 +107,11 @@
  *      coverage/show
  *      exit
  *      list-commands
+ *      memory/show
  *      version
  *      ops-l2macd/dump
+ *      ops-l2macd/loop-stats
+ *      ops-l2macd/save-macs
  *      vlog/disable-rate-limit [module]...
  *      vlog/enable-rate-limit  [module]...
  *      vlog/list
@@ -78,6 +124,7 @@
  *  The following columns are READ by ops-l2macd:
  *
  *      System:cur_cfg
+ *      System:other_config
  *      Interface:name
  *      Interface:link_state
  *      Interface:type
@@ -85,13 +132,26 @@
  *      Port:vlan_mode
  *      Port:tag
  *      Port:interfaces
+ *      Port:other_config (--mac-monitor)
  *      VLAN:name
  *      VLAN:id
  *      VLAN:oper_state
+ *      VLAN:other_config
+ *      MAC:mac_addr (--mac-monitor)
+ *      MAC:mac_vlan (--mac-monitor)
+ *      MAC:port (--mac-monitor)
+ *      MAC:from (--warm-macs)
  *  The following columns are WRITTEN by ops-l2macd:
  *      Port:mac_invalid
  *      Port:mac_invalid_on_vlans
  *      VLAN:macs_invalid
+ *      System:status (mac_age_time, mac_count, mac_table_capacity,
+ *                     mac_high_watermark, mac_low_watermark,
+ *                     mac_watermark_state, mac_watermark_crossings,
+ *                     mac_watermark_last_crossing)
+ *      VLAN:status (mac_age_time, mac_count, mac_limit_exceeded,
+ *                   mac_limit_violations)
+ *      Port:status (mac_count, mac_limit_exceeded, mac_limit_violations)
  *
  * Linux Files:
  *
@@ -99,6 +159,14 @@
  *
  *      /var/run/openvswitch/ops-l2macd.pid: Process ID for ops-l2macd
  *      /var/run/openvswitch/ops-l2macd.<pid>.ctl: Control file for ovs-appctl
+ *      /var/run/openvswitch/ops-l2macd.ckpt: Checkpoint of the port and VLAN
+ *                                            state, read on restart
+ *      --metrics-file FILE: Prometheus metrics for the node exporter
+ *                           textfile collector, when enabled
+ *      --warm-macs FILE: learned MACs saved by ops-l2macd/save-macs before
+ *                        a warm reboot, removed once read on boot
+ *      /var/run/openvswitch/ops-l2macd.seed.macs: saved MACs left on boot
+ *                        for ops-switchd, not read by ops-l2macd
  *
  * @{
  *
@@ -112,6 +180,18 @@
 #define __L2MACD_H__
 
 #include <dynamic-string.h>
+#include <simap.h>
+#include <uuid.h>
+
+enum l2macd_flush_reason {
+    L2MACD_FLUSH_PORT_DOWN,     /* Port link went down */
+    L2MACD_FLUSH_VLAN_DOWN,     /* VLAN went operationally down */
+    L2MACD_FLUSH_RESYNC,        /* Found down by a cache recompute */
+    L2MACD_FLUSH_TAKEOVER,      /* Replayed after a takeover */
+    L2MACD_FLUSH_MAC_MOVE,      /* Flapping MAC, see l2macd_mac.h */
+    L2MACD_FLUSH_MAC_LIMIT,     /* MAC limit exceeded, see l2macd_mac.h */
+    L2MACD_N_FLUSH_REASONS
+};
 
 /**************************************************************************//**
  * @details This function is called by the ops-l2macd main loop for processing
@@ -142,6 +222,22 @@ extern void l2macd_ovsdb_init(const char *db_path);
  *****************************************************************************/
 extern void l2macd_cache_init(void);
 
+/**************************************************************************//**
+ * @details This function is called during ops-l2macd start up, after the
+ * checkpoint file has been mapped, to seed the global internal cache with the
+ * latest checkpoint.  The restored state is reconciled with OVSDB once the
+ * system is configured: the MAC entries of the ports and VLANs which went
+ * down while ops-l2macd was not running are flushed.
+ *****************************************************************************/
+extern void l2macd_cache_restore(void);
+
+/**************************************************************************//**
+ * @details This function writes the global internal cache to the checkpoint
+ * file.  It is called at most once per L2MACD_CKPT_INTERVAL_MSEC while the
+ * cache changes, and on shutdown.
+ *****************************************************************************/
+extern void l2macd_cache_checkpoint(void);
+
 
 /**************************************************************************//**
  * @details This function is called during ops-l2macd shutdown to free
@@ -156,6 +252,61 @@ extern void l2macd_ovsdb_exit(void);
  * @param[in] ds - dynamic string into which the output data is written.
  *****************************************************************************/
 extern void l2macd_debug_dump(struct ds *ds);
+
+/**************************************************************************//**
+ * @details Reports the memory used by the ops-l2macd cache structures and
+ * the OVSDB replica, shown by ovs-appctl "memory/show".
+ *
+ * @param[in] usage - counters by structure, in elements and in bytes.
+ *****************************************************************************/
+extern void l2macd_get_memory_usage(struct simap *usage);
+
+/**************************************************************************//**
+ * @details Appends the flush, cache and OVSDB metrics to 'ds' in the
+ * Prometheus text format.
+ *
+ * @param[in] ds - dynamic string into which the output data is written.
+ *****************************************************************************/
+extern void l2macd_get_metrics(struct ds *ds);
+
+/**************************************************************************//**
+ * @details Requests a flush of the MAC entries of a VLAN on a port through
+ * Port:macs_invalid_on_vlans.  The request is sent with the flush batch.
+ *
+ * @param[in] port_uuid - Port row UUID.
+ * @param[in] vid - VLAN ID.
+ * @param[in] reason - why the entries are flushed, for the statistics.
+ *****************************************************************************/
+extern void l2macd_flush_port_vlan(const struct uuid *port_uuid, int vid,
+                                   enum l2macd_flush_reason reason);
+
+/**************************************************************************//**
+ * @details Requests a flush of the MAC entries of a port through
+ * Port:macs_invalid.  The request is sent with the flush batch.
+ *
+ * @param[in] port_uuid - Port row UUID.
+ * @param[in] reason - why the entries are flushed, for the statistics.
+ *****************************************************************************/
+extern void l2macd_flush_port(const struct uuid *port_uuid,
+                              enum l2macd_flush_reason reason);
+
+/**************************************************************************//**
+ * @details Enables the warm reboot MAC snapshot and reads the snapshot
+ * saved before the restart, before l2macd_ovsdb_init().
+ *
+ * @param[in] path - snapshot file path.
+ *****************************************************************************/
+extern void l2macd_warm_macs_init(const char *path);
+
+/**************************************************************************//**
+ * @details Saves the learned MACs for a warm reboot.
+ *
+ * @param[in] ds - dynamic string into which the reply or the error is
+ *                 written.
+ *
+ * @return true if the snapshot is written.
+ *****************************************************************************/
+extern bool l2macd_warm_macs_save(struct ds *ds);
 #endif /* __L2MACD_H__ */
 
 /** @} end of group ops-l2macd */
@@ -0,0 +1,46 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * MAC age-time settings shared by ops-l2macd and the CLI.
+ *
+ * The age-time is configured in System:other_config and may be overridden
+ * per VLAN in VLAN:other_config, in seconds, 0 disabling aging.  ops-l2macd
+ * validates it and publishes the value in effect in System:status and in
+ * the status of every VLAN, from which the CLI displays it.  Nothing reads
+ * VLAN:status:mac_age_time yet: the VLAN overrides are displayed but not
+ * programmed in the ASIC.
+ ***************************************************************************/
+
+#ifndef __L2MACD_AGE_H__
+#define __L2MACD_AGE_H__
+
+#define L2MACD_AGE_TIME_KEY      "mac_age_time"
+
+#define L2MACD_AGE_TIME_DEFAULT  300
+#define L2MACD_AGE_TIME_MIN      10
+#define L2MACD_AGE_TIME_MAX      1000000
+
+/* True if 'age' seconds is a valid age-time. */
+#define L2MACD_AGE_TIME_VALID(age) \
+    ((age) == 0 || ((age) >= L2MACD_AGE_TIME_MIN \
+                    && (age) <= L2MACD_AGE_TIME_MAX))
+
+#endif /* __L2MACD_AGE_H__ */
@@ -0,0 +1,124 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd cache checkpoint.
+ *
+ * The port link state and VLAN operational state cached by ops-l2macd are
+ * periodically written to a memory-mapped file, so that a restarted daemon
+ * knows the state seen before it went away and can flush the MAC entries
+ * of exactly the ports and VLANs that went down in the meantime.
+ *
+ * The file has a fixed layout: a header followed by two slots.  Each write
+ * fills the slot not holding the latest checkpoint and then bumps its
+ * generation, so a crash in the middle of a write always leaves the
+ * previous checkpoint intact.  A slot is only used when its checksum
+ * matches its content.
+ ***************************************************************************/
+
+#ifndef __L2MACD_CHECKPOINT_H__
+#define __L2MACD_CHECKPOINT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dynamic-string.h>
+
+#define L2MACD_CKPT_FILE            "ops-l2macd.ckpt"
+#define L2MACD_CKPT_MAGIC           0x4c32434b  /* "L2CK" */
+#define L2MACD_CKPT_VERSION         2
+#define L2MACD_CKPT_NAME_LEN        32
+#define L2MACD_CKPT_MAX_PORTS       1024
+#define L2MACD_CKPT_MAX_VLANS       4096
+#define L2MACD_CKPT_INTERVAL_MSEC   1000
+
+/* Cached state of one port. */
+struct l2macd_ckpt_port {
+    char name[L2MACD_CKPT_NAME_LEN];    /* Port name, NUL terminated */
+    uint8_t link_state;                 /* Link status */
+    uint8_t pad[7];
+};
+
+/* Cached state of one VLAN. */
+struct l2macd_ckpt_vlan {
+    int32_t vlan_id;                    /* VLAN ID */
+    uint8_t op_state;                   /* VLAN operational status */
+    uint8_t pad[3];
+};
+
+/* One complete checkpoint of the cache. */
+struct l2macd_ckpt_slot {
+    uint64_t generation;                /* 0 for a slot never written */
+    uint32_t checksum;                  /* CRC-32C of the used part */
+    uint32_t n_ports;
+    uint32_t n_vlans;
+    uint32_t pad;
+    int64_t time_msec;                  /* Wall clock time of the write */
+    struct l2macd_ckpt_port ports[L2MACD_CKPT_MAX_PORTS];
+    struct l2macd_ckpt_vlan vlans[L2MACD_CKPT_MAX_VLANS];
+};
+
+/**************************************************************************//**
+ * @details Maps the checkpoint file at path, creating it if needed.  A file
+ * with a different layout is reset.
+ *
+ * @param[in] path - checkpoint file path.
+ *
+ * @return true if the checkpoint file is mapped.
+ *****************************************************************************/
+extern bool l2macd_ckpt_open(const char *path);
+
+/**************************************************************************//**
+ * @details Unmaps the checkpoint file.
+ *****************************************************************************/
+extern void l2macd_ckpt_close(void);
+
+/**************************************************************************//**
+ * @details Gets the latest valid checkpoint.
+ *
+ * @return the checkpoint, NULL if the file holds none.  It stays valid until
+ * the next l2macd_ckpt_commit() or l2macd_ckpt_close().
+ *****************************************************************************/
+extern const struct l2macd_ckpt_slot *l2macd_ckpt_latest(void);
+
+/**************************************************************************//**
+ * @details Starts a new checkpoint.  The caller fills the ports and VLANs of
+ * the returned slot and then calls l2macd_ckpt_commit().
+ *
+ * @return empty slot, NULL if the checkpoint file is not mapped.
+ *****************************************************************************/
+extern struct l2macd_ckpt_slot *l2macd_ckpt_begin(void);
+
+/**************************************************************************//**
+ * @details Makes the slot filled since l2macd_ckpt_begin() the latest
+ * checkpoint.
+ *
+ * @param[in] slot - slot returned by l2macd_ckpt_begin().
+ *****************************************************************************/
+extern void l2macd_ckpt_commit(struct l2macd_ckpt_slot *slot);
+
+/**************************************************************************//**
+ * @details Appends the checkpoint status to a debug dump.
+ *
+ * @param[in] ds - dynamic string into which the output data is written.
+ *****************************************************************************/
+extern void l2macd_ckpt_dump(struct ds *ds);
+
+#endif /* __L2MACD_CHECKPOINT_H__ */
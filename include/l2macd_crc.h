@@ -0,0 +1,44 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the checksum of the files ops-l2macd keeps across restarts.
+ *
+ * Unlike hash_bytes(), the CRC-32C (Castagnoli) does not depend on the
+ * build, so a file stays valid across an upgrade of ops-l2macd.
+ ***************************************************************************/
+
+#ifndef __L2MACD_CRC_H__
+#define __L2MACD_CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************//**
+ * @details Extends a CRC-32C over a buffer.
+ *
+ * @param[in] crc - CRC of the previous buffers, 0 to start.
+ * @param[in] data - buffer.
+ * @param[in] n - size of the buffer.
+ *
+ * @return the CRC of the previous buffers followed by 'data'.
+ *****************************************************************************/
+extern uint32_t l2macd_crc32c(uint32_t crc, const void *data, size_t n);
+
+#endif /* __L2MACD_CRC_H__ */
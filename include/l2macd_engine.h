@@ -0,0 +1,115 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd incremental processing engine.
+ *
+ * The engine is a graph of nodes.  A node without input reads a source,
+ * e.g. the tracked rows of an OVSDB table, and tells whether it changed.
+ * Any other node computes its data from its inputs: when an input changed,
+ * the change handler registered for that input updates the node
+ * incrementally.  When there is no handler, or the handler cannot process
+ * the change, the node is fully recomputed by its run function.  Nodes
+ * whose inputs did not change are left alone.
+ ***************************************************************************/
+
+#ifndef __L2MACD_ENGINE_H__
+#define __L2MACD_ENGINE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dynamic-string.h>
+
+#define L2MACD_ENGINE_MAX_INPUTS 4
+
+struct l2macd_engine_node;
+
+/* Updates 'node' for a change of one of its inputs.  Returns false if the
+ * change cannot be processed incrementally, the node is then recomputed. */
+typedef bool l2macd_engine_change_handler(struct l2macd_engine_node *node);
+
+struct l2macd_engine_input {
+    struct l2macd_engine_node *node;
+    l2macd_engine_change_handler *change_handler;   /* NULL to recompute */
+};
+
+struct l2macd_engine_node {
+    const char *name;
+    struct l2macd_engine_input inputs[L2MACD_ENGINE_MAX_INPUTS];
+    size_t n_inputs;
+
+    /* Recomputes the node from scratch.  For a node without input, checks
+     * its source.  Sets 'changed' if the node data changed. */
+    void (*run)(struct l2macd_engine_node *node);
+
+    bool changed;                   /* Changed during the last engine run */
+    uint64_t visit_id;              /* Last traversal visiting the node */
+
+    /* Statistics. */
+    uint64_t n_recompute;
+    uint64_t n_incremental;
+    long long int recompute_msec;
+    long long int incremental_msec;
+};
+
+#define L2MACD_ENGINE_NODE_DEFINE(NAME, RUN)            \
+    struct l2macd_engine_node engine_node_##NAME = {    \
+        .name = #NAME,                                  \
+        .run = RUN,                                     \
+    }
+
+/**************************************************************************//**
+ * @details Makes 'input' an input of 'node'.
+ *
+ * @param[in] node - dependent node.
+ * @param[in] input - node 'node' depends on.
+ * @param[in] change_handler - incremental handler, NULL to always recompute
+ *                             'node' when 'input' changes.
+ *****************************************************************************/
+extern void l2macd_engine_add_input(struct l2macd_engine_node *node,
+                                    struct l2macd_engine_node *input,
+                                    l2macd_engine_change_handler *change_handler);
+
+/**************************************************************************//**
+ * @details Recomputes every node at the next engine run, e.g. when the
+ * nodes data may not match their inputs anymore.
+ *****************************************************************************/
+extern void l2macd_engine_force_recompute(void);
+
+/**************************************************************************//**
+ * @details Brings 'root' and all the nodes it depends on up to date.
+ *
+ * @param[in] root - final node of the graph.
+ *****************************************************************************/
+extern void l2macd_engine_run(struct l2macd_engine_node *root);
+
+/**************************************************************************//**
+ * @details Appends the statistics of 'root' and the nodes it depends on to
+ * a debug dump.
+ *
+ * @param[in] root - final node of the graph.
+ * @param[in] ds - dynamic string into which the output data is written.
+ *****************************************************************************/
+extern void l2macd_engine_dump(struct l2macd_engine_node *root,
+                               struct ds *ds);
+
+#endif /* __L2MACD_ENGINE_H__ */
@@ -0,0 +1,42 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * MAC limit and MAC table capacity settings shared by ops-l2macd and the
+ * CLI.
+ *
+ * The limits are set in Port:other_config and VLAN:other_config, the
+ * capacity of the hardware table and its utilization watermarks in
+ * System:other_config.  ops-l2macd enforces them and publishes the counts
+ * and states in the status columns, see l2macd_mac.h.
+ ***************************************************************************/
+
+#ifndef __L2MACD_LIMIT_H__
+#define __L2MACD_LIMIT_H__
+
+#define L2MACD_MAC_LIMIT_KEY            "mac_limit"
+
+#define L2MACD_MAC_CAPACITY_KEY         "mac_table_capacity"
+#define L2MACD_MAC_HIGH_WATERMARK_KEY   "mac_high_watermark"
+#define L2MACD_MAC_LOW_WATERMARK_KEY    "mac_low_watermark"
+#define L2MACD_MAC_HIGH_WATERMARK       90
+#define L2MACD_MAC_LOW_WATERMARK        80
+
+#endif /* __L2MACD_LIMIT_H__ */
@@ -0,0 +1,231 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd MAC table monitor.
+ *
+ * With --mac-monitor, the MAC table is replicated and every learned MAC is
+ * kept in a hash keyed by its packed MAC and VLAN, with the UUID of its
+ * port.  A change of port is a move.  A MAC moving mac_move_threshold times
+ * within mac_move_window ms is flapping: it is reported, the (port, VLAN)
+ * pairs it moved between are flushed and its moves are then ignored for
+ * mac_move_hold_down ms.  The parameters are System:other_config keys.
+ *
+ * The MACs of every port and VLAN are counted as they are learned and
+ * forgotten.  Port:other_config:mac_limit and VLAN:other_config:mac_limit
+ * cap them: the MAC learned beyond the limit of its port flushes the port,
+ * the MAC learned beyond the limit of its VLAN flushes the VLAN on the port
+ * it was learned on.  While still over the limit, as MACs are learned
+ * again until the flush is applied, the port or VLAN is flushed again once
+ * per L2MACD_MAC_LIMIT_FLUSH_MSEC at most.  Going over the limit is counted
+ * as a violation and the port or VLAN is marked as exceeding its limit
+ * until it is back under it.
+ *
+ * The whole table is counted against System:other_config:mac_table_capacity,
+ * the size of the hardware table.  Going over mac_high_watermark percent of
+ * it, or back under mac_low_watermark percent, is a watermark crossing: it
+ * is logged and recorded as an event.  The state changes once per crossing,
+ * the gap between the two watermarks keeps it from flapping.
+ ***************************************************************************/
+
+#ifndef __L2MACD_MAC_H__
+#define __L2MACD_MAC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dynamic-string.h>
+#include <simap.h>
+#include <smap.h>
+#include <uuid.h>
+
+#include "l2macd_limit.h"
+
+#define L2MACD_MAC_MOVE_THRESHOLD       5
+#define L2MACD_MAC_MOVE_WINDOW_MSEC     10000
+#define L2MACD_MAC_MOVE_HOLD_DOWN_MSEC  60000
+
+#define L2MACD_MAC_N_VLANS              4096
+#define L2MACD_MAC_N_WATERMARK_EVENTS   8
+
+/* The MAC counts are published at most once per interval. */
+#define L2MACD_MAC_COUNT_PUBLISH_MSEC   5000
+
+/* Time between two flushes of a port or VLAN over its limit. */
+#define L2MACD_MAC_LIMIT_FLUSH_MSEC     5000
+
+/* MACs of a port or a VLAN. */
+struct l2macd_mac_counter {
+    uint32_t n_macs;                /* MACs learned */
+    uint32_t limit;                 /* Maximum number of MACs, 0 for none */
+    bool exceeded;                  /* More MACs than the limit */
+    uint64_t n_violations;          /* Times the limit was exceeded */
+    long long int next_flush_msec;  /* Earliest next limit flush */
+};
+
+/* Occupancy of the whole MAC table. */
+struct l2macd_mac_utilization {
+    uint32_t n_macs;                /* MACs learned */
+    uint32_t capacity;              /* Table size, 0 if unknown */
+    unsigned int high_pct;          /* High watermark, % of capacity */
+    unsigned int low_pct;           /* Low watermark, % of capacity */
+    bool high;                      /* Over the high watermark, until back
+                                     * under the low one */
+    uint64_t n_crossings;           /* Watermark crossings */
+    long long int last_crossing;    /* Wall clock ms of the last one */
+};
+
+/**************************************************************************//**
+ * @details Enables the MAC table monitor, before l2macd_ovsdb_init().
+ *****************************************************************************/
+extern void l2macd_mac_enable(void);
+
+/**************************************************************************//**
+ * @details Tells whether the MAC table is monitored.
+ *****************************************************************************/
+extern bool l2macd_mac_enabled(void);
+
+/**************************************************************************//**
+ * @details Reads the move detection parameters, the table capacity and its
+ * watermarks.
+ *
+ * @param[in] other_config - System:other_config, NULL for the defaults.
+ *****************************************************************************/
+extern void l2macd_mac_configure(const struct smap *other_config);
+
+/**************************************************************************//**
+ * @details Forgets all the MACs, before they are learned again from the
+ * whole table.
+ *****************************************************************************/
+extern void l2macd_mac_clear(void);
+
+/**************************************************************************//**
+ * @details Records a MAC learned, or moved, on a port.
+ *
+ * @param[in] mac - MAC address, "xx:xx:xx:xx:xx:xx".
+ * @param[in] vid - VLAN ID.
+ * @param[in] row_uuid - MAC row UUID.
+ * @param[in] port_uuid - Port row UUID.
+ * @param[in] detect - false to only record the port, e.g. on a full load.
+ *                     l2macd_mac_configure() then checks the watermarks
+ *                     once the table is loaded.
+ *****************************************************************************/
+extern void l2macd_mac_learn(const char *mac, int vid,
+                             const struct uuid *row_uuid,
+                             const struct uuid *port_uuid, bool detect);
+
+/**************************************************************************//**
+ * @details Forgets a MAC whose row was deleted.
+ *
+ * @param[in] mac - MAC address, "xx:xx:xx:xx:xx:xx".
+ * @param[in] vid - VLAN ID.
+ * @param[in] row_uuid - deleted MAC row UUID.
+ *****************************************************************************/
+extern void l2macd_mac_forget(const char *mac, int vid,
+                              const struct uuid *row_uuid);
+
+/**************************************************************************//**
+ * @details Tells whether a MAC is learned.
+ *
+ * @param[in] mac - MAC address, "xx:xx:xx:xx:xx:xx".
+ * @param[in] vid - VLAN ID.
+ *****************************************************************************/
+extern bool l2macd_mac_learned(const char *mac, int vid);
+
+/**************************************************************************//**
+ * @details Sets the MAC limit of a port.
+ *
+ * @param[in] port_uuid - Port row UUID.
+ * @param[in] limit - maximum number of MACs, 0 for no limit.
+ *****************************************************************************/
+extern void l2macd_mac_set_port_limit(const struct uuid *port_uuid,
+                                      uint32_t limit);
+
+/**************************************************************************//**
+ * @details Sets the MAC limit of a VLAN.
+ *
+ * @param[in] vid - VLAN ID.
+ * @param[in] limit - maximum number of MACs, 0 for no limit.
+ *****************************************************************************/
+extern void l2macd_mac_set_vlan_limit(int vid, uint32_t limit);
+
+/**************************************************************************//**
+ * @details Forgets the counter of a deleted port.
+ *
+ * @param[in] port_uuid - Port row UUID.
+ *****************************************************************************/
+extern void l2macd_mac_port_deleted(const struct uuid *port_uuid);
+
+/**************************************************************************//**
+ * @details Gets the counter of a port.
+ *
+ * @param[in] port_uuid - Port row UUID.
+ *
+ * @return the counter, NULL if the port has neither MAC nor limit.
+ *****************************************************************************/
+extern const struct l2macd_mac_counter *
+l2macd_mac_port_counter(const struct uuid *port_uuid);
+
+/**************************************************************************//**
+ * @details Gets the counter of a VLAN.
+ *
+ * @param[in] vid - VLAN ID.
+ *
+ * @return the counter, NULL if vid is out of range.
+ *****************************************************************************/
+extern const struct l2macd_mac_counter *l2macd_mac_vlan_counter(int vid);
+
+/**************************************************************************//**
+ * @details Gets the occupancy of the whole table.
+ *****************************************************************************/
+extern const struct l2macd_mac_utilization *l2macd_mac_utilization(void);
+
+/**************************************************************************//**
+ * @details Tells whether a port or a VLAN started or stopped exceeding its
+ * limit, or a watermark was crossed, since the last call.
+ *****************************************************************************/
+extern bool l2macd_mac_state_changed(void);
+
+/**************************************************************************//**
+ * @details Tells whether a MAC was counted in or out since the last call.
+ *****************************************************************************/
+extern bool l2macd_mac_counts_changed(void);
+
+/**************************************************************************//**
+ * @details Appends the monitor state to a debug dump.
+ *****************************************************************************/
+extern void l2macd_mac_dump(struct ds *ds);
+
+/**************************************************************************//**
+ * @details Appends the monitor metrics in the Prometheus text format.
+ *****************************************************************************/
+extern void l2macd_mac_metrics(struct ds *ds);
+
+/**************************************************************************//**
+ * @details Reports the memory used by the monitor.
+ *****************************************************************************/
+extern void l2macd_mac_get_memory_usage(struct simap *usage);
+
+/**************************************************************************//**
+ * @details Frees the monitor state.
+ *****************************************************************************/
+extern void l2macd_mac_destroy(void);
+
+#endif /* __L2MACD_MAC_H__ */
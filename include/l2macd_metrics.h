@@ -0,0 +1,70 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd metrics exporter.
+ *
+ * The metrics are written in the Prometheus text format to a file read by
+ * the node exporter textfile collector.  The file is replaced atomically,
+ * every interval, from the main loop.
+ ***************************************************************************/
+
+#ifndef __L2MACD_METRICS_H__
+#define __L2MACD_METRICS_H__
+
+#include <dynamic-string.h>
+
+#define L2MACD_METRICS_INTERVAL_MSEC 15000
+
+/**************************************************************************//**
+ * @details Starts exporting the metrics to 'path'.
+ *
+ * @param[in] path - metrics file, usually ending in ".prom".
+ * @param[in] interval_msec - time between two writes.
+ *****************************************************************************/
+extern void l2macd_metrics_init(const char *path, long long int interval_msec);
+
+/**************************************************************************//**
+ * @details Writes the metrics file when the interval has elapsed.
+ *****************************************************************************/
+extern void l2macd_metrics_run(void);
+
+/**************************************************************************//**
+ * @details Wakes up the main loop for the next write.
+ *****************************************************************************/
+extern void l2macd_metrics_wait(void);
+
+/**************************************************************************//**
+ * @details Stops exporting the metrics.
+ *****************************************************************************/
+extern void l2macd_metrics_destroy(void);
+
+/**************************************************************************//**
+ * @details Appends the HELP and TYPE lines of a metric to 'ds'.
+ *
+ * @param[in] ds - dynamic string into which the output data is written.
+ * @param[in] name - metric name.
+ * @param[in] type - "counter", "gauge" or "histogram".
+ * @param[in] help - metric description.
+ *****************************************************************************/
+extern void l2macd_metrics_header(struct ds *ds, const char *name,
+                                  const char *type, const char *help);
+
+#endif /* __L2MACD_METRICS_H__ */
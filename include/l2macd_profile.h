@@ -0,0 +1,91 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd main loop profiler.
+ *
+ * The time of the main loop is charged to the current phase, which changes
+ * with l2macd_profile_enter().  The cause of each wakeup is noted while the
+ * loop iteration runs and accounted when it ends.  Totals since start and
+ * the last 1 s, 1 min and 5 min are reported by "ops-l2macd/loop-stats".
+ ***************************************************************************/
+
+#ifndef __L2MACD_PROFILE_H__
+#define __L2MACD_PROFILE_H__
+
+#include <dynamic-string.h>
+
+enum l2macd_phase {
+    L2MACD_PHASE_IDLE,              /* Sleeping in poll_block() */
+    L2MACD_PHASE_IDL,               /* ovsdb_idl_run() */
+    L2MACD_PHASE_CACHE,             /* Cache maintenance */
+    L2MACD_PHASE_COMMIT,            /* Blocking flush transactions */
+    L2MACD_PHASE_UNIXCTL,           /* ovs-appctl commands */
+    L2MACD_PHASE_WAIT,              /* Setting up poll_block() */
+    L2MACD_N_PHASES
+};
+
+enum l2macd_wakeup_cause {
+    L2MACD_WAKEUP_IDL,              /* OVSDB update received */
+    L2MACD_WAKEUP_UNIXCTL,          /* ovs-appctl command */
+    L2MACD_WAKEUP_TIMER,            /* Checkpoint or hold deadline */
+    L2MACD_WAKEUP_IMMEDIATE,        /* Backlog left by the previous run */
+    L2MACD_WAKEUP_OTHER,
+    L2MACD_N_WAKEUP_CAUSES
+};
+
+/**************************************************************************//**
+ * @details Charges the time since the last call to the current phase and
+ * makes 'phase' current.
+ *
+ * @param[in] phase - phase starting.
+ *
+ * @return the previous phase, to be restored at the end of a nested phase.
+ *****************************************************************************/
+extern enum l2macd_phase l2macd_profile_enter(enum l2macd_phase phase);
+
+/**************************************************************************//**
+ * @details Notes a cause of the current wakeup.  The first cause in the
+ * order of enum l2macd_wakeup_cause is accounted.
+ *
+ * @param[in] cause - wakeup cause.
+ *****************************************************************************/
+extern void l2macd_profile_note(enum l2macd_wakeup_cause cause);
+
+/**************************************************************************//**
+ * @details Ends a main loop iteration, before poll_block().
+ *****************************************************************************/
+extern void l2macd_profile_loop_end(void);
+
+/**************************************************************************//**
+ * @details Appends the loop statistics to 'ds'.
+ *
+ * @param[in] ds - dynamic string into which the output data is written.
+ *****************************************************************************/
+extern void l2macd_profile_dump(struct ds *ds);
+
+/**************************************************************************//**
+ * @details Appends the loop totals to 'ds' in the Prometheus text format.
+ *
+ * @param[in] ds - dynamic string into which the output data is written.
+ *****************************************************************************/
+extern void l2macd_profile_metrics(struct ds *ds);
+
+#endif /* __L2MACD_PROFILE_H__ */
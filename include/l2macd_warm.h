@@ -0,0 +1,140 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-l2macd
+ *
+ * @file
+ * Header for the ops-l2macd warm reboot MAC snapshot.
+ *
+ * Before a planned restart, "ops-l2macd/save-macs" writes the learned MACs
+ * to a file kept across the reboot.  On boot, once the cache is synced, the
+ * MACs whose port is up and carries their VLAN, whose VLAN is up, and which
+ * are not learned again yet, are written to the seed file
+ * (ovs_rundir()/ops-l2macd.seed.macs), in the same format.  The snapshot
+ * is used once and only if it is younger than the MAC age-time.
+ *
+ * ops-l2macd does not write MAC rows, which ops-switchd owns, and does not
+ * program the seed file in the ASIC either.  The seed file is left for
+ * ops-switchd, which is expected to program its MACs once its hardware is
+ * ready and then delete it; that reader is not part of this repository,
+ * and until it exists the saved MACs are only learned back from traffic.
+ *
+ * The file holds a header, the port names and the MACs, each MAC taking
+ * 10 bytes.  It is written in host byte order to a temporary file which is
+ * then renamed.  It is only used when its CRC-32C matches its content and
+ * every MAC refers to a saved port and a valid VLAN ID.
+ ***************************************************************************/
+
+#ifndef __L2MACD_WARM_H__
+#define __L2MACD_WARM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <shash.h>
+
+#define L2MACD_WARM_FILE            "ops-l2macd.macs"
+#define L2MACD_WARM_SEED_FILE       "ops-l2macd.seed.macs"
+#define L2MACD_WARM_MAGIC           0x4c32574d  /* "L2WM" */
+#define L2MACD_WARM_VERSION         2
+#define L2MACD_WARM_NAME_LEN        32
+#define L2MACD_WARM_MAX_PORTS       UINT16_MAX
+#define L2MACD_WARM_MAX_MACS        (1 << 20)
+
+/* True if 'vid' is a VLAN ID a MAC can be learned on. */
+#define L2MACD_WARM_VID_VALID(vid)  ((vid) > 0 && (vid) < 4096)
+
+/* A saved MAC. */
+struct l2macd_warm_mac {
+    uint8_t mac[6];
+    uint16_t vid;                       /* VLAN ID */
+    uint16_t port;                      /* Index in the port names */
+};
+
+/* A MAC table snapshot. */
+struct l2macd_warm_snapshot {
+    long long int time_msec;            /* Wall clock time of the save */
+    char (*ports)[L2MACD_WARM_NAME_LEN];    /* Port names, NUL terminated */
+    size_t n_ports, allocated_ports;
+    struct l2macd_warm_mac *macs;
+    size_t n_macs, allocated_macs;
+    struct shash port_index;            /* Port name to index + 1 */
+};
+
+/**************************************************************************//**
+ * @details Initializes an empty snapshot.
+ *
+ * @param[out] snap - snapshot.
+ *****************************************************************************/
+extern void l2macd_warm_init(struct l2macd_warm_snapshot *snap);
+
+/**************************************************************************//**
+ * @details Frees a snapshot.
+ *
+ * @param[in] snap - snapshot.
+ *****************************************************************************/
+extern void l2macd_warm_destroy(struct l2macd_warm_snapshot *snap);
+
+/**************************************************************************//**
+ * @details Adds a MAC to a snapshot.
+ *
+ * @param[in] snap - snapshot.
+ * @param[in] mac - MAC address, "xx:xx:xx:xx:xx:xx".
+ * @param[in] vid - VLAN ID.
+ * @param[in] port - port name.
+ *
+ * @return false if the MAC cannot be parsed, the VLAN ID is not valid, the
+ * port name is too long or the snapshot is full.
+ *****************************************************************************/
+extern bool l2macd_warm_add(struct l2macd_warm_snapshot *snap,
+                            const char *mac, int vid, const char *port);
+
+/**************************************************************************//**
+ * @details Formats the address of a saved MAC.
+ *
+ * @param[in] mac - saved MAC.
+ * @param[out] buf - "xx:xx:xx:xx:xx:xx".
+ *****************************************************************************/
+extern void l2macd_warm_format_mac(const struct l2macd_warm_mac *mac,
+                                   char buf[18]);
+
+/**************************************************************************//**
+ * @details Writes a snapshot to a file, replacing it atomically.
+ *
+ * @param[in] snap - snapshot, its time is set.
+ * @param[in] path - file path.
+ *
+ * @return 0 on success, an errno value otherwise.
+ *****************************************************************************/
+extern int l2macd_warm_write(struct l2macd_warm_snapshot *snap,
+                             const char *path);
+
+/**************************************************************************//**
+ * @details Reads a snapshot from a file.
+ *
+ * @param[out] snap - snapshot, empty on error.
+ * @param[in] path - file path.
+ *
+ * @return 0 on success, ENOENT if there is no file, EINVAL if the file is
+ * not a valid snapshot, another errno value otherwise.
+ *****************************************************************************/
+extern int l2macd_warm_read(struct l2macd_warm_snapshot *snap,
+                            const char *path);
+
+#endif /* __L2MACD_WARM_H__ */
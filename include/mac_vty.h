@@ -29,9 +29,8 @@
 #define _MAC_VTY_H
 
 #include "ops-utils.h"
-
-#define MAC_AGE_TIME     300
-#define MAX_VLAN_ID_SIZE 5
+#include "l2macd_age.h"
+#include "l2macd_limit.h"
 
 #define SHOW_MAC_TABLE_STR  "Show L2 MAC address table information\n"
 #define SHOW_MAC_DYN_STR    "Show learnt MAC addresses\n"
@@ -44,21 +43,72 @@
 #define MAC_VLAN_STR        "List of VLANs [e.g. 2,3-10]\n"
 #define MAC_PORT_STR        "List of ports [e.g. 2-6,lag1]\n"
 #define MAC_COUNT_STR       "Number of MAC addresses\n"
+#define SHOW_MAC_WATCH_STR  "Display MAC address table changes as they happen\n"
+#define SHOW_MAC_DIFF_STR   "Show MAC address changes since a saved snapshot\n"
+#define MAC_TABLE_STR       "MAC address table\n"
+#define MAC_SNAPSHOT_STR    "MAC address table snapshots\n"
+#define MAC_SNAPSHOT_NAME_STR "Snapshot name\n"
+#define CLEAR_MAC_TABLE_STR "Clear L2 MAC address table entries\n"
+#define CLEAR_MAC_DYN_STR   "Clear learnt MAC addresses (static entries are " \
+                            "never flushed)\n"
+#define CLEAR_MAC_VLAN_STR  "Clear MAC addresses learnt on VLAN(s)\n"
+#define CLEAR_MAC_PORT_STR  "Clear MAC addresses learnt on port(s)\n"
+#define CLEAR_MAC_ADDR_STR  "Clear all the MAC addresses learnt on the port " \
+                            "and VLAN of a MAC address\n"
+#define SHOW_MAC_JSON_STR   "Display the output in JSON format\n"
+#define SHOW_MAC_PAGE_STR   "Limit the number of MAC addresses displayed\n"
+#define SHOW_MAC_START_STR  "Show MAC addresses ordered after the given MAC address\n"
+#define MAC_PAGE_SIZE_STR   "Maximum number of MAC addresses\n"
+#define MAC_START_VLAN_STR  "Resume after this VLAN of the given MAC address\n"
+#define MAC_AGE_TIME_STR    "Time after which an idle MAC address is removed\n"
+#define MAC_AGE_SECONDS_STR "Age-time in seconds, 0 to disable aging\n"
+#define MAC_AGE_VLAN_STR    "Override the age-time on a VLAN (shown, not yet " \
+                            "programmed in hardware)\n"
+#define MAC_AGE_VID_STR     "VLAN identifier\n"
+#define SHOW_MAC_AGE_STR    "Show the MAC address age-time\n"
+#define MAC_LIMIT_CFG_STR   "Maximum number of MAC addresses learnt\n"
+#define MAC_LIMIT_COUNT_STR "Number of MAC addresses\n"
+#define SHOW_MAC_LIMITS_STR "Show the port and VLAN MAC address limits\n"
+#define MAC_CAPACITY_STR    "Size of the hardware MAC address table\n"
+#define MAC_WATERMARK_STR   "MAC address table utilization watermark\n"
+#define MAC_WM_HIGH_STR     "Watermark to go over to enter the high state\n"
+#define MAC_WM_LOW_STR      "Watermark to go under to leave the high state\n"
+#define MAC_WM_PCT_STR      "Percent of the capacity\n"
+#define SHOW_MAC_UTIL_STR   "Show the MAC address table utilization\n"
 
-#define DISPLAY_MACTABLE_HEADER(vty, count)\
-    vty_out (vty, "MAC age-time            : %d seconds%s", MAC_AGE_TIME, VTY_NEWLINE);\
+#define DISPLAY_MACTABLE_HEADER(vty, age, count)\
+    vty_out (vty, "MAC age-time            : %d seconds%s", age, VTY_NEWLINE);\
     vty_out (vty, "Number of MAC addresses : %d%s", count, VTY_NEWLINE);\
     if (count) {\
         vty_out (vty, "\n%-20s %-8s %-10s %-10s%s", "MAC Address", "VLAN", "Type", "Port", VTY_NEWLINE);\
         vty_out (vty, "--------------------------------------------------%s", VTY_NEWLINE);\
     }\
 
-#define DISPLAY_MACTABLE_ROW(vty, row, vlan_id) \
-    vty_out(vty, "%-20s ", row->mac_addr);\
-    vty_out(vty, "%-8s ",  vlan_id);\
-    vty_out(vty, "%-10s ", row->from); \
-    vty_out(vty, "%-10s ", row->port->name);\
-    vty_out(vty, "%s", VTY_NEWLINE);\
+/* Column widths of a mac table row, see DISPLAY_MACTABLE_HEADER */
+#define MACTABLE_COL_MAC    20
+#define MACTABLE_COL_VLAN   8
+#define MACTABLE_COL_FROM   10
+#define MACTABLE_COL_PORT   10
+
+/* Rows are rendered into a block of this size before being written out */
+#define MACTABLE_FMT_BLOCK_SIZE 8192
+
+/* Room for the decimal representation of a 64-bit integer */
+#define MACTABLE_FMT_INT_SIZE   21
+
+#define VLAN_BITMAP_SIZE    4096
+
+/* Time allowed for a watch session to read the initial MAC table */
+#define MAC_WATCH_SYNC_TIMEOUT_MSEC 5000
+
+/* MAC table snapshots, see mac_snapshot_header */
+#define MAC_SNAPSHOT_BASE_DIR   "/var/local/openswitch"
+#define MAC_SNAPSHOT_DIR        MAC_SNAPSHOT_BASE_DIR "/mac-snapshots"
+#define MAC_SNAPSHOT_MAGIC      0x4c324d53      /* "L2MS" */
+#define MAC_SNAPSHOT_VERSION    2
+#define MAC_SNAPSHOT_NAME_LEN   32
+#define MAC_SNAPSHOT_NAMES_MAX  (1 << 20)
+#define MAC_SNAPSHOT_BATCH      256
 
 #define DISPLAY_MACTABLE_COUNT(count)\
     vty_out (vty, "Number of MAC addresses : %d%s", count, VTY_NEWLINE);\
@@ -0,0 +1,109 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the ops-l2macd incremental processing engine.
+"""
+from pytest import mark
+from time import sleep
+from collections import OrderedDict
+from l2macd_helpers import l2macd_dump
+
+import re
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+# Inputs are dumped before the nodes they feed
+ENGINE_NODES = ['idl_port', 'idl_iface', 'port_cache', 'idl_vlan',
+                'vlan_cache', 'idl_system', 'idl_mac', 'mac_table',
+                'age_time', 'l2macd']
+
+
+def engine_stats(sw1):
+    dump = l2macd_dump(sw1)
+    engine = dump[dump.find('Engine:'):]
+    stats = OrderedDict()
+    for match in re.finditer(r'^\s+(\w+)\s+recompute (\d+) \(\d+ ms\), '
+                             r'incremental (\d+) \(\d+ ms\)', engine,
+                             re.MULTILINE):
+        stats[match.group(1)] = (int(match.group(2)), int(match.group(3)))
+    return stats
+
+
+def wait_incremental(sw1, node, base):
+    for _ in range(10):
+        stats = engine_stats(sw1)
+        if stats[node][1] > base[node][1]:
+            return stats
+        sleep(1)
+    return None
+
+
+@mark.gate
+def test_l2macd_engine(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    sleep(2)
+    dump = l2macd_dump(sw1)
+    assert re.search(r'Engine: \d+ runs', dump)
+    base = engine_stats(sw1)
+    assert list(base) == ENGINE_NODES
+
+    # Source nodes are only read
+    for node in ['idl_port', 'idl_iface', 'idl_vlan', 'idl_system',
+                 'idl_mac']:
+        assert base[node] == (0, 0)
+
+    # A port change is handled incrementally
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.shutdown()
+    stats = wait_incremental(sw1, 'port_cache', base)
+    assert stats is not None
+    assert stats['port_cache'][0] == base['port_cache'][0]
+
+    # So is an age-time change, which does not touch the port cache
+    base = stats
+    sw1('configure terminal')
+    sw1('mac-address-table age-time 60')
+    sw1('end')
+    stats = wait_incremental(sw1, 'age_time', base)
+    assert stats is not None
+    assert stats['age_time'][0] == base['age_time'][0]
+
+    sw1('configure terminal')
+    sw1('no mac-address-table age-time')
+    sw1('end')
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_shutdown()
@@ -0,0 +1,124 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the ops-l2macd Prometheus metrics textfile.
+"""
+from pytest import mark
+from time import sleep
+from l2macd_helpers import l2macd_running, read_metrics
+
+import re
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+METRICS_FILE = '/tmp/test-l2macd.prom'
+FLUSH_REASONS = ['port_down', 'vlan_down', 'resync', 'takeover', 'mac_move',
+                 'mac_limit']
+PORT_DOWN_FLUSHES = 'l2macd_flush_requests_total{reason="port_down"}'
+
+
+def wait_metrics(sw1, sample, minimum):
+    for _ in range(10):
+        metrics = read_metrics(sw1, METRICS_FILE)
+        if metrics.get(sample, -1) >= minimum:
+            return metrics
+        sleep(1)
+    return None
+
+
+def check_histogram(metrics, name):
+    buckets = [value for sample, value in sorted(metrics.items())
+               if sample.startswith(name + '_bucket{')]
+    assert buckets
+    assert metrics[name + '_bucket{le="+Inf"}'] == max(buckets)
+    assert metrics[name + '_bucket{le="+Inf"}'] == metrics[name + '_count']
+
+
+@mark.gate
+def test_l2macd_metrics(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    output = sw1('ops-l2macd --metrics-file={} --metrics-interval=10'
+                 .format(METRICS_FILE), shell='bash')
+    assert '--metrics-interval must be at least 1000 ms' in output
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.vlan_access('2')
+
+    try:
+        with l2macd_running(sw1, '--metrics-file={} --metrics-interval=1000'
+                            .format(METRICS_FILE)):
+            metrics = wait_metrics(sw1, 'l2macd_active', 1)
+            assert metrics is not None
+
+            # Every sample has its HELP and TYPE lines
+            output = sw1('cat {}'.format(METRICS_FILE), shell='bash')
+            names = set(re.findall(r'^(l2macd_\w+?)(?:_bucket|_sum|_count)?'
+                                   r'[{ ]', output, re.MULTILINE))
+            for name in names:
+                assert '# HELP {} '.format(name) in output
+                assert '# TYPE {} '.format(name) in output
+
+            for reason in FLUSH_REASONS:
+                assert ('l2macd_flush_requests_total{{reason="{}"}}'
+                        .format(reason)) in metrics
+            assert metrics['l2macd_cache_entries{table="port"}'] >= 1
+            assert metrics['l2macd_cache_entries{table="vlan"}'] >= 1
+            assert 'l2macd_ovsdb_reconnects_total' in metrics
+            assert 'l2macd_run_seconds_max' in metrics
+            assert any(sample.startswith('l2macd_loop_seconds_total{')
+                       for sample in metrics)
+            check_histogram(metrics, 'l2macd_flush_latency_seconds')
+
+            # A flush is counted with its reason and its latency
+            with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+                ctx.shutdown()
+            flushed = wait_metrics(sw1, PORT_DOWN_FLUSHES,
+                                   metrics[PORT_DOWN_FLUSHES] + 1)
+            assert flushed is not None
+            flushed = wait_metrics(
+                sw1, 'l2macd_flush_latency_seconds_count',
+                metrics['l2macd_flush_latency_seconds_count'] + 1)
+            assert flushed is not None
+            check_histogram(flushed, 'l2macd_flush_latency_seconds')
+
+            # The file is renamed into place, no temporary file is left
+            output = sw1('ls {}.tmp'.format(METRICS_FILE), shell='bash')
+            assert 'No such file' in output
+    finally:
+        sw1('rm -f {}'.format(METRICS_FILE), shell='bash')
+        with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+            ctx.no_shutdown()
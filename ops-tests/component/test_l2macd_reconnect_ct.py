@@ -0,0 +1,105 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the ops-l2macd resync after an OVSDB reconnect.
+"""
+from pytest import mark
+from time import sleep
+from l2macd_helpers import l2macd_running, l2macd_wait_dump, read_metrics
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+# ops-l2macd is connected to its own remote, removing it only drops the
+# session of ops-l2macd
+DB_REMOTE = 'punix:/tmp/test-l2macd-db.sock'
+METRICS_FILE = '/tmp/test-l2macd-reconnect.prom'
+RESYNC_FLUSHES = 'l2macd_flush_requests_total{reason="resync"}'
+
+
+def ovsdb_remote(sw1, command):
+    sw1('ovs-appctl -t ovsdb-server ovsdb-server/{} {}'
+        .format(command, DB_REMOTE), shell='bash')
+
+
+def wait_metric(sw1, sample, expected):
+    for _ in range(10):
+        if read_metrics(sw1, METRICS_FILE).get(sample) == expected:
+            return True
+        sleep(1)
+    return False
+
+
+@mark.gate
+def test_l2macd_reconnect(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    # Port 2 keeps VLAN 2 up while port 1 goes down
+    for intf in ['1', '2']:
+        with sw1.libs.vtysh.ConfigInterface(intf) as ctx:
+            ctx.no_routing()
+            ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    for intf in ['1', '2']:
+        with sw1.libs.vtysh.ConfigInterface(intf) as ctx:
+            ctx.vlan_access('2')
+
+    ovsdb_remote(sw1, 'add-remote')
+    try:
+        with l2macd_running(sw1, '--metrics-file={} --metrics-interval=1000 '
+                            'unix:{}'.format(METRICS_FILE,
+                                             DB_REMOTE[len('punix:'):])):
+            assert l2macd_wait_dump(sw1, r'OVSDB: connected\s')
+            assert wait_metric(sw1, 'l2macd_active', 1)
+            base = read_metrics(sw1, METRICS_FILE)
+            assert base['l2macd_ovsdb_reconnects_total'] == 0
+
+            # Port 1 goes down while ops-l2macd is disconnected
+            ovsdb_remote(sw1, 'remove-remote')
+            assert l2macd_wait_dump(sw1, r'OVSDB: disconnected')
+            with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+                ctx.shutdown()
+            sleep(2)
+            ovsdb_remote(sw1, 'add-remote')
+
+            # The fresh snapshot is diffed against the cache, only the
+            # port that went down is flushed
+            assert l2macd_wait_dump(sw1, r'reconnects: 1\s', timeout=20)
+            assert l2macd_wait_dump(sw1, r'OVSDB: connected\s')
+            assert wait_metric(sw1, 'l2macd_ovsdb_reconnects_total', 1)
+            assert wait_metric(sw1, RESYNC_FLUSHES,
+                               base[RESYNC_FLUSHES] + 1)
+            assert read_metrics(sw1, METRICS_FILE)['l2macd_active'] == 1
+    finally:
+        ovsdb_remote(sw1, 'remove-remote')
+        sw1('rm -f {}'.format(METRICS_FILE), shell='bash')
+        with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+            ctx.no_shutdown()
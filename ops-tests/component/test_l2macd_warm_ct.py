@@ -0,0 +1,190 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the ops-l2macd warm reboot MAC snapshot.
+"""
+from pytest import mark
+from time import sleep
+from l2macd_helpers import l2macd_dump, l2macd_start, l2macd_stop
+from l2macd_helpers import l2macd_systemd_stopped
+
+import base64
+import re
+import struct
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+WARM_FILE = '/tmp/test-l2macd.macs'
+SEED_FILE = '/var/run/openvswitch/ops-l2macd.seed.macs'
+
+# Layout of the snapshot file, see l2macd_warm.h
+WARM_MAGIC = 0x4c32574d
+WARM_VERSION = 2
+WARM_NAME_LEN = 32
+HEADER = struct.Struct('=IIIIqII')
+MAC = struct.Struct('=6sHH')
+
+
+def crc32c(data, crc=0):
+    crc = ~crc & 0xffffffff
+    for byte in bytearray(data):
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0x82f63b78 if crc & 1 else 0)
+    return ~crc & 0xffffffff
+
+
+def snapshot(ports, macs, checksum=None):
+    body = b''.join(name.encode().ljust(WARM_NAME_LEN, b'\0')
+                    for name in ports)
+    body += b''.join(MAC.pack(bytes(bytearray(mac)), vid, port)
+                     for mac, vid, port in macs)
+    fields = [WARM_MAGIC, WARM_VERSION, len(ports), len(macs), 0,
+              MAC.size]
+    if checksum is None:
+        checksum = crc32c(HEADER.pack(*(fields + [0])) + body)
+    return HEADER.pack(*(fields + [checksum])) + body
+
+
+def warm_start(sw1):
+    l2macd_start(sw1, '--warm-macs={}'.format(WARM_FILE))
+
+
+def warm_dump(sw1):
+    dump = l2macd_dump(sw1)
+    print(dump)
+    return dump[dump.find('Warm MACs:'):]
+
+
+def wait_dump(sw1, pattern):
+    for _ in range(10):
+        match = re.search(pattern, warm_dump(sw1))
+        if match:
+            return match
+        sleep(1)
+    return None
+
+
+def wait_handover(sw1):
+    # The counters are zero until the seed file is written
+    counts = []
+    for _ in range(10):
+        match = re.search(r'seeded: (\d+), port missing or down: '
+                          r'(\d+), VLAN missing or down: (\d+), '
+                          r'learned again: (\d+)', warm_dump(sw1))
+        assert match
+        counts = [int(value) for value in match.groups()]
+        if sum(counts):
+            break
+        sleep(1)
+    return counts
+
+
+def write_file(sw1, data):
+    sw1('echo {} | base64 -d > {}'
+        .format(base64.b64encode(data).decode(), WARM_FILE), shell='bash')
+
+
+def check_rejected(sw1, data):
+    write_file(sw1, data)
+    warm_start(sw1)
+    try:
+        assert wait_dump(sw1, r'rejected on boot: not a valid MAC snapshot')
+        assert 'pending:' not in warm_dump(sw1)
+        assert sw1('ls {}'.format(WARM_FILE), shell='bash').find(
+            'No such file') >= 0
+    finally:
+        l2macd_stop(sw1)
+
+
+@mark.gate
+def test_l2macd_warm_macs(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.vlan_access('2')
+
+    mac = [0, 0, 0, 0, 0x0c, 1]
+    valid = snapshot(['1'], [(mac, 2, 0)])
+
+    with l2macd_systemd_stopped(sw1):
+        try:
+            # A truncated file, a file with a bad checksum and files with a
+            # valid checksum but a VLAN ID out of range are all rejected
+            check_rejected(sw1, valid[:-4])
+            checksum = HEADER.unpack(valid[:HEADER.size])[-1]
+            check_rejected(sw1, snapshot(['1'], [(mac, 2, 0)],
+                                         checksum=checksum ^ 1))
+            check_rejected(sw1, snapshot(['1'], [(mac, 0, 0)]))
+            check_rejected(sw1, snapshot(['1'], [(mac, 4096, 0)]))
+
+            # Save and restore the learned MACs
+            sw1('rm -f {}'.format(WARM_FILE), shell='bash')
+            warm_start(sw1)
+            for i in (1, 2):
+                sw1('ovs-vsctl add-mac 00:00:00:00:0c:0{} 2 1 dynamic'
+                    .format(i), shell='bash')
+            sleep(2)
+            output = sw1('ovs-appctl -t ops-l2macd ops-l2macd/save-macs',
+                         shell='bash')
+            assert ('2 MACs on 1 ports saved to {}'.format(WARM_FILE)
+                    in output)
+            assert re.search(r'saves: 1, last 2 MACs', warm_dump(sw1))
+            l2macd_stop(sw1)
+
+            # The MACs are lost with the reboot
+            for i in (1, 2):
+                sw1('ovs-vsctl destroy MAC '
+                    '$(ovs-vsctl --bare --columns=_uuid find MAC '
+                    'mac_addr=00:00:00:00:0c:0{})'.format(i), shell='bash')
+
+            warm_start(sw1)
+            counts = wait_handover(sw1)
+            assert sum(counts) == 2
+            assert 'rejected on boot' not in warm_dump(sw1)
+            if counts[0]:
+                assert 'seed: {}'.format(SEED_FILE) in warm_dump(sw1)
+                assert sw1('ls {}'.format(SEED_FILE), shell='bash').find(
+                    'No such file') < 0
+            else:
+                assert 'seed:' not in warm_dump(sw1)
+
+            # The snapshot is only used once
+            assert sw1('ls {}'.format(WARM_FILE), shell='bash').find(
+                'No such file') >= 0
+        finally:
+            l2macd_stop(sw1)
+            sw1('rm -f {}'.format(WARM_FILE), shell='bash')
@@ -0,0 +1,82 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the MAC address table age-time.
+"""
+from pytest import mark
+from l2macd_helpers import wait_status
+
+import json
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+
+@mark.gate
+def test_mac_age_time(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    output = sw1('show mac-address-table age-time')
+    assert 'MAC age-time            : 300 seconds' in output
+
+    sw1('configure terminal')
+    sw1('mac-address-table age-time 60')
+    sw1('mac-address-table age-time 600 vlan 2')
+    output = sw1('mac-address-table age-time 5')
+    sw1('end')
+    assert 'Age-time must be 0 or between' in output
+
+    # ops-l2macd publishes the values in effect for ops-switchd
+    assert wait_status(sw1, 'System', '.', 'mac_age_time', '60')
+    assert wait_status(sw1, 'VLAN', 'VLAN2', 'mac_age_time', '600')
+
+    output = sw1('show mac-address-table age-time')
+    assert 'MAC age-time            : 60 seconds' in output
+    rows = [line.split() for line in output.splitlines()
+            if line.startswith('2 ')]
+    assert rows == [['2', '600']]
+
+    output = sw1('show mac-address-table json')
+    assert json.loads(output)['mac_age_time'] == 60
+
+    output = sw1('show running-config')
+    assert 'mac-address-table age-time 60\n' in output
+    assert 'mac-address-table age-time 600 vlan 2' in output
+
+    sw1('configure terminal')
+    sw1('no mac-address-table age-time vlan 2')
+    sw1('no mac-address-table age-time')
+    sw1('end')
+
+    assert wait_status(sw1, 'VLAN', 'VLAN2', 'mac_age_time', '300')
+    output = sw1('show mac-address-table age-time')
+    assert 'MAC age-time            : 300 seconds' in output
+    assert 'mac-address-table age-time' not in sw1('show running-config')
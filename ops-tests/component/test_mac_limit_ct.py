@@ -0,0 +1,99 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the port and VLAN MAC address limits.
+"""
+from pytest import mark
+from l2macd_helpers import get_status, wait_status, l2macd_running
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+
+def get_other_config(sw1, table, record, key):
+    output = sw1("ovs-vsctl --if-exists get {} {} other_config:{}"
+                 .format(table, record, key), shell="bash")
+    return output.strip().strip('"')
+
+
+def limit_rows(sw1):
+    output = sw1('show mac-address-table limits')
+    return [line.split() for line in output.splitlines()
+            if line.startswith('port ') or line.startswith('vlan ')]
+
+
+@mark.gate
+def test_mac_limit(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    assert limit_rows(sw1) == []
+
+    sw1('configure terminal')
+    sw1('mac-address-table limit 2 port 1')
+    sw1('mac-address-table limit 100 vlan 2')
+    sw1('end')
+
+    assert get_other_config(sw1, 'Port', '1', 'mac_limit') == '2'
+    assert get_other_config(sw1, 'VLAN', 'VLAN2', 'mac_limit') == '100'
+    assert limit_rows(sw1) == [['port', '1', '2', '0', 'ok'],
+                               ['vlan', '2', '100', '0', 'ok']]
+
+    output = sw1('show running-config')
+    assert 'mac-address-table limit 2 port 1' in output
+    assert 'mac-address-table limit 100 vlan 2' in output
+
+    # The limits are enforced by the ops-l2macd MAC monitor
+    with l2macd_running(sw1, '--mac-monitor'):
+        sw1("ovs-vsctl add-mac 00:00:00:00:00:01 2 1 dynamic", shell="bash")
+        sw1("ovs-vsctl add-mac 00:00:00:00:00:02 2 1 dynamic", shell="bash")
+        assert wait_status(sw1, 'Port', '1', 'mac_count', '2')
+        assert wait_status(sw1, 'VLAN', 'VLAN2', 'mac_count', '2')
+        assert get_status(sw1, 'Port', '1', 'mac_limit_exceeded') == ''
+
+        # One MAC over the port limit is a violation
+        sw1("ovs-vsctl add-mac 00:00:00:00:00:03 2 1 dynamic", shell="bash")
+        assert wait_status(sw1, 'Port', '1', 'mac_limit_violations', '1')
+        assert limit_rows(sw1)[0][:4] == ['port', '1', '2', '1']
+        assert get_status(sw1, 'VLAN', 'VLAN2',
+                          'mac_limit_exceeded') == ''
+
+    sw1('configure terminal')
+    sw1('no mac-address-table limit port 1')
+    sw1('no mac-address-table limit vlan 2')
+    sw1('end')
+
+    assert get_other_config(sw1, 'Port', '1', 'mac_limit') == ''
+    assert get_other_config(sw1, 'VLAN', 'VLAN2', 'mac_limit') == ''
+    assert 'mac-address-table limit' not in sw1('show running-config')
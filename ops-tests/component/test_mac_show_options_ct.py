@@ -0,0 +1,152 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for show mac-address-table output options.
+"""
+from pytest import mark
+
+import json
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+
+def configure_mac_table(sw1):
+    for intf in ['1', '2']:
+        with sw1.libs.vtysh.ConfigInterface(intf) as ctx:
+            ctx.no_routing()
+            ctx.no_shutdown()
+
+    for vlan in ['2', '3']:
+        with sw1.libs.vtysh.ConfigVlan(vlan) as ctx:
+            ctx.no_shutdown()
+
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:01 2 1 dynamic", shell="bash")
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:01 3 2 dynamic", shell="bash")
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:02 2 1 dynamic", shell="bash")
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:03 3 2 dynamic", shell="bash")
+
+
+def get_mac_rows(output):
+    return [line.split() for line in output.splitlines()
+            if line.startswith('00:00:00')]
+
+
+@mark.gate
+def test_show_mac_paging(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    configure_mac_table(sw1)
+
+    rows = get_mac_rows(sw1('show mac-address-table page-size 2'))
+    assert [(r[0], r[1]) for r in rows] == [('00:00:00:00:00:01', '2'),
+                                            ('00:00:00:00:00:01', '3')]
+
+    output = sw1('show mac-address-table page-size 3')
+    assert 'start-after 00:00:00:00:00:02 vlan 2' in output
+
+    rows = get_mac_rows(
+        sw1('show mac-address-table start-after 00:00:00:00:00:01 vlan 2 '
+            'page-size 2'))
+    assert [(r[0], r[1]) for r in rows] == [('00:00:00:00:00:01', '3'),
+                                            ('00:00:00:00:00:02', '2')]
+
+    rows = get_mac_rows(
+        sw1('show mac-address-table start-after 00:00:00:00:00:01'))
+    assert [r[0] for r in rows] == ['00:00:00:00:00:02',
+                                    '00:00:00:00:00:03']
+
+    # Paging of a filtered table
+    output = sw1('show mac-address-table vlan 3 page-size 1')
+    assert [r[0] for r in get_mac_rows(output)] == ['00:00:00:00:00:01']
+    assert 'start-after 00:00:00:00:00:01 vlan 3 page-size 1' in output
+    rows = get_mac_rows(
+        sw1('show mac-address-table vlan 3 start-after 00:00:00:00:00:01 '
+            'vlan 3 page-size 1'))
+    assert [(r[0], r[1]) for r in rows] == [('00:00:00:00:00:03', '3')]
+
+    rows = get_mac_rows(
+        sw1('show mac-address-table port 1 start-after 00:00:00:00:00:01 '
+            'vlan 2 page-size 5'))
+    assert [r[0] for r in rows] == ['00:00:00:00:00:02']
+
+    table = json.loads(sw1('show mac-address-table dynamic page-size 3 '
+                           'json'))
+    assert table['count'] == 3
+    assert table['next'] == {'start_after': '00:00:00:00:00:02', 'vlan': 2}
+
+
+@mark.gate
+def test_show_mac_json(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    configure_mac_table(sw1)
+
+    table = json.loads(sw1('show mac-address-table json'))
+    assert table['count'] == 4
+    assert table['mac_addresses'][0] == {'mac_address': '00:00:00:00:00:01',
+                                         'vlan': 2, 'from': 'dynamic',
+                                         'port': '1'}
+
+    table = json.loads(sw1('show mac-address-table vlan 3 json'))
+    assert [entry['mac_address'] for entry in table['mac_addresses']] == \
+        ['00:00:00:00:00:01', '00:00:00:00:00:03']
+
+    table = json.loads(sw1('show mac-address-table page-size 1 json'))
+    assert table['next'] == {'start_after': '00:00:00:00:00:01', 'vlan': 2}
+
+    summary = json.loads(sw1('show mac-address-table count port 2 json'))
+    assert summary == {'count': 2}
+
+
+@mark.gate
+def test_mac_snapshot_diff(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    configure_mac_table(sw1)
+    # Upper case hex digits are the same address
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:0A 2 1 dynamic", shell="bash")
+
+    output = sw1('mac-address-table snapshot save before')
+    assert 'Saved 5 MAC addresses' in output
+
+    sw1("ovs-vsctl add-mac 00:00:00:00:00:09 2 2 dynamic", shell="bash")
+    sw1("ovs-vsctl del-mac 00:00:00:00:00:03 3", shell="bash")
+
+    output = sw1('show mac-address-table diff before')
+    assert '+ 00:00:00:00:00:09' in output
+    assert '- 00:00:00:00:00:03' in output
+    assert '1 added, 1 removed, 0 moved, 4 unchanged' in output
+    assert '00:00:00:00:00:0A' not in output
+
+    sw1("ovs-vsctl del-mac 00:00:00:00:00:0A 2", shell="bash")
+
+    sw1('mac-address-table snapshot delete before')
+    assert 'not found' in sw1('show mac-address-table diff before')
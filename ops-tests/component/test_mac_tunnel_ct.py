@@ -0,0 +1,88 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the MAC address table display per tunnel key.
+"""
+from pytest import mark
+
+import json
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+# 5000 and 136 share their low 8 bits, 4294967295 is the largest VNI
+TUNNEL_MACS = [('00:00:00:00:0d:01', 5000),
+               ('00:00:00:00:0d:02', 136),
+               ('00:00:00:00:0d:03', 5000),
+               ('00:00:00:00:0d:04', 4294967295)]
+
+
+def get_mac_rows(output):
+    return [line.split() for line in output.splitlines()
+            if line.startswith('00:00:00')]
+
+
+@mark.gate
+def test_show_mac_tunnel(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    sw1("ovs-vsctl add-mac 00:00:00:00:0d:05 2 1 dynamic", shell="bash")
+    for mac, key in TUNNEL_MACS:
+        sw1("ovs-vsctl add-mac {} 2 1 dynamic".format(mac), shell="bash")
+        sw1("ovs-vsctl set MAC "
+            "$(ovs-vsctl --bare --columns=_uuid find MAC mac_addr={}) "
+            "tunnel_key={}".format(mac, key), shell="bash")
+
+    # The whole 32-bit key is compared, the entries of one key are in no
+    # particular order
+    rows = get_mac_rows(sw1('show mac-address-table tunnel 5000'))
+    assert sorted(r[0] for r in rows) == ['00:00:00:00:0d:01',
+                                          '00:00:00:00:0d:03']
+
+    rows = get_mac_rows(sw1('show mac-address-table tunnel 136'))
+    assert [r[0] for r in rows] == ['00:00:00:00:0d:02']
+
+    rows = get_mac_rows(sw1('show mac-address-table tunnel 4294967295'))
+    assert [r[0] for r in rows] == ['00:00:00:00:0d:04']
+
+    # Neither a key without entries nor a MAC off any tunnel is shown
+    assert get_mac_rows(sw1('show mac-address-table tunnel 0')) == []
+    assert get_mac_rows(sw1('show mac-address-table tunnel 5001')) == []
+
+    table = json.loads(sw1('show mac-address-table tunnel 5000 json'))
+    assert table['count'] == 2
+    assert sorted(entry['mac_address']
+                  for entry in table['mac_addresses']) == \
+        ['00:00:00:00:0d:01', '00:00:00:00:0d:03']
@@ -0,0 +1,142 @@
+# -*- coding: utf-8 -*-
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the MAC address table capacity watermarks.
+"""
+from pytest import mark
+from l2macd_helpers import get_status, wait_status, l2macd_running
+
+TOPOLOGY = """
+#
+#  +-------+
+#  | sw1   |
+#  +-------+
+#
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] sw1
+"""
+
+# Capacity of 10 MACs, high state from 5 MACs, back to normal at 2
+CAPACITY = 10
+HIGH_WATERMARK = 50
+LOW_WATERMARK = 20
+
+
+def mac_addr(i):
+    return '00:00:00:00:0b:{:02x}'.format(i)
+
+
+def add_macs(sw1, first, last):
+    for i in range(first, last):
+        sw1("ovs-vsctl add-mac {} 2 1 dynamic".format(mac_addr(i)),
+            shell="bash")
+
+
+def del_macs(sw1, first, last):
+    for i in range(first, last):
+        sw1("ovs-vsctl destroy MAC "
+            "$(ovs-vsctl --bare --columns=_uuid find MAC mac_addr={})"
+            .format(mac_addr(i)), shell="bash")
+
+
+def utilization(sw1):
+    output = sw1('show mac-address-table utilization')
+    return dict((key.strip(), value.strip())
+                for key, value in (line.split(':', 1)
+                                   for line in output.splitlines()
+                                   if ':' in line))
+
+
+@mark.gate
+def test_mac_utilization(topology):
+    sw1 = topology.get('sw1')
+    assert sw1 is not None
+
+    with sw1.libs.vtysh.ConfigInterface('1') as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    with sw1.libs.vtysh.ConfigVlan('2') as ctx:
+        ctx.no_shutdown()
+
+    sw1('configure terminal')
+    sw1('mac-address-table capacity {}'.format(CAPACITY))
+    sw1('mac-address-table watermark high {}'.format(HIGH_WATERMARK))
+    sw1('mac-address-table watermark low {}'.format(LOW_WATERMARK))
+    sw1('end')
+
+    # The low watermark is replayed first, under the default high one
+    output = sw1('show running-config')
+    assert 'mac-address-table capacity {}'.format(CAPACITY) in output
+    low = output.find('mac-address-table watermark low {}'
+                      .format(LOW_WATERMARK))
+    high = output.find('mac-address-table watermark high {}'
+                       .format(HIGH_WATERMARK))
+    assert 0 <= low < high
+
+    # The occupancy is counted by the ops-l2macd MAC monitor
+    with l2macd_running(sw1, '--mac-monitor'):
+        try:
+            # Under the high watermark
+            add_macs(sw1, 0, 4)
+            assert wait_status(sw1, 'System', '.', 'mac_count', '4')
+            assert get_status(sw1, 'System', '.',
+                              'mac_watermark_state') == 'normal'
+            util = utilization(sw1)
+            assert util['Number of MAC addresses'] == '4'
+            assert util['Capacity'] == '10 (40.0% used)'
+            assert util['Watermarks'] == 'high 50%, low 20%'
+            assert util['Watermark state'] == 'normal'
+            assert util['Watermark crossings'] == '0'
+
+            # Reaching the high watermark is one crossing
+            add_macs(sw1, 4, 5)
+            assert wait_status(sw1, 'System', '.', 'mac_watermark_state',
+                               'high')
+            assert get_status(sw1, 'System', '.',
+                              'mac_watermark_crossings') == '1'
+
+            # Between the watermarks the state is kept
+            del_macs(sw1, 4, 5)
+            assert wait_status(sw1, 'System', '.', 'mac_count', '4')
+            assert get_status(sw1, 'System', '.',
+                              'mac_watermark_state') == 'high'
+            add_macs(sw1, 4, 5)
+            del_macs(sw1, 2, 5)
+            assert wait_status(sw1, 'System', '.', 'mac_count', '2')
+            util = utilization(sw1)
+            assert util['Watermark state'] == 'normal'
+            assert util['Watermark crossings'].startswith('2, last at ')
+            assert get_status(sw1, 'System', '.',
+                              'mac_watermark_crossings') == '2'
+
+            output = sw1('show mac-address-table utilization')
+            assert 'VLAN' in output and 'Port' in output
+        finally:
+            del_macs(sw1, 0, 2)
+
+    sw1('configure terminal')
+    sw1('no mac-address-table watermark low')
+    sw1('no mac-address-table watermark high')
+    sw1('no mac-address-table capacity')
+    sw1('end')
+    output = sw1('show running-config')
+    assert 'mac-address-table capacity' not in output
+    assert 'mac-address-table watermark' not in output
@@ -0,0 +1,141 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+OpenSwitch test for the ops-l2macd MAC move detection.
+
+A MAC is moved between two ports. The moves below the threshold are only
+counted, the move reaching it marks the MAC as flapping and holds it down,
+and the moves during the hold-down are counted as held.
+"""
+
+from __future__ import unicode_literals, absolute_import
+from __future__ import print_function, division
+
+from pytest import mark
+from l2macd_helpers import l2macd_dump, l2macd_running
+
+import re
+import time
+
+TOPOLOGY = """
+# +-------+
+# |  ops1 |
+# +-------+
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] ops1
+"""
+
+# Variables
+VLAN = '10'
+INTERFACE1 = '1'
+INTERFACE2 = '2'
+MAC = '00:00:00:00:0a:01'
+MOVE_THRESHOLD = 3
+MOVE_WINDOW_MSEC = 60000
+HOLD_DOWN_MSEC = 60000
+SETTLE_SECONDS = 2
+
+
+def l2macd_mac_stats(ops):
+    dump = l2macd_dump(ops)
+    print(dump)
+    match = re.search(r'learned: (\d+), moves: (\d+), flaps: (\d+), '
+                      r'moves held down: (\d+)', dump)
+    assert match, 'MAC monitor counters not found'
+    stats = dict(zip(('learned', 'moves', 'flaps', 'held'),
+                     (int(value) for value in match.groups())))
+    stats['held_down'] = re.search(r'held down: ' + MAC, dump) is not None
+    return stats
+
+
+def move_mac(ops, port):
+    ops('ovs-vsctl set MAC '
+        '$(ovs-vsctl --bare --columns=_uuid find MAC mac_addr={mac}) '
+        'port=$(ovs-vsctl --bare --columns=_uuid find Port name={port})'
+        .format(mac=MAC, port=port), shell='bash')
+    time.sleep(SETTLE_SECONDS)
+
+
+@mark.timeout(600)
+def test_l2macd_mac_move(topology):
+    """
+    Move a MAC back and forth and check the move and flap counters and
+    the hold-down state reported by ops-l2macd/dump.
+    """
+    ops1 = topology.get('ops1')
+    assert ops1 is not None
+
+    p1 = ops1.ports[INTERFACE1]
+    p2 = ops1.ports[INTERFACE2]
+
+    for port in [INTERFACE1, INTERFACE2]:
+        with ops1.libs.vtysh.ConfigInterface(port) as ctx:
+            ctx.no_routing()
+            ctx.no_shutdown()
+
+    with ops1.libs.vtysh.ConfigVlan(VLAN) as ctx:
+        ctx.no_shutdown()
+
+    for port in [INTERFACE1, INTERFACE2]:
+        with ops1.libs.vtysh.ConfigInterface(port) as ctx:
+            ctx.vlan_access(VLAN)
+
+    ops1('ovs-vsctl set System . '
+         'other_config:mac_move_threshold={} '
+         'other_config:mac_move_window={} '
+         'other_config:mac_move_hold_down={}'
+         .format(MOVE_THRESHOLD, MOVE_WINDOW_MSEC, HOLD_DOWN_MSEC),
+         shell='bash')
+
+    try:
+        with l2macd_running(ops1, '--mac-monitor'):
+            time.sleep(SETTLE_SECONDS)
+            ops1('ovs-vsctl add-mac {} {} {} dynamic'.format(MAC, VLAN, p1),
+                 shell='bash')
+            time.sleep(SETTLE_SECONDS)
+            base = l2macd_mac_stats(ops1)
+            assert not base['held_down']
+
+            # Moves below the threshold are only counted
+            ports = [p2, p1]
+            for i in range(MOVE_THRESHOLD - 1):
+                move_mac(ops1, ports[i % 2])
+            stats = l2macd_mac_stats(ops1)
+            assert stats['moves'] - base['moves'] == MOVE_THRESHOLD - 1
+            assert stats['flaps'] == base['flaps']
+            assert not stats['held_down']
+
+            # The move reaching the threshold makes the MAC flap
+            move_mac(ops1, ports[(MOVE_THRESHOLD - 1) % 2])
+            stats = l2macd_mac_stats(ops1)
+            assert stats['moves'] - base['moves'] == MOVE_THRESHOLD
+            assert stats['flaps'] - base['flaps'] == 1
+            assert stats['held_down'], 'Flapping MAC not held down'
+
+            # Moves during the hold-down are counted but do not flap again
+            for i in range(MOVE_THRESHOLD):
+                move_mac(ops1, ports[(MOVE_THRESHOLD + i) % 2])
+            stats = l2macd_mac_stats(ops1)
+            assert stats['moves'] - base['moves'] == 2 * MOVE_THRESHOLD
+            assert stats['flaps'] - base['flaps'] == 1
+            assert stats['held'] - base['held'] == MOVE_THRESHOLD
+            assert stats['held_down']
+    finally:
+        ops1('ovs-vsctl remove System . other_config mac_move_threshold '
+             'mac_move_window mac_move_hold_down', shell='bash')
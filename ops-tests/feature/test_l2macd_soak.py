@@ -0,0 +1,115 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+OpenSwitch soak test for ops-l2macd memory usage.
+
+VLANs are added and deleted and a port flaps for L2MACD_SOAK_CYCLES cycles
+(set it to millions for a long soak). The cache counters of memory/show
+must come back to their initial value and the RSS of ops-l2macd must stay
+flat once warmed up.
+"""
+
+from __future__ import unicode_literals, absolute_import
+from __future__ import print_function, division
+
+from pytest import mark
+
+import os
+import re
+import time
+
+TOPOLOGY = """
+# +-------+
+# |  ops1 |
+# +-------+
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] ops1
+"""
+
+# Variables
+INTERFACE1 = '1'
+SOAK_VLAN = 900
+CYCLES = int(os.environ.get('L2MACD_SOAK_CYCLES', '2000'))
+CYCLES_PER_ROUND = 100
+RSS_SLACK_KB = 512
+SETTLE_SECONDS = 5
+
+
+def l2macd_rss_kb(ops):
+    status = ops('cat /proc/$(cat /var/run/openvswitch/ops-l2macd.pid)'
+                 '/status', shell='bash')
+    match = re.search(r'VmRSS:\s+(\d+)\s+kB', status)
+    assert match, 'VmRSS not found'
+    return int(match.group(1))
+
+
+def l2macd_memory(ops):
+    output = ops('ovs-appctl -t ops-l2macd memory/show', shell='bash')
+    return dict((key, int(value))
+                for key, value in re.findall(r'([\w-]+):(\d+)', output))
+
+
+def soak_round(ops, port, cycles):
+    vid = SOAK_VLAN
+    ops('for i in $(seq 1 {cycles}); do '
+        'ovs-vsctl -- --id=@v create VLAN name=VLAN{vid} id={vid} '
+        'admin=up -- add Bridge bridge_normal vlans @v; '
+        'ovs-vsctl set interface {port} user_config:admin=down; '
+        'ovs-vsctl set interface {port} user_config:admin=up; '
+        'ovs-vsctl remove Bridge bridge_normal vlans '
+        '$(ovs-vsctl --bare --columns=_uuid find VLAN id={vid}); '
+        'done'.format(**locals()), shell='bash')
+
+
+@mark.timeout(36000)
+def test_l2macd_soak(topology):
+    """
+    Run add/delete/flap cycles and check that ops-l2macd does not leak.
+    """
+    ops1 = topology.get('ops1')
+    assert ops1 is not None
+
+    p1 = ops1.ports[INTERFACE1]
+
+    with ops1.libs.vtysh.ConfigInterface(INTERFACE1) as ctx:
+        ctx.no_routing()
+        ctx.no_shutdown()
+
+    # Warm up, the first round sizes the hash tables and the IDL.
+    soak_round(ops1, p1, CYCLES_PER_ROUND)
+    time.sleep(SETTLE_SECONDS)
+    base_memory = l2macd_memory(ops1)
+    base_rss = l2macd_rss_kb(ops1)
+    print('Baseline: {} RSS {} kB'.format(base_memory, base_rss))
+
+    for done in range(0, CYCLES, CYCLES_PER_ROUND):
+        soak_round(ops1, p1, min(CYCLES_PER_ROUND, CYCLES - done))
+
+    time.sleep(SETTLE_SECONDS)
+    memory = l2macd_memory(ops1)
+    rss = l2macd_rss_kb(ops1)
+    print('After {} cycles: {} RSS {} kB'.format(CYCLES, memory, rss))
+
+    for key in ('ports', 'port-bytes', 'vlans', 'vlan-bytes', 'work-items'):
+        assert memory.get(key) == base_memory.get(key), \
+            '{} grew from {} to {}'.format(key, base_memory.get(key),
+                                           memory.get(key))
+
+    assert rss - base_rss <= RSS_SLACK_KB, \
+        'RSS grew by {} kB over {} cycles'.format(rss - base_rss, CYCLES)
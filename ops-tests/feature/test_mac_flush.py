@@ -24,6 +24,7 @@ from __future__ import print_function, division
 
 from pytest import mark
 
+import re
 import time
 
 TOPOLOGY = """
@@ -52,6 +53,8 @@ HOST_IFNAME = 'eth1'
 INTERFACE1 = '7'
 INTERFACE2 = '8'
 MAC_DB_UPDATE_INTERVAL_SECONDS = (60 + 5)
+STANDBY_PIDFILE = '/tmp/ops-l2macd-standby.pid'
+STANDBY_UNIXCTL = '/tmp/ops-l2macd-standby.ctl'
 
 
 def wait_until_interface_up(switch, portlbl, timeout=30, polling_frequency=1):
@@ -185,6 +188,119 @@ def verify_port_routing_mac_flush(ops, hs1, hs2):
         ctx.vlan_access(VLAN)
 
 
+def verify_clear_port_mac_flush(ops, hs1, hs2):
+    hw_mactable = ops_get_hw_learned_mac_address(ops)
+    print(hw_mactable)
+
+    ops('clear mac-address-table port ' + INTERFACE1)
+
+    time.sleep(MAC_DB_UPDATE_INTERVAL_SECONDS)
+
+    print("########## Verify Clear MAC on Port ##############")
+    hw_mactable = ops_get_hw_learned_mac_address(ops)
+    print(hw_mactable)
+
+    show_mactable = ops_get_mac_table(ops)
+    print(show_mactable)
+    print("##################################################")
+
+    hs1_mac = ops_get_host_mac_address(hs1)
+
+    if hs1_mac in show_mactable:
+        assert False, "Clear port: Host MAC not Flushed"
+    else:
+        print("Learnt MACs flushed after clear mac-address-table port")
+
+
+def standby_dump(ops):
+    dump = ops('ovs-appctl -t {} ops-l2macd/dump'.format(STANDBY_UNIXCTL),
+               shell='bash')
+    print(dump)
+    return dump
+
+
+def wait_standby_dump(ops, pattern, timeout=10):
+    for _ in range(timeout):
+        if re.search(pattern, standby_dump(ops)):
+            return True
+        time.sleep(1)
+    return False
+
+
+def verify_restart_port_down_mac_flush(ops, hs1, hs2):
+    hw_mactable = ops_get_hw_learned_mac_address(ops)
+    print(hw_mactable)
+
+    # Port goes down while ops-l2macd is not running
+    ops('systemctl stop ops-l2macd', shell='bash')
+
+    with ops.libs.vtysh.ConfigInterface(INTERFACE1) as ctx:
+        ctx.shutdown()
+
+    ops('systemctl start ops-l2macd', shell='bash')
+
+    time.sleep(MAC_DB_UPDATE_INTERVAL_SECONDS)
+
+    print("####### Verify Port Down during l2macd restart ######")
+    hw_mactable = ops_get_hw_learned_mac_address(ops)
+    print(hw_mactable)
+
+    show_mactable = ops_get_mac_table(ops)
+    print(show_mactable)
+    print("#####################################################")
+
+    hs1_mac = ops_get_host_mac_address(hs1)
+
+    if hs1_mac in show_mactable:
+        assert False, "Restart: Host MAC not Flushed"
+    else:
+        print("Learnt MACs flushed after l2macd restart")
+
+    dump = ops('ovs-appctl -t ops-l2macd ops-l2macd/dump', shell='bash')
+    print(dump)
+    assert 'Role: active' in dump, "Restart: l2macd not active"
+
+    with ops.libs.vtysh.ConfigInterface(INTERFACE1) as ctx:
+        ctx.no_shutdown()
+    wait_until_interface_up(ops, INTERFACE1)
+
+    # Port goes down while a second l2macd is standing by: it records the
+    # flush instead of sending it, and sends it again once it takes over
+    ops('ops-l2macd --detach --no-checkpoint --pidfile={} --unixctl={}'
+        .format(STANDBY_PIDFILE, STANDBY_UNIXCTL), shell='bash')
+    try:
+        assert wait_standby_dump(ops, r'Role: standby'), \
+            "Standby: second l2macd not standing by"
+
+        with ops.libs.vtysh.ConfigInterface(INTERFACE1) as ctx:
+            ctx.shutdown()
+
+        # Stop the active l2macd right after the flush is recorded, recorded
+        # flushes are only replayed for a short time
+        ops('for i in $(seq 100); do '
+            'ovs-appctl -t {} ops-l2macd/dump | '
+            'grep -q "suppressed flushes: [1-9]" && break; sleep 0.1; done; '
+            'systemctl stop ops-l2macd'.format(STANDBY_UNIXCTL), shell='bash')
+
+        assert wait_standby_dump(ops, r'Role: active'), \
+            "Standby: second l2macd did not take over"
+        dump = standby_dump(ops)
+        counts = re.search(r'suppressed flushes: (\d+), replayed: (\d+)',
+                           dump)
+        assert counts is not None
+        suppressed, replayed = (int(value) for value in counts.groups())
+        assert suppressed > 0, "Standby: port flush not recorded"
+        assert replayed == suppressed, \
+            "Standby: recorded flushes not replayed"
+        assert 'takeovers: 1' in dump
+    finally:
+        ops('ovs-appctl -t {} exit'.format(STANDBY_UNIXCTL), shell='bash')
+        ops('systemctl start ops-l2macd', shell='bash')
+
+    with ops.libs.vtysh.ConfigInterface(INTERFACE1) as ctx:
+        ctx.no_shutdown()
+
+
 def verify_vlan_down_mac_flush(ops, hs1, hs2):
     hw_mactable = ops_get_hw_learned_mac_address(ops)
     print(hw_mactable)
@@ -368,10 +484,18 @@ def test_mac_flush(topology):
     configure_hosts_and_ping(hs1, hs2)
     verify_port_routing_mac_flush(ops1, hs1, hs2)
 
-    # Step3: Verify VLAN Down MAC flush case
+    # Step3: Verify clear mac-address-table on a port
+    configure_hosts_and_ping(hs1, hs2)
+    verify_clear_port_mac_flush(ops1, hs1, hs2)
+
+    # Step4: Verify Port Down while l2macd is restarting
+    configure_hosts_and_ping(hs1, hs2)
+    verify_restart_port_down_mac_flush(ops1, hs1, hs2)
+
+    # Step5: Verify VLAN Down MAC flush case
     configure_hosts_and_ping(hs1, hs2)
     verify_vlan_down_mac_flush(ops1, hs1, hs2)
 
-    # Step4: Verify VLAN Delete MAC flush case
+    # Step6: Verify VLAN Delete MAC flush case
     configure_hosts_and_ping(hs1, hs2)
     verify_vlan_delete_mac_flush(ops1, hs1, hs2)
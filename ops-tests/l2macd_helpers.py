@@ -0,0 +1,108 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Helpers shared by the ops-l2macd tests.
+
+Most ops-l2macd features are off in the instance started by systemd. The
+tests stop it and run their own instance with the options they need, then
+restore the systemd one.
+"""
+
+from __future__ import unicode_literals, absolute_import
+from __future__ import print_function, division
+
+from contextlib import contextmanager
+from time import sleep
+
+import re
+
+
+def get_status(sw, table, record, key):
+    output = sw('ovs-vsctl --if-exists get {} {} status:{}'
+                .format(table, record, key), shell='bash')
+    return output.strip().strip('"')
+
+
+def wait_status(sw, table, record, key, expected, timeout=10):
+    for _ in range(timeout):
+        if get_status(sw, table, record, key) == expected:
+            return True
+        sleep(1)
+    return False
+
+
+def l2macd_start(sw, options=''):
+    sw('ops-l2macd --detach --pidfile {}'.format(options), shell='bash')
+
+
+def l2macd_stop(sw):
+    sw('ovs-appctl -t ops-l2macd exit', shell='bash')
+
+
+def l2macd_dump(sw):
+    return sw('ovs-appctl -t ops-l2macd ops-l2macd/dump', shell='bash')
+
+
+def l2macd_wait_dump(sw, pattern, timeout=10):
+    for _ in range(timeout):
+        match = re.search(pattern, l2macd_dump(sw))
+        if match:
+            return match
+        sleep(1)
+    return None
+
+
+def read_metrics(sw, path):
+    """
+    Read the Prometheus metrics file at 'path', the samples are keyed by
+    name and labels, e.g. 'l2macd_flush_requests_total{reason="resync"}'.
+    """
+    output = sw('cat {}'.format(path), shell='bash')
+    metrics = {}
+    for line in output.splitlines():
+        if line.startswith('l2macd_'):
+            sample, value = line.rsplit(' ', 1)
+            metrics[sample] = float(value)
+    return metrics
+
+
+@contextmanager
+def l2macd_systemd_stopped(sw):
+    """
+    Stop the systemd ops-l2macd for the block, for tests which start and
+    stop their own instances with l2macd_start() and l2macd_stop().
+    """
+    sw('systemctl stop ops-l2macd', shell='bash')
+    try:
+        yield
+    finally:
+        sw('systemctl start ops-l2macd', shell='bash')
+
+
+@contextmanager
+def l2macd_running(sw, options=''):
+    """
+    Run ops-l2macd with 'options' instead of the systemd instance for the
+    block.
+    """
+    with l2macd_systemd_stopped(sw):
+        l2macd_start(sw, options)
+        try:
+            yield
+        finally:
+            l2macd_stop(sw)
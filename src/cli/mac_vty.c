@@ -24,9 +24,18 @@
  *
  ***************************************************************************/
 
+#include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 #include <setjmp.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <pwd.h>
 
@@ -43,452 +52,3564 @@
 #include "mac_vty.h"
 #include "openvswitch/vlog.h"
 #include "openswitch-idl.h"
+#include "packets.h"
 #include "smap.h"
+#include "dirs.h"
+#include "hmap.h"
+#include "hmapx.h"
+#include "latch.h"
+#include "shash.h"
+#include "poll-loop.h"
+#include "util.h"
+#include "uuid.h"
+#include "sset.h"
+#include "bitmap.h"
+#include "timeval.h"
 
 VLOG_DEFINE_THIS_MODULE (vtysh_mac_cli);
 
 extern struct ovsdb_idl *idl;
-static struct ovsdb_idl_index_cursor cursor;
+static struct ovsdb_idl_index_cursor vlan_cursor;
+#ifdef HW_VTEP_SUPPORT
+static struct ovsdb_idl_index_cursor tunnel_cursor;
+#endif
 
 /*-----------------------------------------------------------------------------
- | Function: print_mactable
- | Responsibility: print the mac table entries
+ | Function: mac_row_vlan
+ | Responsibility: get the VLAN of a mac entry, rows without a VLAN sort first
  | Parameters:
- |      nodes :sorted shash nodes
- |      count : number of entries to print
+ |      row : mac table row
  | Return:
- |      None
+ |      VLAN id of the mac entry
  ------------------------------------------------------------------------------
  */
-void
-print_mactable(const struct shash_node **nodes, int count)
+static inline int
+mac_row_vlan(const struct ovsrec_mac *row)
 {
-    int idx;
-    const struct ovsrec_mac *row = NULL;
-    char vlan_id[MAX_VLAN_ID_SIZE] = {0};
+    return row->mac_vlan ? ops_mac_get_vlan(row) : 0;
+}
 
-    DISPLAY_MACTABLE_HEADER(vty, count);
-    for (idx = 0; idx < count; idx++)
-    {
-        row = (const struct ovsrec_mac *)nodes[idx]->data;
-        snprintf(vlan_id, 5, "%" PRIi64, (int64_t)ops_mac_get_vlan(row));
-        DISPLAY_MACTABLE_ROW(vty, row, vlan_id);
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_time_value
+ | Responsibility: read an age-time from a System or VLAN map
+ | Parameters:
+ |      smap : status or other_config
+ |      age : age-time read
+ | Return:
+ |      true if the map holds a valid age-time
+ ------------------------------------------------------------------------------
+ */
+static bool
+mac_age_time_value(const struct smap *smap, int *age)
+{
+    const char *value = smap_get(smap, L2MACD_AGE_TIME_KEY);
+    int parsed;
+
+    if (value == NULL || !str_to_int(value, 10, &parsed)
+        || !L2MACD_AGE_TIME_VALID(parsed)) {
+        return false;
     }
+    *age = parsed;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_time_get
+ | Responsibility: get the age-time in effect, as published by ops-l2macd,
+ |                 or as configured while it has not published it yet
+ | Parameters:
+ |      vlan_row : VLAN row, NULL for the system age-time
+ | Return:
+ |      age-time in seconds
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_age_time_get(const struct ovsrec_vlan *vlan_row)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    int age = L2MACD_AGE_TIME_DEFAULT;
 
+    if (vlan_row && (mac_age_time_value(&vlan_row->status, &age)
+                     || mac_age_time_value(&vlan_row->other_config, &age))) {
+        return age;
+    }
+    if (system_row && (mac_age_time_value(&system_row->status, &age)
+                       || mac_age_time_value(&system_row->other_config,
+                                             &age))) {
+        return age;
+    }
+    return L2MACD_AGE_TIME_DEFAULT;
 }
 
 /*-----------------------------------------------------------------------------
- | Function: mactable_show
- | Responsibility: Display mac entries based on filters applied
+ | Function: mac_index_mac_addr_cmp
+ | Responsibility: compare two mac entries by address for the by_macVlan
+ |                 and by_tunnelKey indexes, regardless of the case of the
+ |                 hex digits
  | Parameters:
- |      from : ogirin of the mac
- |      mac  : mac address
+ |      a_ : mac table row
+ |      b_ : mac table row
  | Return:
- |      CMD_SUCCESS - Command executed successfully.
+ |      <0, 0, >0 as the address of a_ is lower, equal or higher than b_
  ------------------------------------------------------------------------------
  */
 static int
-mactable_show (const char *mac_from, const char *mac, bool show_count)
+mac_index_mac_addr_cmp(const void *a_, const void *b_)
 {
-    const struct ovsrec_mac *row = NULL;
-    struct shash sorted_mac_addr;
-    const struct shash_node **nodes;
-    int count = 0;
+    return strcasecmp(((const struct ovsrec_mac *)a_)->mac_addr,
+                      ((const struct ovsrec_mac *)b_)->mac_addr);
+}
 
-    ovsdb_idl_run (idl);
+/*-----------------------------------------------------------------------------
+ | Function: mac_index_vlan_cmp
+ | Responsibility: compare two mac entries by VLAN for the by_macVlan index
+ | Parameters:
+ |      a_ : mac table row
+ |      b_ : mac table row
+ | Return:
+ |      <0, 0, >0 as the VLAN of a_ is lower, equal or higher than b_
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_index_vlan_cmp(const void *a_, const void *b_)
+{
+    int vlan_a = mac_row_vlan((const struct ovsrec_mac *)a_);
+    int vlan_b = mac_row_vlan((const struct ovsrec_mac *)b_);
 
-    row = ovsrec_mac_first (idl);
-    if (!row)
-    {
-        /* no mac entries in the mac table */
-        vty_out (vty, "No MAC entries found.%s", VTY_NEWLINE);
-        return CMD_SUCCESS;
-    }
+    return vlan_a < vlan_b ? -1 : vlan_a > vlan_b;
+}
 
-    shash_init(&sorted_mac_addr);
+#ifdef HW_VTEP_SUPPORT
+/*-----------------------------------------------------------------------------
+ | Function: mac_row_tunnel_key
+ | Responsibility: get the tunnel key of a mac entry
+ | Parameters:
+ |      row : mac table row
+ | Return:
+ |      32-bit tunnel key, -1 for entries not learnt on a tunnel
+ ------------------------------------------------------------------------------
+ */
+static inline int64_t
+mac_row_tunnel_key(const struct ovsrec_mac *row)
+{
+    return row->n_tunnel_key ? row->tunnel_key[0] : -1;
+}
 
-    OVSREC_MAC_FOR_EACH_BYINDEX (row, &cursor)
-    {
-        if (NULL == row->port)
-            continue;
-        else if ((mac != NULL) && (strcmp(row->mac_addr, mac)) != 0)
-        {
-           /* skip this mac entry as this is not matching with the requested mac address */
-            continue;
-        }
-        else if ((mac_from != NULL) && ((strcmp(row->from, mac_from)) != 0))
-        {
-            /* skip this mac entry as the from field is not matching with the requested */
-            continue;
-        }
-        /* add this mac entry to hash */
-        shash_add(&sorted_mac_addr, row->mac_addr, (void *)row);
-    }
+/*-----------------------------------------------------------------------------
+ | Function: mac_index_tunnel_key_cmp
+ | Responsibility: compare two mac entries by tunnel key for the
+ |                 by_tunnelKey index
+ | Parameters:
+ |      a_ : mac table row
+ |      b_ : mac table row
+ | Return:
+ |      <0, 0, >0 as the tunnel key of a_ is lower, equal or higher than b_
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_index_tunnel_key_cmp(const void *a_, const void *b_)
+{
+    int64_t key_a = mac_row_tunnel_key((const struct ovsrec_mac *)a_);
+    int64_t key_b = mac_row_tunnel_key((const struct ovsrec_mac *)b_);
+
+    return key_a < key_b ? -1 : key_a > key_b;
+}
+#endif
 
-    /* sort based on mac address */
-    nodes = shash_sort(&sorted_mac_addr);
-    count = shash_count(&sorted_mac_addr);
+/* Block buffer used to render mac table rows before writing them out. */
+struct mactable_fmt {
+    char buf[MACTABLE_FMT_BLOCK_SIZE];
+    size_t len;                 /* Bytes of buf in use. */
+    const char *newline;        /* VTY_NEWLINE of the current vty. */
+    size_t newline_len;
+    size_t rows;                /* Rows rendered since mactable_fmt_init. */
+    long long int start_msec;
+};
 
-    if (show_count)
-    {
-        DISPLAY_MACTABLE_COUNT(count);
-    }
-    else
-    {
-        print_mactable(nodes, count);
+static struct mactable_fmt mac_fmt;
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_init
+ | Responsibility: reset the row formatter before rendering a table
+ | Parameters:
+ |      fmt : row formatter
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_init(struct mactable_fmt *fmt)
+{
+    fmt->len = 0;
+    fmt->newline = VTY_NEWLINE;
+    fmt->newline_len = strlen(fmt->newline);
+    fmt->rows = 0;
+    fmt->start_msec = time_msec();
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_flush
+ | Responsibility: write the rendered rows to the vty
+ | Parameters:
+ |      fmt : row formatter
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_flush(struct mactable_fmt *fmt)
+{
+    if (fmt->len == 0) {
+        return;
     }
-    shash_destroy(&sorted_mac_addr);
-    if (nodes != NULL)
-        free(nodes);
+    fmt->buf[fmt->len] = '\0';
+    vty_out(vty, "%s", fmt->buf);
+    fmt->len = 0;
+}
 
-    return CMD_SUCCESS;
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_put
+ | Responsibility: append bytes to the block, flushing it when full
+ | Parameters:
+ |      fmt : row formatter
+ |      s   : bytes to append
+ |      n   : number of bytes
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_put(struct mactable_fmt *fmt, const char *s, size_t n)
+{
+    /* one byte is kept for the terminating NUL written by flush */
+    while (n > 0) {
+        size_t room = sizeof fmt->buf - 1 - fmt->len;
+        size_t chunk = n < room ? n : room;
+
+        memcpy(&fmt->buf[fmt->len], s, chunk);
+        fmt->len += chunk;
+        s += chunk;
+        n -= chunk;
+        if (n > 0) {
+            mactable_fmt_flush(fmt);
+        }
+    }
 }
 
-/* will be enabled after tunnel support is added */
-#ifdef HW_VTEP_SUPPORT
 /*-----------------------------------------------------------------------------
- | Function: mactable_tunnel_show
- | Responsibility: Display mac entries for given tunnel
+ | Function: mactable_fmt_put_field
+ | Responsibility: append a left justified, space terminated column,
+ |                 equivalent to "%-<width>s "
  | Parameters:
- |      tunnel : tunnel key
+ |      fmt   : row formatter
+ |      s     : column value
+ |      n     : length of the column value
+ |      width : column width
  | Return:
- |      CMD_SUCCESS - Command executed successfully.
+ |      None
  ------------------------------------------------------------------------------
  */
-static int
-mactable_tunnel_show (const char *tunnel)
+static void
+mactable_fmt_put_field(struct mactable_fmt *fmt, const char *s, size_t n,
+                       size_t width)
 {
-    const struct ovsrec_mac *row = NULL;
-    struct shash sorted_mac_addr;
-    const struct shash_node **nodes;
-    char tunnel_key = atoi(tunnel);
-    int count = 0;
+    static const char spaces[] = "                                ";
+    size_t pad = (n < width ? width - n : 0) + 1;
 
-    ovsdb_idl_run (idl);
+    mactable_fmt_put(fmt, s, n);
+    mactable_fmt_put(fmt, spaces, pad);
+}
 
-    row = ovsrec_mac_first (idl);
-    if (!row)
-    {
-        /* no mac entries in the mac table */
-        vty_out (vty, "No MAC entries found.%s", VTY_NEWLINE);
-        return CMD_SUCCESS;
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_int
+ | Responsibility: convert an integer to decimal without going through printf
+ | Parameters:
+ |      value  : integer to convert
+ |      digits : buffer of MACTABLE_FMT_INT_SIZE bytes, filled from the end
+ |      n      : set to the number of characters written
+ | Return:
+ |      pointer to the first character inside digits
+ ------------------------------------------------------------------------------
+ */
+static const char *
+mactable_fmt_int(long long int value, char digits[MACTABLE_FMT_INT_SIZE],
+                 size_t *n)
+{
+    char *end = &digits[MACTABLE_FMT_INT_SIZE];
+    char *p = end;
+    unsigned long long int v = value < 0 ? -(unsigned long long int)value
+                                         : (unsigned long long int)value;
+
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0) {
+        *--p = '-';
     }
+    *n = end - p;
+    return p;
+}
 
-    shash_init(&sorted_mac_addr);
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_put_vlan
+ | Responsibility: append the VLAN column
+ | Parameters:
+ |      fmt  : row formatter
+ |      vlan : VLAN id
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_put_vlan(struct mactable_fmt *fmt, int vlan)
+{
+    char digits[MACTABLE_FMT_INT_SIZE];
+    const char *p;
+    size_t n;
 
-    OVSREC_MAC_FOR_EACH_BYINDEX (row, &cursor)
-    {
-        if (tunnel_key != (*(row->tunnel_key)))
-        {
-            /* skip the entries with different tunnel key */
+    p = mactable_fmt_int(vlan, digits, &n);
+    mactable_fmt_put_field(fmt, p, n, MACTABLE_COL_VLAN);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_put_json_str
+ | Responsibility: append a quoted and escaped JSON string
+ | Parameters:
+ |      fmt : row formatter
+ |      s   : string value
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_put_json_str(struct mactable_fmt *fmt, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = s;
+
+    mactable_fmt_put(fmt, "\"", 1);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        char esc[6];
+
+        if (c != '"' && c != '\\' && c >= 0x20) {
             continue;
         }
-        if (NULL == row->port)
-            continue;
-        shash_add(&sorted_mac_addr, row->mac_addr, (void *)row);
+        /* write out the plain characters seen so far, then the escape */
+        mactable_fmt_put(fmt, run, s - run);
+        run = s + 1;
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = c;
+            mactable_fmt_put(fmt, esc, 2);
+        } else {
+            memcpy(esc, "\\u00", 4);
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xf];
+            mactable_fmt_put(fmt, esc, 6);
+        }
     }
+    mactable_fmt_put(fmt, run, s - run);
+    mactable_fmt_put(fmt, "\"", 1);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_put_json_int
+ | Responsibility: append a JSON number
+ | Parameters:
+ |      fmt   : row formatter
+ |      value : integer value
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_put_json_int(struct mactable_fmt *fmt, long long int value)
+{
+    char digits[MACTABLE_FMT_INT_SIZE];
+    const char *p;
+    size_t n;
+
+    p = mactable_fmt_int(value, digits, &n);
+    mactable_fmt_put(fmt, p, n);
+}
 
-    nodes = shash_sort(&sorted_mac_addr);
-    count = shash_count(&sorted_mac_addr);
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_put_cstr
+ | Responsibility: append a NUL terminated string as is
+ | Parameters:
+ |      fmt : row formatter
+ |      s   : string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static inline void
+mactable_fmt_put_cstr(struct mactable_fmt *fmt, const char *s)
+{
+    mactable_fmt_put(fmt, s, strlen(s));
+}
 
-    print_mactable(nodes, count);
-    shash_destroy(&sorted_mac_addr);
-    if (nodes != NULL)
-        free(nodes);
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_row
+ | Responsibility: render one mac table row into the block
+ | Parameters:
+ |      fmt : row formatter
+ |      row : mac table row
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_row(struct mactable_fmt *fmt, const struct ovsrec_mac *row)
+{
+    mactable_fmt_put_field(fmt, row->mac_addr, strlen(row->mac_addr),
+                           MACTABLE_COL_MAC);
+    mactable_fmt_put_vlan(fmt, mac_row_vlan(row));
+    mactable_fmt_put_field(fmt, row->from, strlen(row->from),
+                           MACTABLE_COL_FROM);
+    mactable_fmt_put_field(fmt, row->port->name, strlen(row->port->name),
+                           MACTABLE_COL_PORT);
+    mactable_fmt_put(fmt, fmt->newline, fmt->newline_len);
+    fmt->rows++;
+}
 
-    return CMD_SUCCESS;
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_json_row
+ | Responsibility: render one mac table row as a JSON object
+ | Parameters:
+ |      fmt : row formatter
+ |      row : mac table row
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_json_row(struct mactable_fmt *fmt, const struct ovsrec_mac *row)
+{
+    if (fmt->rows) {
+        mactable_fmt_put(fmt, ",", 1);
+    }
+    mactable_fmt_put(fmt, fmt->newline, fmt->newline_len);
+    mactable_fmt_put_cstr(fmt, "{\"mac_address\":");
+    mactable_fmt_put_json_str(fmt, row->mac_addr);
+    mactable_fmt_put_cstr(fmt, ",\"vlan\":");
+    mactable_fmt_put_json_int(fmt, mac_row_vlan(row));
+    mactable_fmt_put_cstr(fmt, ",\"from\":");
+    mactable_fmt_put_json_str(fmt, row->from);
+    mactable_fmt_put_cstr(fmt, ",\"port\":");
+    mactable_fmt_put_json_str(fmt, row->port->name);
+    mactable_fmt_put(fmt, "}", 1);
+    fmt->rows++;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_fmt_done
+ | Responsibility: flush the remaining rows and log the output rate
+ | Parameters:
+ |      fmt : row formatter
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_fmt_done(struct mactable_fmt *fmt)
+{
+    long long int elapsed;
+
+    mactable_fmt_flush(fmt);
+
+    elapsed = time_msec() - fmt->start_msec;
+    VLOG_DBG("%s: %zu rows in %lld ms (%lld rows/sec)", __FUNCTION__,
+             fmt->rows, elapsed,
+             elapsed ? (long long int)fmt->rows * 1000 / elapsed
+                     : (long long int)fmt->rows * 1000);
 }
+
+/* Selection applied while walking the mac table in (mac, vlan) order. */
+struct mactable_filter {
+    const char *from;           /* Origin of the mac, NULL for any. */
+    const char *mac;            /* Exact mac address, NULL for any. */
+    const char *after_mac;      /* Resume after this mac, NULL for none. */
+    int after_vlan;             /* Resume after this vlan of after_mac,
+                                 * VLAN_BITMAP_SIZE to skip all of them. */
+    unsigned long *vlans;       /* Bitmap of vlans, NULL for any. */
+    struct sset *ports;         /* Set of port names, NULL for any. */
+#ifdef HW_VTEP_SUPPORT
+    bool by_tunnel;             /* Select the entries of tunnel_key only. */
+    int64_t tunnel_key;
 #endif
+};
+
+/* Paging options of a show command, NULL when not given. */
+struct mactable_page {
+    const char *start_mac;      /* Resume after this mac address. */
+    const char *start_vlan;     /* Resume after this vlan of start_mac. */
+    const char *page_size;      /* Maximum number of entries displayed. */
+};
 
 /*-----------------------------------------------------------------------------
- | Function: mactable_vlan_show
- | Responsibility: Display mac entries based on filters applied
+ | Function: mactable_filter_cursor
+ | Responsibility: get the index walked for a filter
  | Parameters:
- |      vlan_list : list of vlans
- |      from : ogirin of the mac
+ |      filter : mac table filter
  | Return:
- |      CMD_SUCCESS - Command executed successfully.
+ |      index cursor
  ------------------------------------------------------------------------------
  */
-static int
-mactable_vlan_show(const char *vlan_list, const char *mac_from, bool show_count)
+static inline struct ovsdb_idl_index_cursor *
+mactable_filter_cursor(const struct mactable_filter *filter OVS_UNUSED)
 {
-    const struct ovsrec_mac *row = NULL;
-    struct range_list *list_temp, *list = NULL;
-    struct shash sorted_mac_addr;
-    const struct shash_node **nodes;
-    int count = 0;
+#ifdef HW_VTEP_SUPPORT
+    if (filter->by_tunnel)
+        return &tunnel_cursor;
+#endif
+    return &vlan_cursor;
+}
 
-    ovsdb_idl_run (idl);
+/*-----------------------------------------------------------------------------
+ | Function: mactable_filter_match
+ | Responsibility: check a mac entry against the filter
+ | Parameters:
+ |      filter : mac table filter
+ |      row : mac table row
+ | Return:
+ |      true if the entry must be displayed
+ ------------------------------------------------------------------------------
+ */
+static bool
+mactable_filter_match(const struct mactable_filter *filter,
+                      const struct ovsrec_mac *row)
+{
+    if (NULL == row->port)
+        return false;
+    if ((filter->from != NULL) && (strcmp(row->from, filter->from) != 0))
+        return false;
+    if ((filter->vlans != NULL)
+        && !bitmap_is_set(filter->vlans, mac_row_vlan(row)))
+        return false;
+    if ((filter->ports != NULL)
+        && !sset_contains(filter->ports, row->port->name))
+        return false;
+    if ((filter->after_mac != NULL)
+        && (strcasecmp(row->mac_addr, filter->after_mac) == 0)
+        && (mac_row_vlan(row) <= filter->after_vlan))
+        return false;
+    return true;
+}
 
-    row = ovsrec_mac_first (idl);
-    if (!row)
+/*-----------------------------------------------------------------------------
+ | Function: mactable_filter_next
+ | Responsibility: advance the cursor to the next entry matching the filter
+ | Parameters:
+ |      filter : mac table filter
+ |      row : current position of the cursor
+ | Return:
+ |      next matching mac entry, NULL at the end of the selection
+ ------------------------------------------------------------------------------
+ */
+static const struct ovsrec_mac *
+mactable_filter_next(const struct mactable_filter *filter,
+                     const struct ovsrec_mac *row)
+{
+    for (; row != NULL;
+         row = ovsrec_mac_index_next(mactable_filter_cursor(filter)))
     {
-        vty_out (vty, "No MAC entries found.%s", VTY_NEWLINE);
-        return CMD_SUCCESS;
+        if ((filter->mac != NULL)
+            && (strcasecmp(row->mac_addr, filter->mac) != 0))
+        {
+            /* all the entries of this mac address have been seen */
+            return NULL;
+        }
+#ifdef HW_VTEP_SUPPORT
+        if (filter->by_tunnel
+            && mac_row_tunnel_key(row) != filter->tunnel_key)
+        {
+            /* all the entries of this tunnel have been seen */
+            return NULL;
+        }
+#endif
+        if (mactable_filter_match(filter, row))
+            return row;
     }
+    return NULL;
+}
 
-    /* get the vlans in a link list */
-    list = cmd_get_range_value(vlan_list, 0);
-    list_temp = list;
+/*-----------------------------------------------------------------------------
+ | Function: mactable_filter_first
+ | Responsibility: position the cursor on the first entry matching the filter
+ | Parameters:
+ |      filter : mac table filter
+ | Return:
+ |      first matching mac entry, NULL if there is none
+ ------------------------------------------------------------------------------
+ */
+static const struct ovsrec_mac *
+mactable_filter_first(const struct mactable_filter *filter)
+{
+    const char *seek = filter->mac ? filter->mac : filter->after_mac;
+    const struct ovsrec_mac *row = NULL;
+    struct ovsrec_mac *key = NULL;
 
-    if (list == NULL)
+#ifdef HW_VTEP_SUPPORT
+    if (filter->by_tunnel)
+    {
+        /* Seek to the first entry of the tunnel, entries of one tunnel
+         * follow each other in (mac, vlan) order. */
+        key = ovsrec_mac_index_init_row(idl, &ovsrec_table_mac);
+        ovsrec_mac_index_set_tunnel_key(key, &filter->tunnel_key, 1);
+        ovsrec_mac_index_set_mac_addr(key, "");
+        row = ovsrec_mac_index_forward_to(&tunnel_cursor, key);
+        ovsrec_mac_index_destroy_row(key);
+        return mactable_filter_next(filter, row);
+    }
+#endif
+
+    /* Seek straight to the requested mac instead of walking every entry
+     * before it. Rows of one mac are ordered by vlan. */
+    if (seek != NULL)
+    {
+        key = ovsrec_mac_index_init_row(idl, &ovsrec_table_mac);
+        ovsrec_mac_index_set_mac_addr(key, seek);
+        row = ovsrec_mac_index_forward_to(&vlan_cursor, key);
+        ovsrec_mac_index_destroy_row(key);
+    }
+    else
+    {
+        row = ovsrec_mac_index_first(&vlan_cursor);
+    }
+
+    return mactable_filter_next(filter, row);
+}
+
+#define MACTABLE_FOR_EACH_MATCH(ROW, FILTER)                              \
+    for ((ROW) = mactable_filter_first(FILTER); (ROW) != NULL;               \
+         (ROW) = mactable_filter_next(FILTER,                                 \
+                     ovsrec_mac_index_next(mactable_filter_cursor(FILTER))))
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_json_show
+ | Responsibility: Stream the selected mac entries as a JSON document
+ | Parameters:
+ |      filter : mac table filter
+ |      limit : maximum number of entries to display
+ |      show_count : display only the number of entries
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mactable_json_show(const struct mactable_filter *filter, size_t limit,
+                   bool show_count)
+{
+    const struct ovsrec_mac *row = NULL;
+    const struct ovsrec_mac *last = NULL;
+    size_t count = 0;
+    bool more = false;
+
+    mactable_fmt_init(&mac_fmt);
+
+    if (show_count)
+    {
+        MACTABLE_FOR_EACH_MATCH (row, filter)
+        {
+            count++;
+        }
+        mactable_fmt_put_cstr(&mac_fmt, "{\"count\":");
+        mactable_fmt_put_json_int(&mac_fmt, count);
+        mactable_fmt_put(&mac_fmt, "}", 1);
+        mactable_fmt_put(&mac_fmt, mac_fmt.newline, mac_fmt.newline_len);
+        mactable_fmt_done(&mac_fmt);
+        return;
+    }
+
+    mactable_fmt_put_cstr(&mac_fmt, "{\"mac_age_time\":");
+    mactable_fmt_put_json_int(&mac_fmt, mac_age_time_get(NULL));
+    mactable_fmt_put_cstr(&mac_fmt, ",\"mac_addresses\":[");
+    MACTABLE_FOR_EACH_MATCH (row, filter)
+    {
+        if (mac_fmt.rows >= limit)
+        {
+            more = true;
+            break;
+        }
+        mactable_fmt_json_row(&mac_fmt, row);
+        last = row;
+    }
+    mactable_fmt_put(&mac_fmt, mac_fmt.newline, mac_fmt.newline_len);
+    mactable_fmt_put_cstr(&mac_fmt, "],\"count\":");
+    mactable_fmt_put_json_int(&mac_fmt, mac_fmt.rows);
+    if (more)
+    {
+        mactable_fmt_put_cstr(&mac_fmt, ",\"next\":{\"start_after\":");
+        mactable_fmt_put_json_str(&mac_fmt, last->mac_addr);
+        mactable_fmt_put_cstr(&mac_fmt, ",\"vlan\":");
+        mactable_fmt_put_json_int(&mac_fmt, mac_row_vlan(last));
+        mactable_fmt_put(&mac_fmt, "}", 1);
+    }
+    mactable_fmt_put(&mac_fmt, "}", 1);
+    mactable_fmt_put(&mac_fmt, mac_fmt.newline, mac_fmt.newline_len);
+    mactable_fmt_done(&mac_fmt);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_filter_show
+ | Responsibility: Display the mac entries selected by the filter
+ | Parameters:
+ |      filter : mac table filter
+ |      limit : maximum number of entries to display
+ |      show_count : display only the number of entries
+ |      json : display the entries as JSON
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_filter_show(const struct mactable_filter *filter, size_t limit,
+                     bool show_count, bool json)
+{
+    const struct ovsrec_mac *row = NULL;
+    const struct ovsrec_mac *last = NULL;
+    size_t count = 0;
+    size_t idx = 0;
+    bool more = false;
+
+    if (json)
+    {
+        mactable_json_show(filter, limit, show_count);
+        return CMD_SUCCESS;
+    }
+
+    if (!ovsrec_mac_first (idl))
+    {
+        /* no mac entries in the mac table */
+        vty_out (vty, "No MAC entries found.%s", VTY_NEWLINE);
+        return CMD_SUCCESS;
+    }
+
+    /* The header carries the number of entries, so count them in a first
+     * pass over the index rather than collecting the rows. */
+    MACTABLE_FOR_EACH_MATCH (row, filter)
+    {
+        if (count >= limit)
+        {
+            more = true;
+            break;
+        }
+        count++;
+    }
+
+    if (show_count)
+    {
+        DISPLAY_MACTABLE_COUNT((int)count);
+        return CMD_SUCCESS;
+    }
+
+    DISPLAY_MACTABLE_HEADER(vty, mac_age_time_get(NULL), (int)count);
+    mactable_fmt_init(&mac_fmt);
+    MACTABLE_FOR_EACH_MATCH (row, filter)
+    {
+        if (idx++ >= count)
+            break;
+        mactable_fmt_row(&mac_fmt, row);
+        last = row;
+    }
+    mactable_fmt_done(&mac_fmt);
+
+    if (more && last != NULL)
+    {
+        vty_out(vty, "%sMore entries available, continue with: "
+                "start-after %s vlan %d page-size %zu%s", VTY_NEWLINE,
+                last->mac_addr, mac_row_vlan(last), limit, VTY_NEWLINE);
+    }
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_page_parse
+ | Responsibility: Check the paging options and apply them to a filter
+ | Parameters:
+ |      page : paging options, NULL for the whole selection
+ |      filter : mac table filter, resumes after the start mac
+ |      mac : storage for the normalized start mac
+ |      limit : maximum number of entries to display
+ | Return:
+ |      false if an option is not valid
+ ------------------------------------------------------------------------------
+ */
+static bool
+mactable_page_parse(const struct mactable_page *page,
+                    struct mactable_filter *filter,
+                    char mac[ETH_ADDR_STRLEN + 1], size_t *limit)
+{
+    struct eth_addr ea;
+    int value;
+
+    *limit = SIZE_MAX;
+    if (page == NULL)
+        return true;
+
+    if (page->start_mac != NULL)
+    {
+        /* The index is ordered on the lower case form of the rows. */
+        if (!eth_addr_from_string(page->start_mac, &ea))
+        {
+            vty_out (vty, "Invalid MAC address %s.%s", page->start_mac,
+                     VTY_NEWLINE);
+            return false;
+        }
+        snprintf(mac, ETH_ADDR_STRLEN + 1, ETH_ADDR_FMT, ETH_ADDR_ARGS(ea));
+        filter->after_mac = mac;
+        filter->after_vlan = VLAN_BITMAP_SIZE;
+    }
+    if (page->start_vlan != NULL)
+    {
+        if (!str_to_int(page->start_vlan, 10, &value)
+            || value < 1 || value >= VLAN_BITMAP_SIZE)
+        {
+            vty_out (vty, "Invalid VLAN %s.%s", page->start_vlan,
+                     VTY_NEWLINE);
+            return false;
+        }
+        filter->after_vlan = value;
+    }
+    if (page->page_size != NULL)
+    {
+        if (!str_to_int(page->page_size, 10, &value) || value < 1)
+        {
+            vty_out (vty, "Invalid page size %s.%s", page->page_size,
+                     VTY_NEWLINE);
+            return false;
+        }
+        *limit = value;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_show
+ | Responsibility: Display mac entries based on filters applied
+ | Parameters:
+ |      from : ogirin of the mac
+ |      mac  : mac address
+ |      page : paging options, NULL for all the entries
+ |      show_count : display only the number of entries
+ |      json : display the entries as JSON
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_show (const char *mac_from, const char *mac,
+               const struct mactable_page *page, bool show_count, bool json)
+{
+    struct mactable_filter filter = { .from = mac_from, .mac = mac };
+    char start_mac[ETH_ADDR_STRLEN + 1];
+    size_t limit;
+
+    if (!mactable_page_parse(page, &filter, start_mac, &limit))
+        return CMD_ERR_NO_MATCH;
+
+    ovsdb_idl_run (idl);
+
+    return mactable_filter_show(&filter, limit, show_count, json);
+}
+
+#ifdef HW_VTEP_SUPPORT
+/*-----------------------------------------------------------------------------
+ | Function: mactable_tunnel_show
+ | Responsibility: Display mac entries for given tunnel
+ | Parameters:
+ |      tunnel : tunnel key
+ |      json : display the entries as JSON
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_tunnel_show (const char *tunnel, bool json)
+{
+    struct mactable_filter filter = { .by_tunnel = true };
+    unsigned long long int tunnel_key;
+    char *end = NULL;
+
+    errno = 0;
+    tunnel_key = strtoull(tunnel, &end, 10);
+    if (errno || *end != '\0' || tunnel_key > UINT32_MAX)
+    {
+        vty_out (vty, "Invalid tunnel key %s.%s", tunnel, VTY_NEWLINE);
+        return CMD_ERR_NO_MATCH;
+    }
+    filter.tunnel_key = tunnel_key;
+
+    ovsdb_idl_run (idl);
+
+    return mactable_filter_show(&filter, SIZE_MAX, false, json);
+}
+#endif
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_vlan_show
+ | Responsibility: Display mac entries based on filters applied
+ | Parameters:
+ |      vlan_list : list of vlans
+ |      from : ogirin of the mac
+ |      page : paging options, NULL for all the entries
+ |      show_count : display only the number of entries
+ |      json : display the entries as JSON
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_vlan_show(const char *vlan_list, const char *mac_from,
+                   const struct mactable_page *page, bool show_count,
+                   bool json)
+{
+    struct mactable_filter filter = { .from = mac_from };
+    struct range_list *list_temp, *list = NULL;
+    char start_mac[ETH_ADDR_STRLEN + 1];
+    size_t limit;
+    int rc;
+
+    if (!mactable_page_parse(page, &filter, start_mac, &limit))
+        return CMD_ERR_NO_MATCH;
+
+    ovsdb_idl_run (idl);
+
+    /* get the vlans in a link list */
+    list = cmd_get_range_value(vlan_list, 0);
+
+    if (list == NULL)
+        return CMD_ERR_NO_MATCH;
+
+    /* turn the list into a bitmap so each entry is checked in O(1) */
+    filter.vlans = bitmap_allocate(VLAN_BITMAP_SIZE);
+    for (list_temp = list; list_temp != NULL; list_temp = list_temp->link)
+    {
+        int vlan_id = atoi(list_temp->value);
+        if (vlan_id > 0 && vlan_id < VLAN_BITMAP_SIZE)
+            bitmap_set1(filter.vlans, vlan_id);
+    }
+    cmd_free_memory_range_list(list);
+
+    rc = mactable_filter_show(&filter, limit, show_count, json);
+    bitmap_free(filter.vlans);
+
+    return rc;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_port_show
+ | Responsibility: Display mac entries based on filters applied
+ | Parameters:
+ |      port_list : list of ports
+ |      from : ogirin of the mac
+ |      page : paging options, NULL for all the entries
+ |      show_count : display only the number of entries
+ |      json : display the entries as JSON
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_port_show(const char *port_list, const char *mac_from,
+                   const struct mactable_page *page, bool show_count,
+                   bool json)
+{
+    struct mactable_filter filter = { .from = mac_from };
+    struct range_list *list, *list_temp = NULL;
+    char start_mac[ETH_ADDR_STRLEN + 1];
+    struct sset ports;
+    size_t limit;
+    int rc;
+
+    if (!mactable_page_parse(page, &filter, start_mac, &limit))
+        return CMD_ERR_NO_MATCH;
+
+    ovsdb_idl_run (idl);
+
+    /* get the ports in a link list */
+    list = cmd_get_range_value(port_list, 1);
+
+    if (list == NULL)
+    {
         return CMD_ERR_NO_MATCH;
+    }
+
+    sset_init(&ports);
+    for (list_temp = list; list_temp != NULL; list_temp = list_temp->link)
+    {
+        sset_add(&ports, list_temp->value);
+    }
+    cmd_free_memory_range_list(list);
+    filter.ports = &ports;
+
+    rc = mactable_filter_show(&filter, limit, show_count, json);
+    sset_destroy(&ports);
+
+    return rc;
+}
+
+/* A mac entry remembered by the watch, so deletes and moves can be
+ * reported with the details the IDL no longer has. */
+struct mac_watch_entry {
+    struct hmap_node hmap_node;     /* In mac_watch "entries", by uuid. */
+    struct uuid uuid;
+    char *mac_addr;
+    int vlan;
+    char *port;
+};
+
+/* State of one "show mac-address-table watch" session. */
+struct mac_watch {
+    struct ovsdb_idl *idl;          /* Private tracked connection. */
+    struct hmap entries;            /* Contains "struct mac_watch_entry"s. */
+    int vlan;                       /* VLAN filter, 0 for any. */
+    const char *port;               /* Port filter, NULL for any. */
+};
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_lookup
+ | Responsibility: find a remembered mac entry
+ | Parameters:
+ |      watch : watch session
+ |      uuid : uuid of the mac row
+ | Return:
+ |      remembered entry, NULL if the row was never seen
+ ------------------------------------------------------------------------------
+ */
+static struct mac_watch_entry *
+mac_watch_lookup(const struct mac_watch *watch, const struct uuid *uuid)
+{
+    struct mac_watch_entry *entry;
+
+    HMAP_FOR_EACH_WITH_HASH (entry, hmap_node, uuid_hash(uuid),
+                             &watch->entries) {
+        if (uuid_equals(&entry->uuid, uuid)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_remember
+ | Responsibility: remember the current state of a mac row
+ | Parameters:
+ |      watch : watch session
+ |      row : mac table row
+ | Return:
+ |      remembered entry
+ ------------------------------------------------------------------------------
+ */
+static struct mac_watch_entry *
+mac_watch_remember(struct mac_watch *watch, const struct ovsrec_mac *row)
+{
+    struct mac_watch_entry *entry;
+
+    entry = mac_watch_lookup(watch, &row->header_.uuid);
+    if (!entry) {
+        entry = xzalloc(sizeof *entry);
+        entry->uuid = row->header_.uuid;
+        entry->mac_addr = xstrdup(row->mac_addr);
+        hmap_insert(&watch->entries, &entry->hmap_node,
+                    uuid_hash(&entry->uuid));
+    }
+    free(entry->port);
+    entry->port = xstrdup(row->port ? row->port->name : "");
+    entry->vlan = mac_row_vlan(row);
+    return entry;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_forget
+ | Responsibility: drop a remembered mac entry
+ | Parameters:
+ |      watch : watch session
+ |      entry : remembered entry
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_watch_forget(struct mac_watch *watch, struct mac_watch_entry *entry)
+{
+    hmap_remove(&watch->entries, &entry->hmap_node);
+    free(entry->mac_addr);
+    free(entry->port);
+    free(entry);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_match
+ | Responsibility: check a mac entry against the watch filter
+ | Parameters:
+ |      watch : watch session
+ |      vlan : VLAN of the entry
+ |      port : port of the entry
+ | Return:
+ |      true if changes of the entry must be displayed
+ ------------------------------------------------------------------------------
+ */
+static bool
+mac_watch_match(const struct mac_watch *watch, int vlan, const char *port)
+{
+    if (watch->vlan && vlan != watch->vlan) {
+        return false;
+    }
+    if (watch->port && (port == NULL || strcmp(port, watch->port))) {
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_print
+ | Responsibility: print one mac table event
+ | Parameters:
+ |      event : "+" learnt, "-" removed, "~" moved
+ |      mac_addr : mac address
+ |      vlan : VLAN of the entry
+ |      port : port of the entry, or the port moved to
+ |      old_port : port moved from, NULL if not a move
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_watch_print(const char *event, const char *mac_addr, int vlan,
+                const char *port, const char *old_port)
+{
+    char stamp[16];
+    time_t now = time_wall_msec() / 1000;
+    struct tm tm;
+
+    strftime(stamp, sizeof stamp, "%H:%M:%S", localtime_r(&now, &tm));
+    if (old_port) {
+        vty_out(vty, "%s %s %-20s vlan %-5d port %s -> %s%s", stamp, event,
+                mac_addr, vlan, old_port, port, VTY_NEWLINE);
+    } else {
+        vty_out(vty, "%s %s %-20s vlan %-5d port %s%s", stamp, event,
+                mac_addr, vlan, port, VTY_NEWLINE);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_process
+ | Responsibility: print the mac table changes of the last IDL batch
+ | Parameters:
+ |      watch : watch session
+ |      seqno : IDL sequence number before the batch was processed
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_watch_process(struct mac_watch *watch, unsigned int seqno)
+{
+    const struct ovsrec_mac *row;
+    struct mac_watch_entry *entry;
+    const char *port;
+    int vlan;
+
+    OVSREC_MAC_FOR_EACH_TRACKED (row, watch->idl) {
+        entry = mac_watch_lookup(watch, &row->header_.uuid);
+
+        if (ovsrec_mac_row_get_seqno(row, OVSDB_IDL_CHANGE_DELETE) > seqno) {
+            /* a deleted row only keeps its uuid, only watched rows are
+             * remembered */
+            if (entry) {
+                mac_watch_print("-", entry->mac_addr, entry->vlan,
+                                entry->port, NULL);
+                mac_watch_forget(watch, entry);
+            }
+            continue;
+        }
+
+        vlan = mac_row_vlan(row);
+        port = row->port ? row->port->name : NULL;
+        if (!mac_watch_match(watch, vlan, port)) {
+            if (entry) {
+                /* moved out of the watched slice */
+                mac_watch_print("~", entry->mac_addr, vlan, port ? port : "",
+                                entry->port);
+                mac_watch_forget(watch, entry);
+            }
+        } else if (!entry) {
+            /* learnt, or moved into the watched slice */
+            entry = mac_watch_remember(watch, row);
+            mac_watch_print("+", entry->mac_addr, entry->vlan, entry->port,
+                            NULL);
+        } else if (strcmp(entry->port, port ? port : "")) {
+            char *old_port = xstrdup(entry->port);
+
+            entry = mac_watch_remember(watch, row);
+            mac_watch_print("~", entry->mac_addr, entry->vlan, entry->port,
+                            old_port);
+            free(old_port);
+        } else {
+            mac_watch_remember(watch, row);
+        }
+    }
+    ovsdb_idl_track_clear(watch->idl);
+}
+
+/* Set from the SIGINT handler of a watch session. vtysh would otherwise
+ * jump out of the watch and leak its connection and entries. */
+static struct latch mac_watch_interrupted;
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_sigint
+ | Responsibility: stop the watch session on Ctrl-C
+ | Parameters:
+ |      sig : signal number
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_watch_sigint(int sig OVS_UNUSED)
+{
+    latch_set(&mac_watch_interrupted);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watch_stopped
+ | Responsibility: consume pending terminal input and interrupts
+ | Parameters:
+ |      None
+ | Return:
+ |      true if the user asked to stop watching, or the standard input
+ |      reached end of file
+ ------------------------------------------------------------------------------
+ */
+static bool
+mac_watch_stopped(void)
+{
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    char buf[64];
+
+    if (latch_poll(&mac_watch_interrupted)) {
+        return true;
+    }
+    if (poll(&pfd, 1, 0) <= 0) {
+        return false;
+    }
+    /* Either a line or the end of file, both end the watch. */
+    if (read(STDIN_FILENO, buf, sizeof buf) < 0 && errno == EAGAIN) {
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_watch
+ | Responsibility: Display mac table changes as they happen
+ | Parameters:
+ |      vlan : VLAN to watch, NULL for any
+ |      port : port to watch, NULL for any
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_watch(const char *vlan, const char *port)
+{
+    struct mac_watch watch = {
+        .vlan = vlan ? atoi(vlan) : 0,
+        .port = port,
+    };
+    struct mac_watch_entry *entry, *next;
+    struct sigaction sa, old_sa;
+    const struct ovsrec_mac *row;
+    long long int deadline;
+    unsigned int seqno;
+    int rc = CMD_SUCCESS;
+    char *db_path;
+
+    /* Ctrl-C ends the session through the cleanup below. */
+    latch_init(&mac_watch_interrupted);
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = mac_watch_sigint;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_sa);
+
+    /* Changes are followed on a private connection, so that row tracking
+     * costs nothing to the rest of vtysh once the watch ends. */
+    db_path = xasprintf("unix:%s/db.sock", ovs_rundir());
+    watch.idl = ovsdb_idl_create(db_path, &ovsrec_idl_class, false, true);
+    free(db_path);
+    hmap_init(&watch.entries);
+
+    ovsdb_idl_add_table(watch.idl, &ovsrec_table_mac);
+    ovsdb_idl_add_column(watch.idl, &ovsrec_mac_col_mac_addr);
+    ovsdb_idl_add_column(watch.idl, &ovsrec_mac_col_mac_vlan);
+    ovsdb_idl_add_column(watch.idl, &ovsrec_mac_col_port);
+    ovsdb_idl_track_add_column(watch.idl, &ovsrec_mac_col_mac_addr);
+    ovsdb_idl_track_add_column(watch.idl, &ovsrec_mac_col_mac_vlan);
+    ovsdb_idl_track_add_column(watch.idl, &ovsrec_mac_col_port);
+    ovsdb_idl_add_table(watch.idl, &ovsrec_table_port);
+    ovsdb_idl_add_column(watch.idl, &ovsrec_port_col_name);
+    ovsdb_idl_add_table(watch.idl, &ovsrec_table_vlan);
+    ovsdb_idl_add_column(watch.idl, &ovsrec_vlan_col_id);
+
+    /* Wait for the initial contents of the table. */
+    seqno = ovsdb_idl_get_seqno(watch.idl);
+    deadline = time_msec() + MAC_WATCH_SYNC_TIMEOUT_MSEC;
+    while (ovsdb_idl_get_seqno(watch.idl) == seqno) {
+        ovsdb_idl_run(watch.idl);
+        if (ovsdb_idl_get_seqno(watch.idl) != seqno) {
+            break;
+        }
+        if (time_msec() >= deadline) {
+            vty_out(vty, "Unable to read the MAC table.%s", VTY_NEWLINE);
+            rc = CMD_WARNING;
+            goto out;
+        }
+        if (latch_poll(&mac_watch_interrupted)) {
+            goto out;
+        }
+        ovsdb_idl_wait(watch.idl);
+        latch_wait(&mac_watch_interrupted);
+        poll_timer_wait_until(deadline);
+        poll_block();
+    }
+
+    /* Remember the watched slice so that deletes and moves of the entries
+     * present before the watch started are reported in full. */
+    OVSREC_MAC_FOR_EACH (row, watch.idl) {
+        if (mac_watch_match(&watch, mac_row_vlan(row),
+                            row->port ? row->port->name : NULL)) {
+            mac_watch_remember(&watch, row);
+        }
+    }
+    ovsdb_idl_track_clear(watch.idl);
+
+    vty_out(vty, "Watching MAC address table changes, "
+            "press Enter or Ctrl-C to stop.%s", VTY_NEWLINE);
+
+    while (!mac_watch_stopped()) {
+        seqno = ovsdb_idl_get_seqno(watch.idl);
+        ovsdb_idl_run(watch.idl);
+        if (ovsdb_idl_get_seqno(watch.idl) != seqno) {
+            mac_watch_process(&watch, seqno);
+        }
+
+        ovsdb_idl_wait(watch.idl);
+        latch_wait(&mac_watch_interrupted);
+        poll_fd_wait(STDIN_FILENO, POLLIN);
+        poll_block();
+    }
+
+out:
+    HMAP_FOR_EACH_SAFE (entry, next, hmap_node, &watch.entries) {
+        mac_watch_forget(&watch, entry);
+    }
+    hmap_destroy(&watch.entries);
+    ovsdb_idl_destroy(watch.idl);
+    sigaction(SIGINT, &old_sa, NULL);
+    latch_destroy(&mac_watch_interrupted);
+
+    return rc;
+}
+
+/* On-disk layout of a MAC table snapshot: a header followed by
+ * "n_entries" packed entries sorted by (mac, vlan), then the "n_ports"
+ * NUL terminated port names the entries refer to. Snapshots are only
+ * read back on the switch that wrote them, so fields are host order. */
+struct mac_snapshot_header {
+    uint32_t magic;             /* MAC_SNAPSHOT_MAGIC. */
+    uint16_t version;           /* MAC_SNAPSHOT_VERSION. */
+    uint16_t entry_size;        /* sizeof(struct mac_snapshot_entry). */
+    uint32_t n_entries;
+    uint32_t n_ports;
+    int64_t time_msec;          /* Wall clock time of the snapshot. */
+    uint32_t names_size;        /* Bytes of the port names. */
+    uint32_t reserved;
+};
+
+struct mac_snapshot_entry {
+    uint8_t mac[6];
+    uint16_t vlan;
+    uint32_t port;              /* Index in the port names. */
+};
+
+/* A snapshot or live entry, as compared by the diff. */
+struct mac_snapshot_item {
+    struct eth_addr mac;
+    uint16_t vlan;
+    const char *port;           /* Full port name. */
+};
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_path
+ | Responsibility: build the file name of a snapshot
+ | Parameters:
+ |      name : snapshot name
+ | Return:
+ |      allocated path, NULL if the name is not valid
+ ------------------------------------------------------------------------------
+ */
+static char *
+mac_snapshot_path(const char *name)
+{
+    const char *p;
+
+    if (!*name || strlen(name) > MAC_SNAPSHOT_NAME_LEN || name[0] == '.') {
+        return NULL;
+    }
+    for (p = name; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '-' && *p != '_'
+            && *p != '.') {
+            return NULL;
+        }
+    }
+    return xasprintf("%s/%s.snap", MAC_SNAPSHOT_DIR, name);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_cmp
+ | Responsibility: order two snapshot items by (mac, vlan)
+ | Parameters:
+ |      a : snapshot item
+ |      b : snapshot item
+ | Return:
+ |      <0, 0, >0 as a sorts before, equal to or after b
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_snapshot_cmp(const struct mac_snapshot_item *a,
+                 const struct mac_snapshot_item *b)
+{
+    int cmp = memcmp(a->mac.ea, b->mac.ea, sizeof a->mac.ea);
+
+    return cmp ? cmp : (int)a->vlan - (int)b->vlan;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_next_live
+ | Responsibility: read the next mac row of the (mac, vlan) index as a
+ |                 snapshot item
+ | Parameters:
+ |      row : current index position, advanced past the returned item
+ |      item : snapshot item, refers to the port name of the row
+ | Return:
+ |      false at the end of the table
+ ------------------------------------------------------------------------------
+ */
+static bool
+mac_snapshot_next_live(const struct ovsrec_mac **row,
+                       struct mac_snapshot_item *item)
+{
+    /* The index compares addresses regardless of case, so the walk yields
+     * entries in the byte order of the snapshot. */
+    for (; *row != NULL; *row = ovsrec_mac_index_next(&vlan_cursor)) {
+        if ((*row)->port && eth_addr_from_string((*row)->mac_addr,
+                                                 &item->mac)) {
+            item->vlan = mac_row_vlan(*row);
+            item->port = (*row)->port->name;
+            *row = ovsrec_mac_index_next(&vlan_cursor);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_save
+ | Responsibility: save the mac table into a named snapshot
+ | Parameters:
+ |      name : snapshot name
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_snapshot_save(const char *name)
+{
+    struct mac_snapshot_header header;
+    struct mac_snapshot_entry entry;
+    struct mac_snapshot_item item;
+    const struct ovsrec_mac *row;
+    struct ds names = DS_EMPTY_INITIALIZER;
+    struct shash ports;
+    char *path, *tmp;
+    uintptr_t index;
+    FILE *fp;
+    bool ok;
+
+    path = mac_snapshot_path(name);
+    if (!path) {
+        vty_out(vty, "Invalid snapshot name %s.%s", name, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    if ((mkdir(MAC_SNAPSHOT_BASE_DIR, 0755) && errno != EEXIST)
+        || (mkdir(MAC_SNAPSHOT_DIR, 0755) && errno != EEXIST)) {
+        vty_out(vty, "Unable to create %s: %s%s", MAC_SNAPSHOT_DIR,
+                ovs_strerror(errno), VTY_NEWLINE);
+        free(path);
+        return CMD_WARNING;
+    }
+
+    tmp = xasprintf("%s.tmp", path);
+    fp = fopen(tmp, "wb");
+    if (!fp) {
+        vty_out(vty, "Unable to create %s: %s%s", tmp, ovs_strerror(errno),
+                VTY_NEWLINE);
+        free(tmp);
+        free(path);
+        return CMD_WARNING;
+    }
+
+    ovsdb_idl_run(idl);
+
+    /* The counts are only known at the end, the header is written again
+     * once all the entries and the port names are out. */
+    memset(&header, 0, sizeof header);
+    header.magic = MAC_SNAPSHOT_MAGIC;
+    header.version = MAC_SNAPSHOT_VERSION;
+    header.entry_size = sizeof entry;
+    header.time_msec = time_wall_msec();
+    ok = fwrite(&header, sizeof header, 1, fp) == 1;
+
+    /* Port names are saved once, in full, the entries refer to them by
+     * index. */
+    shash_init(&ports);
+    row = ovsrec_mac_index_first(&vlan_cursor);
+    while (ok && mac_snapshot_next_live(&row, &item)) {
+        index = (uintptr_t) shash_find_data(&ports, item.port);
+        if (index == 0) {
+            ds_put_cstr(&names, item.port);
+            ds_put_char(&names, '\0');
+            index = ++header.n_ports;
+            shash_add(&ports, item.port, (void *) index);
+        }
+        memset(&entry, 0, sizeof entry);
+        memcpy(entry.mac, item.mac.ea, sizeof entry.mac);
+        entry.vlan = item.vlan;
+        entry.port = index - 1;
+        ok = fwrite(&entry, sizeof entry, 1, fp) == 1;
+        header.n_entries++;
+    }
+    shash_destroy(&ports);
+
+    header.names_size = names.length;
+    ok = ok && (!names.length
+                || fwrite(names.string, names.length, 1, fp) == 1);
+    ds_destroy(&names);
+
+    ok = ok && !fseek(fp, 0, SEEK_SET)
+         && fwrite(&header, sizeof header, 1, fp) == 1;
+    ok = !fclose(fp) && ok;
+    if (!ok || rename(tmp, path)) {
+        vty_out(vty, "Unable to write snapshot %s: %s%s", name,
+                ovs_strerror(errno), VTY_NEWLINE);
+        unlink(tmp);
+        free(tmp);
+        free(path);
+        return CMD_WARNING;
+    }
+
+    vty_out(vty, "Saved %u MAC addresses to snapshot %s.%s",
+            header.n_entries, name, VTY_NEWLINE);
+    free(tmp);
+    free(path);
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_read_ports
+ | Responsibility: read the port names of a snapshot, leaving the file
+ |                 positioned on the first entry
+ | Parameters:
+ |      fp : snapshot file
+ |      header : snapshot header
+ |      names : port names block, to free
+ | Return:
+ |      array of header->n_ports names, to free, NULL if the names are not
+ |      valid
+ ------------------------------------------------------------------------------
+ */
+static const char **
+mac_snapshot_read_ports(FILE *fp, const struct mac_snapshot_header *header,
+                        char **names)
+{
+    const char **ports;
+    uint32_t i;
+    char *p;
+
+    *names = NULL;
+    if (header->names_size > MAC_SNAPSHOT_NAMES_MAX
+        || header->n_ports > header->names_size
+        || (header->names_size && !header->n_ports)) {
+        return NULL;
+    }
+
+    *names = xmalloc(header->names_size + 1);
+    if (fseek(fp, sizeof *header
+                  + (long)header->n_entries * header->entry_size, SEEK_SET)
+        || (header->names_size
+            && fread(*names, header->names_size, 1, fp) != 1)
+        || fseek(fp, sizeof *header, SEEK_SET)) {
+        return NULL;
+    }
+    (*names)[header->names_size] = '\0';
+
+    ports = xcalloc(MAX(1, header->n_ports), sizeof *ports);
+    for (i = 0, p = *names; i < header->n_ports; i++) {
+        if (p >= *names + header->names_size) {
+            free(ports);
+            return NULL;
+        }
+        ports[i] = p;
+        p += strlen(p) + 1;
+    }
+    return ports;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_print
+ | Responsibility: print one difference against a snapshot
+ | Parameters:
+ |      event : "+" new, "-" gone, "~" moved
+ |      item : snapshot item
+ |      old_port : port in the snapshot for moved entries, NULL otherwise
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_snapshot_print(const char *event, const struct mac_snapshot_item *item,
+                   const char *old_port)
+{
+    vty_out(vty, "%s "ETH_ADDR_FMT"    vlan %-5u port %s%s%s%s",
+            event, ETH_ADDR_ARGS(item->mac), item->vlan,
+            old_port ? old_port : "", old_port ? " -> " : "", item->port,
+            VTY_NEWLINE);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_diff
+ | Responsibility: Display the mac table changes since a snapshot, merging
+ |                 the sorted snapshot with the (mac, vlan) index
+ | Parameters:
+ |      name : snapshot name
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_snapshot_diff(const char *name)
+{
+    struct mac_snapshot_entry batch[MAC_SNAPSHOT_BATCH];
+    struct mac_snapshot_item live, saved;
+    struct mac_snapshot_header header;
+    const struct ovsrec_mac *row;
+    const char **ports = NULL;
+    size_t n_batch = 0, pos = 0;
+    uint32_t n_read = 0;
+    unsigned int added = 0, removed = 0, moved = 0, same = 0;
+    bool have_live, have_saved = false;
+    char *names = NULL;
+    char *path;
+    FILE *fp;
+
+    path = mac_snapshot_path(name);
+    if (!path) {
+        vty_out(vty, "Invalid snapshot name %s.%s", name, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+    fp = fopen(path, "rb");
+    free(path);
+    if (!fp) {
+        vty_out(vty, "Snapshot %s not found.%s", name, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+    if (fread(&header, sizeof header, 1, fp) != 1
+        || header.magic != MAC_SNAPSHOT_MAGIC
+        || header.version != MAC_SNAPSHOT_VERSION
+        || header.entry_size != sizeof batch[0]
+        || !(ports = mac_snapshot_read_ports(fp, &header, &names))) {
+        vty_out(vty, "Snapshot %s is not valid.%s", name, VTY_NEWLINE);
+        free(names);
+        fclose(fp);
+        return CMD_WARNING;
+    }
+
+    ovsdb_idl_run(idl);
+
+    row = ovsrec_mac_index_first(&vlan_cursor);
+    have_live = mac_snapshot_next_live(&row, &live);
+    for (;;) {
+        int cmp;
+
+        while (!have_saved && n_read < header.n_entries) {
+            const struct mac_snapshot_entry *entry;
+
+            if (pos == n_batch) {
+                n_batch = fread(batch, sizeof batch[0],
+                                MIN(MAC_SNAPSHOT_BATCH,
+                                    header.n_entries - n_read), fp);
+                pos = 0;
+            }
+            if (pos == n_batch) {
+                /* truncated file, report what could be read */
+                n_read = header.n_entries;
+                break;
+            }
+            entry = &batch[pos++];
+            n_read++;
+            if (entry->port >= header.n_ports) {
+                continue;
+            }
+            memcpy(saved.mac.ea, entry->mac, sizeof saved.mac.ea);
+            saved.vlan = entry->vlan;
+            saved.port = ports[entry->port];
+            have_saved = true;
+        }
+        if (!have_live && !have_saved) {
+            break;
+        }
+
+        cmp = (!have_live ? 1 : !have_saved ? -1
+               : mac_snapshot_cmp(&live, &saved));
+        if (cmp < 0) {
+            mac_snapshot_print("+", &live, NULL);
+            added++;
+        } else if (cmp > 0) {
+            mac_snapshot_print("-", &saved, NULL);
+            removed++;
+        } else if (strcmp(live.port, saved.port)) {
+            mac_snapshot_print("~", &live, saved.port);
+            moved++;
+        } else {
+            same++;
+        }
+
+        if (cmp <= 0) {
+            have_live = mac_snapshot_next_live(&row, &live);
+        }
+        if (cmp >= 0) {
+            have_saved = false;
+        }
+    }
+    fclose(fp);
+    free(ports);
+    free(names);
+
+    vty_out(vty, "%sSnapshot %s taken %lld seconds ago: %u added, "
+            "%u removed, %u moved, %u unchanged%s", VTY_NEWLINE, name,
+            (time_wall_msec() - header.time_msec) / 1000, added, removed,
+            moved, same, VTY_NEWLINE);
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_snapshot_delete
+ | Responsibility: delete a named snapshot
+ | Parameters:
+ |      name : snapshot name
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_snapshot_delete(const char *name)
+{
+    char *path = mac_snapshot_path(name);
+    int rc = CMD_SUCCESS;
+
+    if (!path || unlink(path)) {
+        vty_out(vty, "Snapshot %s not found.%s", name, VTY_NEWLINE);
+        rc = CMD_WARNING;
+    }
+    free(path);
+    return rc;
+}
+
+/* Flush requests of one "clear mac-address-table" command, written to
+ * the Port and VLAN tables in a single transaction. */
+struct mac_clear {
+    struct hmapx ports;         /* "struct ovsrec_port"s to flush. */
+    struct shash port_vlans;    /* Port name -> "struct mac_clear_port". */
+    unsigned long *vlans;       /* VLANs to flush. */
+};
+
+struct mac_clear_port {
+    const struct ovsrec_port *port;
+    unsigned long *vlans;       /* VLANs to flush on this port only. */
+};
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_init
+ | Responsibility: initialize an empty set of flush requests
+ | Parameters:
+ |      clear : flush requests
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_clear_init(struct mac_clear *clear)
+{
+    hmapx_init(&clear->ports);
+    shash_init(&clear->port_vlans);
+    clear->vlans = bitmap_allocate(VLAN_BITMAP_SIZE);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_destroy
+ | Responsibility: free a set of flush requests
+ | Parameters:
+ |      clear : flush requests
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_clear_destroy(struct mac_clear *clear)
+{
+    struct shash_node *node;
+
+    SHASH_FOR_EACH (node, &clear->port_vlans) {
+        struct mac_clear_port *cp = node->data;
+        bitmap_free(cp->vlans);
+        free(cp);
+    }
+    shash_destroy(&clear->port_vlans);
+    hmapx_destroy(&clear->ports);
+    bitmap_free(clear->vlans);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_find_port
+ | Responsibility: find a port row by name
+ | Parameters:
+ |      name : port name
+ | Return:
+ |      port row, NULL if there is no such port
+ ------------------------------------------------------------------------------
+ */
+static const struct ovsrec_port *
+mac_clear_find_port(const char *name)
+{
+    const struct ovsrec_port *port_row;
+
+    OVSREC_PORT_FOR_EACH (port_row, idl) {
+        if (!strcmp(port_row->name, name)) {
+            return port_row;
+        }
+    }
+    return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_add_port_vlan
+ | Responsibility: request a flush of one VLAN on one port
+ | Parameters:
+ |      clear : flush requests
+ |      port_row : port row
+ |      vlan : VLAN id
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_clear_add_port_vlan(struct mac_clear *clear,
+                        const struct ovsrec_port *port_row, int vlan)
+{
+    struct mac_clear_port *cp;
+
+    if (vlan <= 0 || vlan >= VLAN_BITMAP_SIZE) {
+        return;
+    }
+    cp = shash_find_data(&clear->port_vlans, port_row->name);
+    if (!cp) {
+        cp = xzalloc(sizeof *cp);
+        cp->port = port_row;
+        cp->vlans = bitmap_allocate(VLAN_BITMAP_SIZE);
+        shash_add(&clear->port_vlans, port_row->name, cp);
+    }
+    bitmap_set1(cp->vlans, vlan);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_add_ports
+ | Responsibility: request a flush of a list of ports
+ | Parameters:
+ |      clear : flush requests
+ |      port_list : list of ports, NULL for all the ports
+ | Return:
+ |      CMD_SUCCESS if at least one port is valid
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_clear_add_ports(struct mac_clear *clear, const char *port_list)
+{
+    const struct ovsrec_port *port_row;
+    struct range_list *list, *list_temp;
+
+    if (port_list == NULL) {
+        OVSREC_PORT_FOR_EACH (port_row, idl) {
+            hmapx_add(&clear->ports, (void *) port_row);
+        }
+        return CMD_SUCCESS;
+    }
+
+    list = cmd_get_range_value(port_list, 1);
+    if (list == NULL) {
+        return CMD_ERR_NO_MATCH;
+    }
+    for (list_temp = list; list_temp != NULL; list_temp = list_temp->link) {
+        port_row = mac_clear_find_port(list_temp->value);
+        if (port_row) {
+            hmapx_add(&clear->ports, (void *) port_row);
+        } else {
+            vty_out(vty, "Port %s not found.%s", list_temp->value,
+                    VTY_NEWLINE);
+        }
+    }
+    cmd_free_memory_range_list(list);
+
+    return hmapx_is_empty(&clear->ports) ? CMD_WARNING : CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_add_vlans
+ | Responsibility: request a flush of a list of VLANs
+ | Parameters:
+ |      clear : flush requests
+ |      vlan_list : list of VLANs
+ | Return:
+ |      CMD_SUCCESS if the list is valid
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_clear_add_vlans(struct mac_clear *clear, const char *vlan_list)
+{
+    struct range_list *list, *list_temp;
+
+    list = cmd_get_range_value(vlan_list, 0);
+    if (list == NULL) {
+        return CMD_ERR_NO_MATCH;
+    }
+    for (list_temp = list; list_temp != NULL; list_temp = list_temp->link) {
+        int vlan_id = atoi(list_temp->value);
+        if (vlan_id > 0 && vlan_id < VLAN_BITMAP_SIZE) {
+            bitmap_set1(clear->vlans, vlan_id);
+        }
+    }
+    cmd_free_memory_range_list(list);
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_add_address
+ | Responsibility: request a flush of the (port, VLAN)s where a mac address
+ |                 is learnt
+ | Parameters:
+ |      clear : flush requests
+ |      mac : mac address
+ | Return:
+ |      CMD_SUCCESS if the address is in the mac table
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_clear_add_address(struct mac_clear *clear, const char *mac)
+{
+    struct mactable_filter filter = { .mac = mac };
+    const struct ovsrec_mac *row;
+
+    MACTABLE_FOR_EACH_MATCH (row, &filter) {
+        mac_clear_add_port_vlan(clear, row->port, mac_row_vlan(row));
+    }
+
+    if (shash_is_empty(&clear->port_vlans)) {
+        vty_out(vty, "MAC address %s not found.%s", mac, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_clear_commit
+ | Responsibility: write all the flush requests in one transaction
+ | Parameters:
+ |      clear : flush requests
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_clear_commit(struct mac_clear *clear)
+{
+    const struct ovsrec_vlan *vlan_row;
+    enum ovsdb_idl_txn_status status;
+    struct ovsdb_idl_txn *txn;
+    struct hmapx_node *pnode;
+    struct shash_node *node;
+    bool mac_invalid = true;
+
+    txn = cli_do_config_start();
+    if (txn == NULL) {
+        VLOG_ERR("%s: unable to create transaction", __FUNCTION__);
+        return CMD_OVSDB_FAILURE;
+    }
+
+    HMAPX_FOR_EACH (pnode, &clear->ports) {
+        ovsrec_port_set_macs_invalid(pnode->data, &mac_invalid, 1);
+    }
+
+    SHASH_FOR_EACH (node, &clear->port_vlans) {
+        struct mac_clear_port *cp = node->data;
+        int64_t *vlans;
+        size_t n = 0, i;
+        size_t vid;
+
+        /* keep the requests switchd has not handled yet */
+        for (i = 0; i < cp->port->n_macs_invalid_on_vlans; i++) {
+            int64_t pending = cp->port->macs_invalid_on_vlans[i];
+            if (pending > 0 && pending < VLAN_BITMAP_SIZE) {
+                bitmap_set1(cp->vlans, pending);
+            }
+        }
+        vlans = xmalloc(bitmap_count1(cp->vlans, VLAN_BITMAP_SIZE)
+                        * sizeof *vlans);
+        BITMAP_FOR_EACH_1 (vid, VLAN_BITMAP_SIZE, cp->vlans) {
+            vlans[n++] = vid;
+        }
+        ovsrec_port_verify_macs_invalid_on_vlans(cp->port);
+        ovsrec_port_set_macs_invalid_on_vlans(cp->port, vlans, n);
+        free(vlans);
+    }
+
+    if (!bitmap_is_all_zeros(clear->vlans, VLAN_BITMAP_SIZE)) {
+        OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+            if (vlan_row->id > 0 && vlan_row->id < VLAN_BITMAP_SIZE
+                && bitmap_is_set(clear->vlans, vlan_row->id)) {
+                ovsrec_vlan_set_macs_invalid(vlan_row, &mac_invalid, 1);
+            }
+        }
+    }
+
+    status = cli_do_config_finish(txn);
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        vty_out(vty, "Unable to clear the MAC address table (%s).%s",
+                ovsdb_idl_txn_status_to_string(status), VTY_NEWLINE);
+        return CMD_OVSDB_FAILURE;
+    }
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mactable_clear
+ | Responsibility: Flush a slice of the mac table
+ | Parameters:
+ |      port_list : list of ports, NULL for any
+ |      vlan_list : list of VLANs, NULL for any
+ |      mac : mac address, NULL for any
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mactable_clear(const char *port_list, const char *vlan_list, const char *mac)
+{
+    struct mac_clear clear;
+    int rc = CMD_SUCCESS;
+
+    ovsdb_idl_run (idl);
+
+    mac_clear_init(&clear);
+    if (mac != NULL) {
+        rc = mac_clear_add_address(&clear, mac);
+    } else if (vlan_list != NULL && port_list != NULL) {
+        const struct ovsrec_port *port_row = mac_clear_find_port(port_list);
+
+        if (port_row) {
+            mac_clear_add_port_vlan(&clear, port_row, atoi(vlan_list));
+        } else {
+            vty_out(vty, "Port %s not found.%s", port_list, VTY_NEWLINE);
+            rc = CMD_WARNING;
+        }
+    } else if (vlan_list != NULL) {
+        rc = mac_clear_add_vlans(&clear, vlan_list);
+    } else {
+        rc = mac_clear_add_ports(&clear, port_list);
+    }
+
+    if (rc == CMD_SUCCESS) {
+        rc = mac_clear_commit(&clear);
+    }
+    mac_clear_destroy(&clear);
+
+    return rc;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_find_vlan
+ | Responsibility: find a VLAN row by id
+ | Parameters:
+ |      vid : VLAN id
+ | Return:
+ |      VLAN row, NULL if there is no such VLAN
+ ------------------------------------------------------------------------------
+ */
+static const struct ovsrec_vlan *
+mac_age_find_vlan(int vid)
+{
+    const struct ovsrec_vlan *vlan_row;
+
+    OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+        if (vlan_row->id == vid) {
+            return vlan_row;
+        }
+    }
+    return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_other_config_set
+ | Responsibility: set or remove a key of the System, a VLAN or a port
+ |                 other_config
+ | Parameters:
+ |      key : other_config key
+ |      value : new value, NULL to remove the key
+ |      vlan : VLAN id, NULL if not a VLAN setting
+ |      port : port name, NULL if not a port setting
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_other_config_set(const char *key, const char *value, const char *vlan,
+                     const char *port)
+{
+    const struct ovsrec_system *system_row = NULL;
+    const struct ovsrec_vlan *vlan_row = NULL;
+    const struct ovsrec_port *port_row = NULL;
+    enum ovsdb_idl_txn_status status;
+    struct ovsdb_idl_txn *txn;
+    struct smap other_config;
+
+    txn = cli_do_config_start();
+    if (txn == NULL) {
+        VLOG_ERR("%s: unable to create transaction", __FUNCTION__);
+        return CMD_OVSDB_FAILURE;
+    }
+
+    if (vlan != NULL) {
+        vlan_row = mac_age_find_vlan(atoi(vlan));
+        if (vlan_row == NULL) {
+            vty_out(vty, "VLAN %s not found.%s", vlan, VTY_NEWLINE);
+            cli_do_config_abort(txn);
+            return CMD_WARNING;
+        }
+        smap_clone(&other_config, &vlan_row->other_config);
+    } else if (port != NULL) {
+        port_row = mac_clear_find_port(port);
+        if (port_row == NULL) {
+            vty_out(vty, "Port %s not found.%s", port, VTY_NEWLINE);
+            cli_do_config_abort(txn);
+            return CMD_WARNING;
+        }
+        smap_clone(&other_config, &port_row->other_config);
+    } else {
+        system_row = ovsrec_system_first(idl);
+        if (system_row == NULL) {
+            cli_do_config_abort(txn);
+            return CMD_OVSDB_FAILURE;
+        }
+        smap_clone(&other_config, &system_row->other_config);
+    }
+
+    if (value != NULL) {
+        smap_replace(&other_config, key, value);
+    } else {
+        smap_remove(&other_config, key);
+    }
+
+    if (vlan_row != NULL) {
+        ovsrec_vlan_set_other_config(vlan_row, &other_config);
+    } else if (port_row != NULL) {
+        ovsrec_port_set_other_config(port_row, &other_config);
+    } else {
+        ovsrec_system_set_other_config(system_row, &other_config);
+    }
+    smap_destroy(&other_config);
+
+    status = cli_do_config_finish(txn);
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        vty_out(vty, "Unable to update the configuration (%s).%s",
+                ovsdb_idl_txn_status_to_string(status), VTY_NEWLINE);
+        return CMD_OVSDB_FAILURE;
+    }
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_time_set
+ | Responsibility: configure the system or a VLAN age-time
+ | Parameters:
+ |      age : age-time in seconds, NULL to remove the setting
+ |      vlan : VLAN id, NULL for the system age-time
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_age_time_set(const char *age, const char *vlan)
+{
+    if (age != NULL && !L2MACD_AGE_TIME_VALID(atoi(age))) {
+        vty_out(vty, "Age-time must be 0 or between %d and %d seconds.%s",
+                L2MACD_AGE_TIME_MIN, L2MACD_AGE_TIME_MAX, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    return mac_other_config_set(L2MACD_AGE_TIME_KEY, age, vlan, NULL);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_vlan_cmp
+ | Responsibility: order VLAN rows by id
+ | Parameters:
+ |      a_ : VLAN row
+ |      b_ : VLAN row
+ | Return:
+ |      <0, 0, >0 as the id of a_ is lower, equal or higher than b_
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_age_vlan_cmp(const void *a_, const void *b_)
+{
+    const struct ovsrec_vlan *const *a = a_;
+    const struct ovsrec_vlan *const *b = b_;
+
+    return (*a)->id < (*b)->id ? -1 : (*a)->id > (*b)->id;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_config_vlans
+ | Responsibility: get the VLANs with a MAC table setting, ordered by id
+ | Parameters:
+ |      key : VLAN other_config key of the setting
+ |      n : number of VLANs found
+ | Return:
+ |      array of VLAN rows, to be freed by the caller
+ ------------------------------------------------------------------------------
+ */
+static const struct ovsrec_vlan **
+mac_config_vlans(const char *key, size_t *n)
+{
+    const struct ovsrec_vlan *vlan_row;
+    const struct ovsrec_vlan **vlans = NULL;
+    size_t allocated = 0;
+
+    *n = 0;
+    OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+        if (smap_get(&vlan_row->other_config, key)) {
+            if (*n >= allocated) {
+                vlans = x2nrealloc(vlans, &allocated, sizeof *vlans);
+            }
+            vlans[(*n)++] = vlan_row;
+        }
+    }
+    if (*n) {
+        qsort(vlans, *n, sizeof *vlans, mac_age_vlan_cmp);
+    }
+    return vlans;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_age_time_show
+ | Responsibility: display the system age-time and the VLAN overrides
+ | Parameters:
+ |      None
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_age_time_show(void)
+{
+    const struct ovsrec_vlan **vlans;
+    size_t n, i;
+
+    vty_out(vty, "MAC age-time            : %d seconds%s",
+            mac_age_time_get(NULL), VTY_NEWLINE);
+
+    vlans = mac_config_vlans(L2MACD_AGE_TIME_KEY, &n);
+    if (n) {
+        vty_out(vty, "%s%-8s %-10s%s", VTY_NEWLINE, "VLAN", "Age-time",
+                VTY_NEWLINE);
+        vty_out(vty, "-------------------%s", VTY_NEWLINE);
+        for (i = 0; i < n; i++) {
+            vty_out(vty, "%-8"PRId64" %-10d%s", vlans[i]->id,
+                    mac_age_time_get(vlans[i]), VTY_NEWLINE);
+        }
+    }
+    free(vlans);
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_limit_show_row
+ | Responsibility: display the MAC limit of a port or a VLAN
+ | Parameters:
+ |      scope : "port" or "vlan"
+ |      name : port name or VLAN id
+ |      other_config : port or VLAN other_config
+ |      status : port or VLAN status
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_limit_show_row(const char *scope, const char *name,
+                   const struct smap *other_config, const struct smap *status)
+{
+    const char *limit = smap_get(other_config, L2MACD_MAC_LIMIT_KEY);
+    const char *violations = smap_get(status, "mac_limit_violations");
+
+    if (limit == NULL && violations == NULL) {
+        return;
+    }
+
+    vty_out(vty, "%-6s %-12s %-8s %-11s %s%s", scope, name,
+            limit ? limit : "-", violations ? violations : "0",
+            smap_get_bool(status, "mac_limit_exceeded", false)
+            ? "exceeded" : "ok", VTY_NEWLINE);
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_limit_show
+ | Responsibility: display the port and VLAN MAC limits with the states
+ |                 published by ops-l2macd
+ | Parameters:
+ |      None
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_limit_show(void)
+{
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+    char vid[16];
+
+    vty_out(vty, "%-6s %-12s %-8s %-11s %s%s", "Scope", "Name", "Limit",
+            "Violations", "State", VTY_NEWLINE);
+    vty_out(vty, "------------------------------------------------%s",
+            VTY_NEWLINE);
+
+    OVSREC_PORT_FOR_EACH (port_row, idl) {
+        mac_limit_show_row("port", port_row->name, &port_row->other_config,
+                           &port_row->status);
+    }
+    OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+        snprintf(vid, sizeof vid, "%"PRId64, vlan_row->id);
+        mac_limit_show_row("vlan", vid, &vlan_row->other_config,
+                           &vlan_row->status);
+    }
+
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_watermark_set
+ | Responsibility: configure a MAC table watermark, kept above the low one
+ |                 or under the high one
+ | Parameters:
+ |      key : L2MACD_MAC_HIGH_WATERMARK_KEY or L2MACD_MAC_LOW_WATERMARK_KEY
+ |      pct : percent of the capacity, NULL to remove the setting
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_watermark_set(const char *key, const char *pct)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    bool is_high = !strcmp(key, L2MACD_MAC_HIGH_WATERMARK_KEY);
+    int high = L2MACD_MAC_HIGH_WATERMARK;
+    int low = L2MACD_MAC_LOW_WATERMARK;
+
+    if (system_row != NULL) {
+        high = smap_get_int(&system_row->other_config,
+                            L2MACD_MAC_HIGH_WATERMARK_KEY, high);
+        low = smap_get_int(&system_row->other_config,
+                           L2MACD_MAC_LOW_WATERMARK_KEY, low);
+    }
+    if (is_high) {
+        high = pct ? atoi(pct) : L2MACD_MAC_HIGH_WATERMARK;
+    } else {
+        low = pct ? atoi(pct) : L2MACD_MAC_LOW_WATERMARK;
+    }
+
+    if (low >= high) {
+        vty_out(vty, "The low watermark (%d%%) must be under the high "
+                "watermark (%d%%).%s", low, high, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    return mac_other_config_set(key, pct, NULL, NULL);
+}
+
+/* A VLAN or a port, with the MACs learnt on it. */
+struct mac_util_entry {
+    const char *name;               /* Port name, NULL for a VLAN */
+    int64_t vid;
+    int n_macs;
+};
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_util_entry_cmp
+ | Responsibility: order VLANs or ports by decreasing number of MACs
+ | Parameters:
+ |      a_ : entry
+ |      b_ : entry
+ | Return:
+ |      <0, 0, >0 as a_ has more, as many or fewer MACs than b_
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_util_entry_cmp(const void *a_, const void *b_)
+{
+    const struct mac_util_entry *a = a_;
+    const struct mac_util_entry *b = b_;
+
+    if (a->n_macs != b->n_macs) {
+        return a->n_macs > b->n_macs ? -1 : 1;
+    }
+    if (a->name && b->name) {
+        return strcmp(a->name, b->name);
+    }
+    return a->vid < b->vid ? -1 : a->vid > b->vid;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_util_entries_show
+ | Responsibility: display VLANs or ports ordered by number of MACs
+ | Parameters:
+ |      scope : "VLAN" or "Port"
+ |      entries : VLANs or ports
+ |      n : number of entries
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_util_entries_show(const char *scope, struct mac_util_entry *entries,
+                      size_t n)
+{
+    size_t i;
+
+    if (n == 0) {
+        return;
+    }
+
+    qsort(entries, n, sizeof *entries, mac_util_entry_cmp);
+    vty_out(vty, "%s%-12s %-10s%s", VTY_NEWLINE, scope, "MACs", VTY_NEWLINE);
+    vty_out(vty, "-----------------------%s", VTY_NEWLINE);
+    for (i = 0; i < n; i++) {
+        if (entries[i].name) {
+            vty_out(vty, "%-12s %-10d%s", entries[i].name,
+                    entries[i].n_macs, VTY_NEWLINE);
+        } else {
+            vty_out(vty, "%-12"PRId64" %-10d%s", entries[i].vid,
+                    entries[i].n_macs, VTY_NEWLINE);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_utilization_show
+ | Responsibility: display the MAC table occupancy and watermark state, and
+ |                 the VLANs and ports by number of MACs, from the counters
+ |                 published by ops-l2macd rather than from the MAC rows
+ | Parameters:
+ |      None
+ | Return:
+ |      CMD_SUCCESS - Command executed successfully.
+ ------------------------------------------------------------------------------
+ */
+static int
+mac_utilization_show(void)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+    struct mac_util_entry *entries = NULL;
+    size_t n = 0, allocated = 0;
+    const struct smap *status;
+    int n_macs, capacity;
+    const char *state, *last;
+
+    if (system_row == NULL || !smap_get(&system_row->status, "mac_count")) {
+        vty_out(vty, "MAC address table utilization is not available, "
+                "ops-l2macd is not monitoring the MAC table.%s",
+                VTY_NEWLINE);
+        return CMD_SUCCESS;
+    }
+
+    status = &system_row->status;
+    n_macs = smap_get_int(status, "mac_count", 0);
+    capacity = smap_get_int(status, L2MACD_MAC_CAPACITY_KEY, 0);
+
+    vty_out(vty, "Number of MAC addresses : %d%s", n_macs, VTY_NEWLINE);
+    if (capacity > 0) {
+        vty_out(vty, "Capacity                : %d (%.1f%% used)%s",
+                capacity, n_macs * 100.0 / capacity, VTY_NEWLINE);
+        vty_out(vty, "Watermarks              : high %d%%, low %d%%%s",
+                smap_get_int(status, L2MACD_MAC_HIGH_WATERMARK_KEY,
+                             L2MACD_MAC_HIGH_WATERMARK),
+                smap_get_int(status, L2MACD_MAC_LOW_WATERMARK_KEY,
+                             L2MACD_MAC_LOW_WATERMARK), VTY_NEWLINE);
+        state = smap_get(status, "mac_watermark_state");
+        vty_out(vty, "Watermark state         : %s%s",
+                state ? state : "normal", VTY_NEWLINE);
+    } else {
+        vty_out(vty, "Capacity                : not configured%s",
+                VTY_NEWLINE);
+    }
+
+    vty_out(vty, "Watermark crossings     : %d",
+            smap_get_int(status, "mac_watermark_crossings", 0));
+    last = smap_get(status, "mac_watermark_last_crossing");
+    if (last) {
+        time_t when = strtoll(last, NULL, 10);
+        char stamp[32];
+        struct tm tm;
+
+        strftime(stamp, sizeof stamp, "%Y-%m-%d %H:%M:%S",
+                 localtime_r(&when, &tm));
+        vty_out(vty, ", last at %s", stamp);
+    }
+    vty_out(vty, "%s", VTY_NEWLINE);
+
+    OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+        int count = smap_get_int(&vlan_row->status, "mac_count", 0);
+
+        if (count > 0) {
+            if (n >= allocated) {
+                entries = x2nrealloc(entries, &allocated, sizeof *entries);
+            }
+            entries[n].name = NULL;
+            entries[n].vid = vlan_row->id;
+            entries[n++].n_macs = count;
+        }
+    }
+    mac_util_entries_show("VLAN", entries, n);
+
+    n = 0;
+    OVSREC_PORT_FOR_EACH (port_row, idl) {
+        int count = smap_get_int(&port_row->status, "mac_count", 0);
+
+        if (count > 0) {
+            if (n >= allocated) {
+                entries = x2nrealloc(entries, &allocated, sizeof *entries);
+            }
+            entries[n].name = port_row->name;
+            entries[n].vid = 0;
+            entries[n++].n_macs = count;
+        }
+    }
+    mac_util_entries_show("Port", entries, n);
+    free(entries);
+
+    return CMD_SUCCESS;
+}
+
+DEFUN (cli_mactable_capacity,
+       cli_mactable_capacity_cmd,
+       "mac-address-table capacity <1-1048576>",
+       MAC_TABLE_STR
+       MAC_CAPACITY_STR
+       MAC_LIMIT_COUNT_STR)
+{
+    return mac_other_config_set(L2MACD_MAC_CAPACITY_KEY, argv[0], NULL, NULL);
+}
+
+DEFUN (cli_no_mactable_capacity,
+       cli_no_mactable_capacity_cmd,
+       "no mac-address-table capacity",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_CAPACITY_STR)
+{
+    return mac_other_config_set(L2MACD_MAC_CAPACITY_KEY, NULL, NULL, NULL);
+}
+
+DEFUN (cli_mactable_high_watermark,
+       cli_mactable_high_watermark_cmd,
+       "mac-address-table watermark high <1-100>",
+       MAC_TABLE_STR
+       MAC_WATERMARK_STR
+       MAC_WM_HIGH_STR
+       MAC_WM_PCT_STR)
+{
+    return mac_watermark_set(L2MACD_MAC_HIGH_WATERMARK_KEY, argv[0]);
+}
+
+DEFUN (cli_no_mactable_high_watermark,
+       cli_no_mactable_high_watermark_cmd,
+       "no mac-address-table watermark high",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_WATERMARK_STR
+       MAC_WM_HIGH_STR)
+{
+    return mac_watermark_set(L2MACD_MAC_HIGH_WATERMARK_KEY, NULL);
+}
+
+DEFUN (cli_mactable_low_watermark,
+       cli_mactable_low_watermark_cmd,
+       "mac-address-table watermark low <0-99>",
+       MAC_TABLE_STR
+       MAC_WATERMARK_STR
+       MAC_WM_LOW_STR
+       MAC_WM_PCT_STR)
+{
+    return mac_watermark_set(L2MACD_MAC_LOW_WATERMARK_KEY, argv[0]);
+}
+
+DEFUN (cli_no_mactable_low_watermark,
+       cli_no_mactable_low_watermark_cmd,
+       "no mac-address-table watermark low",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_WATERMARK_STR
+       MAC_WM_LOW_STR)
+{
+    return mac_watermark_set(L2MACD_MAC_LOW_WATERMARK_KEY, NULL);
+}
+
+DEFUN (cli_mactable_utilization_show,
+       cli_mactable_utilization_show_cmd,
+       "show mac-address-table utilization",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_UTIL_STR)
+{
+    return mac_utilization_show();
+}
+
+DEFUN (cli_mactable_port_limit,
+       cli_mactable_port_limit_cmd,
+       "mac-address-table limit <1-1048576> port PORT",
+       MAC_TABLE_STR
+       MAC_LIMIT_CFG_STR
+       MAC_LIMIT_COUNT_STR
+       "Limit the MAC addresses learnt on a port\n"
+       "Port name\n")
+{
+    return mac_other_config_set(L2MACD_MAC_LIMIT_KEY, argv[0], NULL, argv[1]);
+}
+
+DEFUN (cli_no_mactable_port_limit,
+       cli_no_mactable_port_limit_cmd,
+       "no mac-address-table limit port PORT",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_LIMIT_CFG_STR
+       "Limit the MAC addresses learnt on a port\n"
+       "Port name\n")
+{
+    return mac_other_config_set(L2MACD_MAC_LIMIT_KEY, NULL, NULL, argv[0]);
+}
+
+DEFUN (cli_mactable_vlan_limit,
+       cli_mactable_vlan_limit_cmd,
+       "mac-address-table limit <1-1048576> vlan <1-4094>",
+       MAC_TABLE_STR
+       MAC_LIMIT_CFG_STR
+       MAC_LIMIT_COUNT_STR
+       "Limit the MAC addresses learnt on a VLAN\n"
+       MAC_AGE_VID_STR)
+{
+    return mac_other_config_set(L2MACD_MAC_LIMIT_KEY, argv[0], argv[1], NULL);
+}
+
+DEFUN (cli_no_mactable_vlan_limit,
+       cli_no_mactable_vlan_limit_cmd,
+       "no mac-address-table limit vlan <1-4094>",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_LIMIT_CFG_STR
+       "Limit the MAC addresses learnt on a VLAN\n"
+       MAC_AGE_VID_STR)
+{
+    return mac_other_config_set(L2MACD_MAC_LIMIT_KEY, NULL, argv[0], NULL);
+}
+
+DEFUN (cli_mactable_limits_show,
+       cli_mactable_limits_show_cmd,
+       "show mac-address-table limits",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_LIMITS_STR)
+{
+    return mac_limit_show();
+}
+
+DEFUN (cli_mactable_age_time,
+       cli_mactable_age_time_cmd,
+       "mac-address-table age-time <0-1000000>",
+       MAC_TABLE_STR
+       MAC_AGE_TIME_STR
+       MAC_AGE_SECONDS_STR)
+{
+    return mac_age_time_set(argv[0], NULL);
+}
+
+DEFUN (cli_no_mactable_age_time,
+       cli_no_mactable_age_time_cmd,
+       "no mac-address-table age-time",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_AGE_TIME_STR)
+{
+    return mac_age_time_set(NULL, NULL);
+}
+
+DEFUN (cli_mactable_vlan_age_time,
+       cli_mactable_vlan_age_time_cmd,
+       "mac-address-table age-time <0-1000000> vlan <1-4094>",
+       MAC_TABLE_STR
+       MAC_AGE_TIME_STR
+       MAC_AGE_SECONDS_STR
+       MAC_AGE_VLAN_STR
+       MAC_AGE_VID_STR)
+{
+    return mac_age_time_set(argv[0], argv[1]);
+}
+
+DEFUN (cli_no_mactable_vlan_age_time,
+       cli_no_mactable_vlan_age_time_cmd,
+       "no mac-address-table age-time vlan <1-4094>",
+       NO_STR
+       MAC_TABLE_STR
+       MAC_AGE_TIME_STR
+       MAC_AGE_VLAN_STR
+       MAC_AGE_VID_STR)
+{
+    return mac_age_time_set(NULL, argv[0]);
+}
+
+DEFUN (cli_mactable_age_time_show,
+       cli_mactable_age_time_show_cmd,
+       "show mac-address-table age-time",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_AGE_STR)
+{
+    return mac_age_time_show();
+}
+
+DEFUN (cli_mactable_show,
+       cli_mactable_show_cmd,
+       "show mac-address-table",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR)
+{
+
+    return mactable_show(NULL, NULL, NULL, false, false);
+}
+
+DEFUN (cli_mactable_show_json,
+       cli_mactable_show_json_cmd,
+       "show mac-address-table json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_JSON_STR)
+{
+
+    return mactable_show(NULL, NULL, NULL, false, true);
+}
+
+DEFUN (cli_mactable_from_show,
+       cli_mactable_from_show_cmd,
+       "show mac-address-table (dynamic)",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR)
+{
+
+    return mactable_show(argv[0], NULL, NULL, false, false);
+}
+
+DEFUN (cli_mactable_from_show_json,
+       cli_mactable_from_show_json_cmd,
+       "show mac-address-table (dynamic) json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_JSON_STR)
+{
+
+    return mactable_show(argv[0], NULL, NULL, false, true);
+}
+
+DEFUN (cli_mactable_vlan_show,
+       cli_mactable_vlan_show_cmd,
+       "show mac-address-table vlan <A:1-4094>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR)
+{
+    return mactable_vlan_show(argv[0], NULL, NULL, false, false);
+}
+
+DEFUN (cli_mactable_vlan_show_json,
+       cli_mactable_vlan_show_json_cmd,
+       "show mac-address-table vlan <A:1-4094> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_vlan_show(argv[0], NULL, NULL, false, true);
+}
+
+DEFUN (cli_mactable_port_show,
+       cli_mactable_port_show_cmd,
+       "show mac-address-table port PORTS",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR)
+{
+
+    return mactable_port_show(argv[0], NULL, NULL, false, false);
+}
+
+DEFUN (cli_mactable_port_show_json,
+       cli_mactable_port_show_json_cmd,
+       "show mac-address-table port PORTS json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_JSON_STR)
+{
+
+    return mactable_port_show(argv[0], NULL, NULL, false, true);
+}
+
+DEFUN (cli_mactable_from_vlan_show,
+       cli_mactable_from_vlan_show_cmd,
+       "show mac-address-table (dynamic) vlan <A:1-4094>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR)
+{
+    return mactable_vlan_show(argv[1], argv[0], NULL, false, false);
+}
+
+DEFUN (cli_mactable_from_vlan_show_json,
+       cli_mactable_from_vlan_show_json_cmd,
+       "show mac-address-table (dynamic) vlan <A:1-4094> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_vlan_show(argv[1], argv[0], NULL, false, true);
+}
+
+DEFUN (cli_mactable_from_port_show,
+       cli_mactable_from_port_show_cmd,
+       "show mac-address-table (dynamic) port PORTS",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR)
+{
+
+    return mactable_port_show(argv[1], argv[0], NULL, false, false);
+}
+
+DEFUN (cli_mactable_from_port_show_json,
+       cli_mactable_from_port_show_json_cmd,
+       "show mac-address-table (dynamic) port PORTS json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_JSON_STR)
+{
+
+    return mactable_port_show(argv[1], argv[0], NULL, false, true);
+}
+
+DEFUN (cli_mactable_address_show,
+       cli_mactable_address_show_cmd,
+       "show mac-address-table address A:B:C:D:E:F",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_ADDR_STR
+       "MAC address\n")
+{
+    return mactable_show(NULL, argv[0], NULL, false, false);
+}
+
+DEFUN (cli_mactable_address_show_json,
+       cli_mactable_address_show_json_cmd,
+       "show mac-address-table address A:B:C:D:E:F json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_ADDR_STR
+       "MAC address\n"
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_show(NULL, argv[0], NULL, false, true);
+}
+
+DEFUN (cli_mactable_count_show,
+       cli_mactable_count_show_cmd,
+       "show mac-address-table count",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR)
+{
+    return mactable_show(NULL, NULL, NULL, true, false);
+}
+
+DEFUN (cli_mactable_count_show_json,
+       cli_mactable_count_show_json_cmd,
+       "show mac-address-table count json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_show(NULL, NULL, NULL, true, true);
+}
+
+DEFUN (cli_mactable_dyn_count_show,
+       cli_mactable_dyn_count_show_cmd,
+       "show mac-address-table count (dynamic)",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_DYN_STR)
+{
+    return mactable_show(argv[0], NULL, NULL, true, false);
+}
+
+DEFUN (cli_mactable_dyn_count_show_json,
+       cli_mactable_dyn_count_show_json_cmd,
+       "show mac-address-table count (dynamic) json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_show(argv[0], NULL, NULL, true, true);
+}
+
+DEFUN (cli_mactable_vlan_count_show,
+       cli_mactable_vlan_count_show_cmd,
+       "show mac-address-table count vlan <A:1-4094>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR)
+{
+    return mactable_vlan_show(argv[0], NULL, NULL, true, false);
+}
+
+DEFUN (cli_mactable_vlan_count_show_json,
+       cli_mactable_vlan_count_show_json_cmd,
+       "show mac-address-table count vlan <A:1-4094> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_vlan_show(argv[0], NULL, NULL, true, true);
+}
+
+DEFUN (cli_mactable_port_count_show,
+       cli_mactable_port_count_show_cmd,
+       "show mac-address-table count port PORTS",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR)
+{
+    return mactable_port_show(argv[0], NULL, NULL, true, false);
+}
+
+DEFUN (cli_mactable_port_count_show_json,
+       cli_mactable_port_count_show_json_cmd,
+       "show mac-address-table count port PORTS json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       MAC_COUNT_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_port_show(argv[0], NULL, NULL, true, true);
+}
+
+DEFUN (cli_mactable_page_show,
+       cli_mactable_page_show_cmd,
+       "show mac-address-table page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { NULL, NULL, argv[0] };
+
+    return mactable_show(NULL, NULL, &page, false, false);
+}
+
+DEFUN (cli_mactable_page_show_json,
+       cli_mactable_page_show_json_cmd,
+       "show mac-address-table page-size <1-100000> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { NULL, NULL, argv[0] };
+
+    return mactable_show(NULL, NULL, &page, false, true);
+}
+
+DEFUN (cli_mactable_start_show,
+       cli_mactable_start_show_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n")
+{
+    struct mactable_page page = { argv[0], NULL, NULL };
+
+    return mactable_show(NULL, NULL, &page, false, false);
+}
 
-    shash_init(&sorted_mac_addr);
+DEFUN (cli_mactable_start_show_json,
+       cli_mactable_start_show_json_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { argv[0], NULL, NULL };
 
-    OVSREC_MAC_FOR_EACH_BYINDEX (row, &cursor)
-    {
-        if (mac_from != NULL && ((strcmp(row->from, mac_from) != 0)))
-        {
-            continue;
-        }
+    return mactable_show(NULL, NULL, &page, false, true);
+}
 
-        while (list != NULL)
-        {
-            int vlan_id = atoi(list->value);
-            if (row->port &&
-                ops_mac_get_vlan(row) == vlan_id)
-            {
-                shash_add(&sorted_mac_addr, row->mac_addr, (void *)row);
-                break;
-            }
-            else
-            {
-                list = list->link;
-            }
-        }
-        list = list_temp;
-    }
-    nodes = shash_sort(&sorted_mac_addr);
-    count = shash_count(&sorted_mac_addr);
+DEFUN (cli_mactable_start_page_show,
+       cli_mactable_start_page_show_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { argv[0], NULL, argv[1] };
 
-    if (show_count)
-    {
-        DISPLAY_MACTABLE_COUNT(count);
-    }
-    else
-    {
-        print_mactable(nodes, count);
-    }
+    return mactable_show(NULL, NULL, &page, false, false);
+}
 
-    shash_destroy(&sorted_mac_addr);
-    if (nodes != NULL)
-        free(nodes);
+DEFUN (cli_mactable_start_page_show_json,
+       cli_mactable_start_page_show_json_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F page-size <1-100000> "
+       "json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { argv[0], NULL, argv[1] };
 
-    return CMD_SUCCESS;
+    return mactable_show(NULL, NULL, &page, false, true);
+}
+
+DEFUN (cli_mactable_start_vlan_show,
+       cli_mactable_start_vlan_show_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F vlan <1-4094>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n")
+{
+    struct mactable_page page = { argv[0], argv[1], NULL };
 
+    return mactable_show(NULL, NULL, &page, false, false);
 }
 
-/*-----------------------------------------------------------------------------
- | Function: mactable_port_show
- | Responsibility: Display mac entries based on filters applied
- | Parameters:
- |      port_list : list of ports
- |      from : ogirin of the mac
- | Return:
- |      CMD_SUCCESS - Command executed successfully.
- ------------------------------------------------------------------------------
- */
-static int
-mactable_port_show(const char *port_list, const char *mac_from, bool show_count)
+DEFUN (cli_mactable_start_vlan_show_json,
+       cli_mactable_start_vlan_show_json_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F vlan <1-4094> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_JSON_STR)
 {
-    const struct ovsrec_mac *row = NULL;
-    struct shash sorted_mac_addr;
-    const struct shash_node **nodes;
-    int count = 0;
-    struct range_list *list, *list_temp = NULL;
+    struct mactable_page page = { argv[0], argv[1], NULL };
 
-    ovsdb_idl_run (idl);
+    return mactable_show(NULL, NULL, &page, false, true);
+}
 
-    row = ovsrec_mac_first (idl);
-    if (!row)
-    {
-        vty_out (vty, "No MAC entries found.%s", VTY_NEWLINE);
-        return CMD_SUCCESS;
-    }
+DEFUN (cli_mactable_start_vlan_page_show,
+       cli_mactable_start_vlan_page_show_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F vlan <1-4094> "
+       "page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { argv[0], argv[1], argv[2] };
 
-    /* get the ports in a link list */
-    list = list_temp = cmd_get_range_value(port_list, 1);
+    return mactable_show(NULL, NULL, &page, false, false);
+}
 
-    if (list == NULL)
-    {
-        return CMD_ERR_NO_MATCH;
-    }
+DEFUN (cli_mactable_start_vlan_page_show_json,
+       cli_mactable_start_vlan_page_show_json_cmd,
+       "show mac-address-table start-after A:B:C:D:E:F vlan <1-4094> "
+       "page-size <1-100000> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { argv[0], argv[1], argv[2] };
 
-    shash_init(&sorted_mac_addr);
+    return mactable_show(NULL, NULL, &page, false, true);
+}
 
-    OVSREC_MAC_FOR_EACH_BYINDEX (row, &cursor)
-    {
-        if (mac_from != NULL && ((strcmp(row->from, mac_from) != 0)))
-        {
-            continue;
-        }
+DEFUN (cli_mactable_vlan_page_show,
+       cli_mactable_vlan_page_show_cmd,
+       "show mac-address-table vlan <A:1-4094> page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { NULL, NULL, argv[1] };
 
-        while (list != NULL)
-        {
+    return mactable_vlan_show(argv[0], NULL, &page, false, false);
+}
 
-            if (row->port &&
-                (strcmp(list->value, row->port->name)) == 0)
-            {
-                shash_add(&sorted_mac_addr, row->mac_addr, (void *)row);
-                break;
-            }
-            else
-            {
-                list = list->link;
-            }
-        }
-        list = list_temp;
-    }
+DEFUN (cli_mactable_vlan_page_show_json,
+       cli_mactable_vlan_page_show_json_cmd,
+       "show mac-address-table vlan <A:1-4094> page-size <1-100000> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { NULL, NULL, argv[1] };
 
-    nodes = shash_sort(&sorted_mac_addr);
-    count = shash_count(&sorted_mac_addr);
+    return mactable_vlan_show(argv[0], NULL, &page, false, true);
+}
 
-    if (show_count)
-    {
-        DISPLAY_MACTABLE_COUNT(count);
-    }
-    else
-    {
-        print_mactable(nodes, count);
-    }
+DEFUN (cli_mactable_vlan_start_page_show,
+       cli_mactable_vlan_start_page_show_cmd,
+       "show mac-address-table vlan <A:1-4094> "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
 
-    shash_destroy(&sorted_mac_addr);
-    if (nodes != NULL)
-        free(nodes);
+    return mactable_vlan_show(argv[0], NULL, &page, false, false);
+}
 
-    return CMD_SUCCESS;
+DEFUN (cli_mactable_vlan_start_page_show_json,
+       cli_mactable_vlan_start_page_show_json_cmd,
+       "show mac-address-table vlan <A:1-4094> "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_VLAN_STR
+       MAC_VLAN_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
+{
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
 
+    return mactable_vlan_show(argv[0], NULL, &page, false, true);
 }
 
-DEFUN (cli_mactable_show,
-       cli_mactable_show_cmd,
-       "show mac-address-table",
+DEFUN (cli_mactable_port_page_show,
+       cli_mactable_port_page_show_cmd,
+       "show mac-address-table port PORTS page-size <1-100000>",
        SHOW_STR
-       SHOW_MAC_TABLE_STR)
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
 {
+    struct mactable_page page = { NULL, NULL, argv[1] };
 
-    return mactable_show(NULL, NULL, false);
+    return mactable_port_show(argv[0], NULL, &page, false, false);
 }
 
-DEFUN (cli_mactable_from_show,
-       cli_mactable_from_show_cmd,
-       "show mac-address-table (dynamic)",
+DEFUN (cli_mactable_port_page_show_json,
+       cli_mactable_port_page_show_json_cmd,
+       "show mac-address-table port PORTS page-size <1-100000> json",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       SHOW_MAC_DYN_STR)
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
 {
+    struct mactable_page page = { NULL, NULL, argv[1] };
 
-    return mactable_show(argv[0], NULL, false);
+    return mactable_port_show(argv[0], NULL, &page, false, true);
 }
 
-DEFUN (cli_mactable_vlan_show,
-       cli_mactable_vlan_show_cmd,
-       "show mac-address-table vlan <A:1-4094>",
+DEFUN (cli_mactable_port_start_page_show,
+       cli_mactable_port_start_page_show_cmd,
+       "show mac-address-table port PORTS "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000>",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       SHOW_MAC_VLAN_STR
-       MAC_VLAN_STR)
+       SHOW_MAC_PORT_STR
+       MAC_PORT_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
 {
-    return mactable_vlan_show(argv[0], NULL, false);
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
+
+    return mactable_port_show(argv[0], NULL, &page, false, false);
 }
 
-DEFUN (cli_mactable_port_show,
-       cli_mactable_port_show_cmd,
-       "show mac-address-table port PORTS",
+DEFUN (cli_mactable_port_start_page_show_json,
+       cli_mactable_port_start_page_show_json_cmd,
+       "show mac-address-table port PORTS "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000> json",
        SHOW_STR
        SHOW_MAC_TABLE_STR
        SHOW_MAC_PORT_STR
-       MAC_PORT_STR)
+       MAC_PORT_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
 {
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
 
-    return mactable_port_show(argv[0], NULL, false);
+    return mactable_port_show(argv[0], NULL, &page, false, true);
 }
 
+DEFUN (cli_mactable_from_page_show,
+       cli_mactable_from_page_show_cmd,
+       "show mac-address-table (dynamic) page-size <1-100000>",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
+{
+    struct mactable_page page = { NULL, NULL, argv[1] };
+
+    return mactable_show(argv[0], NULL, &page, false, false);
+}
 
-DEFUN (cli_mactable_from_vlan_show,
-       cli_mactable_from_vlan_show_cmd,
-       "show mac-address-table (dynamic) vlan <A:1-4094>",
+DEFUN (cli_mactable_from_page_show_json,
+       cli_mactable_from_page_show_json_cmd,
+       "show mac-address-table (dynamic) page-size <1-100000> json",
        SHOW_STR
        SHOW_MAC_TABLE_STR
        SHOW_MAC_DYN_STR
-       SHOW_MAC_VLAN_STR
-       MAC_VLAN_STR)
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
 {
-    return mactable_vlan_show(argv[1], argv[0], false);
+    struct mactable_page page = { NULL, NULL, argv[1] };
+
+    return mactable_show(argv[0], NULL, &page, false, true);
 }
 
-DEFUN (cli_mactable_from_port_show,
-       cli_mactable_from_port_show_cmd,
-       "show mac-address-table (dynamic) port PORTS",
+DEFUN (cli_mactable_from_start_page_show,
+       cli_mactable_from_start_page_show_cmd,
+       "show mac-address-table (dynamic) "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000>",
        SHOW_STR
        SHOW_MAC_TABLE_STR
        SHOW_MAC_DYN_STR
-       SHOW_MAC_PORT_STR
-       MAC_PORT_STR)
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR)
 {
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
 
-    return mactable_port_show(argv[1], argv[0], false);
+    return mactable_show(argv[0], NULL, &page, false, false);
 }
 
-DEFUN (cli_mactable_address_show,
-       cli_mactable_address_show_cmd,
-       "show mac-address-table address A:B:C:D:E:F",
+DEFUN (cli_mactable_from_start_page_show_json,
+       cli_mactable_from_start_page_show_json_cmd,
+       "show mac-address-table (dynamic) "
+       "start-after A:B:C:D:E:F vlan <1-4094> page-size <1-100000> json",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       SHOW_MAC_ADDR_STR
-       "MAC address\n")
+       SHOW_MAC_DYN_STR
+       SHOW_MAC_START_STR
+       "MAC address\n"
+       MAC_START_VLAN_STR
+       "VLAN identifier\n"
+       SHOW_MAC_PAGE_STR
+       MAC_PAGE_SIZE_STR
+       SHOW_MAC_JSON_STR)
 {
-    return mactable_show(NULL, argv[0], false);
+    struct mactable_page page = { argv[1], argv[2], argv[3] };
+
+    return mactable_show(argv[0], NULL, &page, false, true);
 }
 
-DEFUN (cli_mactable_count_show,
-       cli_mactable_count_show_cmd,
-       "show mac-address-table count",
+DEFUN (cli_mactable_watch,
+       cli_mactable_watch_cmd,
+       "show mac-address-table watch",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       MAC_COUNT_STR)
+       SHOW_MAC_WATCH_STR)
 {
-    return mactable_show(NULL, NULL, true);
+    return mactable_watch(NULL, NULL);
 }
 
-DEFUN (cli_mactable_dyn_count_show,
-       cli_mactable_dyn_count_show_cmd,
-       "show mac-address-table count (dynamic)",
+DEFUN (cli_mactable_vlan_watch,
+       cli_mactable_vlan_watch_cmd,
+       "show mac-address-table watch vlan <1-4094>",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       MAC_COUNT_STR
-       SHOW_MAC_DYN_STR)
+       SHOW_MAC_WATCH_STR
+       "Watch a single VLAN\n"
+       "VLAN identifier\n")
 {
-    return mactable_show(argv[0], NULL, true);
+    return mactable_watch(argv[0], NULL);
 }
 
-DEFUN (cli_mactable_vlan_count_show,
-       cli_mactable_vlan_count_show_cmd,
-       "show mac-address-table count vlan <A:1-4094>",
+DEFUN (cli_mactable_port_watch,
+       cli_mactable_port_watch_cmd,
+       "show mac-address-table watch port PORT",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       MAC_COUNT_STR
-       SHOW_MAC_VLAN_STR
-       MAC_VLAN_STR)
+       SHOW_MAC_WATCH_STR
+       "Watch a single port\n"
+       "Port name\n")
 {
-    return mactable_vlan_show(argv[0], NULL, true);
+    return mactable_watch(NULL, argv[0]);
 }
 
-DEFUN (cli_mactable_port_count_show,
-       cli_mactable_port_count_show_cmd,
-       "show mac-address-table count port PORTS",
+DEFUN (cli_mactable_diff_show,
+       cli_mactable_diff_show_cmd,
+       "show mac-address-table diff NAME",
        SHOW_STR
        SHOW_MAC_TABLE_STR
-       MAC_COUNT_STR
-       SHOW_MAC_PORT_STR
+       SHOW_MAC_DIFF_STR
+       MAC_SNAPSHOT_NAME_STR)
+{
+    return mac_snapshot_diff(argv[0]);
+}
+
+DEFUN (cli_mactable_snapshot_save,
+       cli_mactable_snapshot_save_cmd,
+       "mac-address-table snapshot save NAME",
+       MAC_TABLE_STR
+       MAC_SNAPSHOT_STR
+       "Save the current MAC address table\n"
+       MAC_SNAPSHOT_NAME_STR)
+{
+    return mac_snapshot_save(argv[0]);
+}
+
+DEFUN (cli_mactable_snapshot_delete,
+       cli_mactable_snapshot_delete_cmd,
+       "mac-address-table snapshot delete NAME",
+       MAC_TABLE_STR
+       MAC_SNAPSHOT_STR
+       "Delete a saved snapshot\n"
+       MAC_SNAPSHOT_NAME_STR)
+{
+    return mac_snapshot_delete(argv[0]);
+}
+
+DEFUN (cli_mactable_clear,
+       cli_mactable_clear_cmd,
+       "clear mac-address-table",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR)
+{
+    return mactable_clear(NULL, NULL, NULL);
+}
+
+ALIAS (cli_mactable_clear,
+       cli_mactable_dyn_clear_cmd,
+       "clear mac-address-table dynamic",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_DYN_STR)
+
+DEFUN (cli_mactable_port_clear,
+       cli_mactable_port_clear_cmd,
+       "clear mac-address-table port PORTS",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_PORT_STR
+       MAC_PORT_STR)
+{
+    return mactable_clear(argv[0], NULL, NULL);
+}
+
+ALIAS (cli_mactable_port_clear,
+       cli_mactable_dyn_port_clear_cmd,
+       "clear mac-address-table dynamic port PORTS",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_DYN_STR
+       CLEAR_MAC_PORT_STR
        MAC_PORT_STR)
+
+DEFUN (cli_mactable_vlan_clear,
+       cli_mactable_vlan_clear_cmd,
+       "clear mac-address-table vlan <A:1-4094>",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_VLAN_STR
+       MAC_VLAN_STR)
+{
+    return mactable_clear(NULL, argv[0], NULL);
+}
+
+ALIAS (cli_mactable_vlan_clear,
+       cli_mactable_dyn_vlan_clear_cmd,
+       "clear mac-address-table dynamic vlan <A:1-4094>",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_DYN_STR
+       CLEAR_MAC_VLAN_STR
+       MAC_VLAN_STR)
+
+DEFUN (cli_mactable_port_vlan_clear,
+       cli_mactable_port_vlan_clear_cmd,
+       "clear mac-address-table port PORT vlan <1-4094>",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_PORT_STR
+       "Port name\n"
+       CLEAR_MAC_VLAN_STR
+       "VLAN identifier\n")
+{
+    return mactable_clear(argv[0], argv[1], NULL);
+}
+
+ALIAS (cli_mactable_port_vlan_clear,
+       cli_mactable_dyn_port_vlan_clear_cmd,
+       "clear mac-address-table dynamic port PORT vlan <1-4094>",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_DYN_STR
+       CLEAR_MAC_PORT_STR
+       "Port name\n"
+       CLEAR_MAC_VLAN_STR
+       "VLAN identifier\n")
+
+DEFUN (cli_mactable_address_clear,
+       cli_mactable_address_clear_cmd,
+       "clear mac-address-table address A:B:C:D:E:F",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_ADDR_STR
+       "MAC address\n")
 {
-    return mactable_port_show(argv[0], NULL, true);
+    return mactable_clear(NULL, NULL, argv[0]);
 }
 
-/* will be enabled after tunnel support is added */
+ALIAS (cli_mactable_address_clear,
+       cli_mactable_dyn_address_clear_cmd,
+       "clear mac-address-table dynamic address A:B:C:D:E:F",
+       CLEAR_STR
+       CLEAR_MAC_TABLE_STR
+       CLEAR_MAC_DYN_STR
+       CLEAR_MAC_ADDR_STR
+       "MAC address\n")
+
 #ifdef HW_VTEP_SUPPORT
 DEFUN (cli_mactable_tunnel_show,
        cli_mactable_tunnel_show_cmd,
@@ -498,9 +3619,129 @@ DEFUN (cli_mactable_tunnel_show,
        SHOW_MAC_TUNNEL_STR
        "tunnel key\n")
 {
-    return mactable_tunnel_show(argv[0]);
+    return mactable_tunnel_show(argv[0], false);
+}
+
+DEFUN (cli_mactable_tunnel_show_json,
+       cli_mactable_tunnel_show_json_cmd,
+       "show mac-address-table tunnel <0-4294967295> json",
+       SHOW_STR
+       SHOW_MAC_TABLE_STR
+       SHOW_MAC_TUNNEL_STR
+       "tunnel key\n"
+       SHOW_MAC_JSON_STR)
+{
+    return mactable_tunnel_show(argv[0], true);
 }
 #endif
+/*-----------------------------------------------------------------------------
+ | Function: mac_config_print_capacity
+ | Responsibility: print the MAC table capacity and watermarks in the
+ |                 running config, in an order each command accepts when
+ |                 replayed from the defaults
+ | Parameters:
+ |      p_msg : running config callback message
+ |      other_config : System other_config
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_config_print_capacity(vtysh_ovsdb_cbmsg_ptr p_msg,
+                          const struct smap *other_config)
+{
+    const char *capacity = smap_get(other_config, L2MACD_MAC_CAPACITY_KEY);
+    const char *high = smap_get(other_config, L2MACD_MAC_HIGH_WATERMARK_KEY);
+    const char *low = smap_get(other_config, L2MACD_MAC_LOW_WATERMARK_KEY);
+
+    if (capacity != NULL) {
+        vtysh_ovsdb_cli_print(p_msg, "mac-address-table capacity %s",
+                              capacity);
+    }
+
+    /* The low watermark must stay under the high one: lower it first
+     * unless it is over the default high watermark. */
+    if (low != NULL && atoi(low) < L2MACD_MAC_HIGH_WATERMARK) {
+        vtysh_ovsdb_cli_print(p_msg, "mac-address-table watermark low %s",
+                              low);
+        low = NULL;
+    }
+    if (high != NULL) {
+        vtysh_ovsdb_cli_print(p_msg, "mac-address-table watermark high %s",
+                              high);
+    }
+    if (low != NULL) {
+        vtysh_ovsdb_cli_print(p_msg, "mac-address-table watermark low %s",
+                              low);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: vtysh_config_context_mac_table_clientcallback
+ | Responsibility: print the MAC table settings in the running config
+ | Parameters:
+ |      p_private : running config callback message
+ | Return:
+ |      e_vtysh_ok
+ ------------------------------------------------------------------------------
+ */
+static vtysh_ret_val
+vtysh_config_context_mac_table_clientcallback(void *p_private)
+{
+    vtysh_ovsdb_cbmsg_ptr p_msg = (vtysh_ovsdb_cbmsg *) p_private;
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan **vlans;
+    struct shash ports = SHASH_INITIALIZER(&ports);
+    const struct shash_node **nodes;
+    const char *value;
+    size_t n, i;
+
+    if (system_row != NULL) {
+        value = smap_get(&system_row->other_config, L2MACD_AGE_TIME_KEY);
+        if (value != NULL) {
+            vtysh_ovsdb_cli_print(p_msg, "mac-address-table age-time %s",
+                                  value);
+        }
+        mac_config_print_capacity(p_msg, &system_row->other_config);
+    }
+
+    vlans = mac_config_vlans(L2MACD_AGE_TIME_KEY, &n);
+    for (i = 0; i < n; i++) {
+        vtysh_ovsdb_cli_print(p_msg,
+                              "mac-address-table age-time %s vlan %"PRId64,
+                              smap_get(&vlans[i]->other_config,
+                                       L2MACD_AGE_TIME_KEY), vlans[i]->id);
+    }
+    free(vlans);
+
+    OVSREC_PORT_FOR_EACH (port_row, idl) {
+        if (smap_get(&port_row->other_config, L2MACD_MAC_LIMIT_KEY)) {
+            shash_add(&ports, port_row->name, port_row);
+        }
+    }
+    nodes = shash_sort(&ports);
+    for (i = 0; i < shash_count(&ports); i++) {
+        port_row = nodes[i]->data;
+        vtysh_ovsdb_cli_print(p_msg, "mac-address-table limit %s port %s",
+                              smap_get(&port_row->other_config,
+                                       L2MACD_MAC_LIMIT_KEY), port_row->name);
+    }
+    free(nodes);
+    shash_destroy(&ports);
+
+    vlans = mac_config_vlans(L2MACD_MAC_LIMIT_KEY, &n);
+    for (i = 0; i < n; i++) {
+        vtysh_ovsdb_cli_print(p_msg,
+                              "mac-address-table limit %s vlan %"PRId64,
+                              smap_get(&vlans[i]->other_config,
+                                       L2MACD_MAC_LIMIT_KEY), vlans[i]->id);
+    }
+    free(vlans);
+
+    return e_vtysh_ok;
+}
+
 /*-----------------------------------------------------------------------------
  | Function: mac_ovsdb_init
  | Responsibility: Add mac table and columns to idl cache
@@ -521,20 +3762,56 @@ mac_ovsdb_init(void)
     ovsdb_idl_add_column(idl, &ovsrec_mac_col_from);
     ovsdb_idl_add_column(idl, &ovsrec_mac_col_port);
 
+    /* Port and VLAN flush requests written by clear mac-address-table */
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_macs_invalid);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_macs_invalid_on_vlans);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_macs_invalid);
+
+    /* Age-time settings and the values in effect published by l2macd */
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_status);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_id);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_status);
+
+    /* MAC limits and the states published by l2macd */
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_status);
+
     /* Initialize Compound Indexes */
-    index = ovsdb_idl_create_index(idl, &ovsrec_table_mac, "by_macVidFrom");
+    /* (mac, vlan) ordered index used to seek pages of the mac table */
+    index = ovsdb_idl_create_index(idl, &ovsrec_table_mac, "by_macVlan");
+    if (index) {
+        ovsdb_idl_index_add_column(index, &ovsrec_mac_col_mac_addr,
+                                          OVSDB_INDEX_ASC, mac_index_mac_addr_cmp);
+        ovsdb_idl_index_add_column(index, &ovsrec_mac_col_mac_vlan,
+                                          OVSDB_INDEX_ASC, mac_index_vlan_cmp);
+    }
+    else {
+        VLOG_ERR ("%s: index creation failed", __FUNCTION__);
+        return;
+    }
+    ovsdb_idl_initialize_cursor(idl, &ovsrec_table_mac, "by_macVlan", &vlan_cursor);
+
+#ifdef HW_VTEP_SUPPORT
+    /* (tunnel key, mac, vlan) ordered index used to range scan a tunnel */
+    ovsdb_idl_add_column(idl, &ovsrec_mac_col_tunnel_key);
+    index = ovsdb_idl_create_index(idl, &ovsrec_table_mac, "by_tunnelKey");
     if (index) {
-        /* add indexing columns */
+        ovsdb_idl_index_add_column(index, &ovsrec_mac_col_tunnel_key,
+                                          OVSDB_INDEX_ASC, mac_index_tunnel_key_cmp);
         ovsdb_idl_index_add_column(index, &ovsrec_mac_col_mac_addr,
-                                          OVSDB_INDEX_ASC, ovsrec_mac_index_mac_addr_cmp);
-        ovsdb_idl_index_add_column(index, &ovsrec_mac_col_from,
-                                          OVSDB_INDEX_ASC, ovsrec_mac_index_from_cmp);
+                                          OVSDB_INDEX_ASC, mac_index_mac_addr_cmp);
+        ovsdb_idl_index_add_column(index, &ovsrec_mac_col_mac_vlan,
+                                          OVSDB_INDEX_ASC, mac_index_vlan_cmp);
     }
     else {
         VLOG_ERR ("%s: index creation failed", __FUNCTION__);
         return;
     }
-    ovsdb_idl_initialize_cursor(idl, &ovsrec_table_mac, "by_macVidFrom", &cursor);
+    ovsdb_idl_initialize_cursor(idl, &ovsrec_table_mac, "by_tunnelKey", &tunnel_cursor);
+#endif
 
     return;
 }
@@ -565,19 +3842,97 @@ void cli_pre_init(void)
  */
 void cli_post_init(void)
 {
+    vtysh_ret_val retval;
+
     install_element (ENABLE_NODE, &cli_mactable_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_vlan_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_port_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_address_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_address_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_from_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_from_vlan_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_vlan_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_from_port_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_port_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_count_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_count_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_dyn_count_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_count_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_vlan_count_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_count_show_json_cmd);
     install_element (ENABLE_NODE, &cli_mactable_port_count_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_count_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_vlan_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_vlan_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_vlan_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_start_vlan_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_start_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_start_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_start_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_start_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_start_page_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_from_start_page_show_json_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_watch_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_watch_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_watch_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_diff_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_snapshot_save_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_snapshot_delete_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_port_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_vlan_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_vlan_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_port_vlan_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_port_vlan_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_address_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_dyn_address_clear_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_age_time_show_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_age_time_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_age_time_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_vlan_age_time_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_vlan_age_time_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_limits_show_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_port_limit_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_port_limit_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_vlan_limit_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_vlan_limit_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_utilization_show_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_capacity_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_capacity_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_high_watermark_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_high_watermark_cmd);
+    install_element (CONFIG_NODE, &cli_mactable_low_watermark_cmd);
+    install_element (CONFIG_NODE, &cli_no_mactable_low_watermark_cmd);
 #ifdef HW_VTEP_SUPPORT
     install_element (ENABLE_NODE, &cli_mactable_tunnel_show_cmd);
+    install_element (ENABLE_NODE, &cli_mactable_tunnel_show_json_cmd);
 #endif
+
+    retval = install_show_run_config_subcontext(e_vtysh_config_context,
+                             e_vtysh_config_context_mac_table,
+                             &vtysh_config_context_mac_table_clientcallback,
+                             NULL, NULL);
+    if (retval != e_vtysh_ok) {
+        VLOG_ERR("%s: unable to add the mac-address-table running config "
+                 "callback", __FUNCTION__);
+    }
     return;
 }
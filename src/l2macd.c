@@ -45,6 +45,7 @@
 #include <dirs.h>
 #include <dynamic-string.h>
 #include <fatal-signal.h>
+#include <memory.h>
 #include <ovsdb-idl.h>
 #include <poll-loop.h>
 #include <unixctl.h>
@@ -55,12 +56,29 @@
 #include <openswitch-idl.h>
 #include <hash.h>
 #include <shash.h>
+#include <simap.h>
 
 #include "l2macd.h"
+#include "l2macd_checkpoint.h"
+#include "l2macd_mac.h"
+#include "l2macd_metrics.h"
+#include "l2macd_profile.h"
+#include "l2macd_warm.h"
 VLOG_DEFINE_THIS_MODULE(ops_l2macd);
 
 #define L2MACD_PID_FILE        "/var/run/openvswitch/ops-l2macd.pid"
 
+/* Cache checkpoint file, NULL when disabled. */
+static char *checkpoint_path = NULL;
+static bool checkpoint_enabled = true;
+
+/* Prometheus metrics file, NULL when not exported. */
+static char *metrics_path = NULL;
+static long long int metrics_interval = L2MACD_METRICS_INTERVAL_MSEC;
+
+/* Warm reboot MAC snapshot file, NULL when disabled. */
+static char *warm_macs_path = NULL;
+
 /*-----------------------------------------------------------------------------
  | Function: l2macd_unixctl_dump
  | Responsibility: To dump the l2macd
@@ -79,13 +97,68 @@ l2macd_unixctl_dump(struct unixctl_conn *conn, int argc OVS_UNUSED,
 {
     struct ds ds = DS_EMPTY_INITIALIZER;
 
-    /* TODO: add dump functions */
+    l2macd_profile_note(L2MACD_WAKEUP_UNIXCTL);
+    l2macd_debug_dump(&ds);
 
     unixctl_command_reply(conn, ds_cstr(&ds));
     ds_destroy(&ds);
 
 } /* l2macd_unixctl_dump */
 
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_unixctl_loop_stats
+ | Responsibility: To dump the main loop profile
+ | Parameters:
+ |      conn : unix socket to reply
+ |      argc : number of arguments
+ |      argv : arguments list
+ |      aux : auxiliary parameters
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+l2macd_unixctl_loop_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                          const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    l2macd_profile_note(L2MACD_WAKEUP_UNIXCTL);
+    l2macd_profile_dump(&ds);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+
+} /* l2macd_unixctl_loop_stats */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_unixctl_save_macs
+ | Responsibility: To save the learned MACs before a warm reboot
+ | Parameters:
+ |      conn : unix socket to reply
+ |      argc : number of arguments
+ |      argv : arguments list
+ |      aux : auxiliary parameters
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+l2macd_unixctl_save_macs(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                         const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    l2macd_profile_note(L2MACD_WAKEUP_UNIXCTL);
+    if (l2macd_warm_macs_save(&ds)) {
+        unixctl_command_reply(conn, ds_cstr(&ds));
+    } else {
+        unixctl_command_reply_error(conn, ds_cstr(&ds));
+    }
+    ds_destroy(&ds);
+
+} /* l2macd_unixctl_save_macs */
+
 /*-----------------------------------------------------------------------------
  | Function: l2macd_init
  | Responsibility: l2macd initialize function
@@ -98,14 +171,32 @@ l2macd_unixctl_dump(struct unixctl_conn *conn, int argc OVS_UNUSED,
 static void
 l2macd_init(const char *db_path)
 {
+    /* The snapshot decides of the MAC columns replicated. */
+    if (warm_macs_path) {
+        l2macd_warm_macs_init(warm_macs_path);
+    }
+
     /* Initialize IDL through a new connection to the DB. */
     l2macd_ovsdb_init(db_path);
 
     /* Initialize the global Internal cache table */
     l2macd_cache_init();
 
+    /* Warm restart from the state saved by the previous instance. */
+    if (checkpoint_path && l2macd_ckpt_open(checkpoint_path)) {
+        l2macd_cache_restore();
+    }
+
+    if (metrics_path) {
+        l2macd_metrics_init(metrics_path, metrics_interval);
+    }
+
     /* Register ovs-appctl commands for this daemon. */
     unixctl_command_register("ops-l2macd/dump", "", 0, 0, l2macd_unixctl_dump, NULL);
+    unixctl_command_register("ops-l2macd/loop-stats", "", 0, 0,
+                             l2macd_unixctl_loop_stats, NULL);
+    unixctl_command_register("ops-l2macd/save-macs", "", 0, 0,
+                             l2macd_unixctl_save_macs, NULL);
 
 } /* l2macd_init */
 
@@ -122,6 +213,11 @@ static void
 l2macd_exit(void)
 {
     l2macd_ovsdb_exit();
+    l2macd_ckpt_close();
+    free(checkpoint_path);
+    l2macd_metrics_destroy();
+    free(metrics_path);
+    free(warm_macs_path);
 
 } /* l2macd_exit */
 
@@ -135,6 +231,24 @@ usage(void)
            program_name, program_name, ovs_rundir());
     daemon_usage();
     vlog_usage();
+    printf("\nCheckpoint options:\n"
+           "  --checkpoint=FILE       cache checkpoint file\n"
+           "                          (default: %s/%s)\n"
+           "  --no-checkpoint         do not save nor restore the cache\n",
+           ovs_rundir(), L2MACD_CKPT_FILE);
+    printf("\nMetrics options:\n"
+           "  --metrics-file=FILE     write Prometheus metrics to FILE\n"
+           "  --metrics-interval=MSEC time between two writes (default: %d)\n",
+           L2MACD_METRICS_INTERVAL_MSEC);
+    printf("\nMAC options:\n"
+           "  --mac-monitor           detect MAC moves and dampen flapping "
+           "MACs\n"
+           "  --warm-macs[=FILE]      save the learned MACs on request and "
+           "hand them\n"
+           "                          to ops-switchd on boot, implies "
+           "--mac-monitor\n"
+           "                          (default: %s/%s)\n",
+           ovs_dbdir(), L2MACD_WARM_FILE);
     printf("\nOther options:\n"
            "  --unixctl=SOCKET        override default control socket name\n"
            "  -h, --help              display this help message\n");
@@ -159,12 +273,24 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
 {
     enum {
         OPT_UNIXCTL = UCHAR_MAX + 1,
+        OPT_CHECKPOINT,
+        OPT_NO_CHECKPOINT,
+        OPT_METRICS_FILE,
+        OPT_METRICS_INTERVAL,
+        OPT_MAC_MONITOR,
+        OPT_WARM_MACS,
         VLOG_OPTION_ENUMS,
         DAEMON_OPTION_ENUMS,
     };
     static const struct option long_options[] = {
         {"help",        no_argument, NULL, 'h'},
         {"unixctl",     required_argument, NULL, OPT_UNIXCTL},
+        {"checkpoint",  required_argument, NULL, OPT_CHECKPOINT},
+        {"no-checkpoint", no_argument, NULL, OPT_NO_CHECKPOINT},
+        {"metrics-file", required_argument, NULL, OPT_METRICS_FILE},
+        {"metrics-interval", required_argument, NULL, OPT_METRICS_INTERVAL},
+        {"mac-monitor", no_argument, NULL, OPT_MAC_MONITOR},
+        {"warm-macs",   optional_argument, NULL, OPT_WARM_MACS},
         DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
@@ -187,6 +313,42 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
             *unixctl_pathp = optarg;
             break;
 
+        case OPT_CHECKPOINT:
+            free(checkpoint_path);
+            checkpoint_path = xstrdup(optarg);
+            break;
+
+        case OPT_NO_CHECKPOINT:
+            checkpoint_enabled = false;
+            break;
+
+        case OPT_METRICS_FILE:
+            free(metrics_path);
+            metrics_path = xstrdup(optarg);
+            break;
+
+        case OPT_METRICS_INTERVAL:
+            metrics_interval = atoi(optarg);
+            if (metrics_interval < 1000) {
+                VLOG_FATAL("--metrics-interval must be at least 1000 ms");
+            }
+            break;
+
+        case OPT_MAC_MONITOR:
+            l2macd_mac_enable();
+            break;
+
+        case OPT_WARM_MACS:
+            /* The MAC table is replicated to save it and to leave alone the
+             * MACs learned again. */
+            l2macd_mac_enable();
+            free(warm_macs_path);
+            warm_macs_path = optarg
+                             ? xstrdup(optarg)
+                             : xasprintf("%s/%s", ovs_dbdir(),
+                                         L2MACD_WARM_FILE);
+            break;
+
         VLOG_OPTION_HANDLERS
         DAEMON_OPTION_HANDLERS
 
@@ -199,6 +361,13 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     }
     free(short_options);
 
+    if (!checkpoint_enabled) {
+        free(checkpoint_path);
+        checkpoint_path = NULL;
+    } else if (!checkpoint_path) {
+        checkpoint_path = xasprintf("%s/%s", ovs_rundir(), L2MACD_CKPT_FILE);
+    }
+
     argc -= optind;
     argv += optind;
 
@@ -231,6 +400,7 @@ l2macd_unixctl_exit(struct unixctl_conn *conn, int argc OVS_UNUSED,
 {
     bool *exiting = exiting_;
     *exiting = true;
+    l2macd_profile_note(L2MACD_WAKEUP_UNIXCTL);
     unixctl_command_reply(conn, NULL);
 
 } /* l2macd_unixctl_exit */
@@ -281,11 +451,31 @@ main(int argc, char *argv[])
 
     exiting = false;
     while (!exiting) {
+        /* Time spent out of the profiled phases is cache maintenance. */
+        l2macd_profile_enter(L2MACD_PHASE_CACHE);
         l2macd_run();
+        l2macd_metrics_run();
+        l2macd_profile_enter(L2MACD_PHASE_UNIXCTL);
         unixctl_server_run(appctl);
 
+        memory_run();
+        if (memory_should_report()) {
+            struct simap usage;
+
+            simap_init(&usage);
+            l2macd_get_memory_usage(&usage);
+            memory_report(&usage);
+            simap_destroy(&usage);
+        }
+
+        l2macd_profile_enter(L2MACD_PHASE_WAIT);
         l2macd_wait();
         unixctl_server_wait(appctl);
+        memory_wait();
+        l2macd_metrics_wait();
+        l2macd_profile_loop_end();
+
+        l2macd_profile_enter(L2MACD_PHASE_IDLE);
         if (exiting) {
             poll_immediate_wake();
         } else {
@@ -0,0 +1,300 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the memory-mapped checkpoint of the l2macd cache.
+ *
+ ****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <dynamic-string.h>
+#include <openvswitch/vlog.h>
+#include "l2macd_checkpoint.h"
+#include "l2macd_crc.h"
+#include "util.h"
+#include "timeval.h"
+
+VLOG_DEFINE_THIS_MODULE(l2macd_checkpoint);
+
+/* Layout of the checkpoint file. */
+struct l2macd_ckpt_file {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;                 /* Detects a change of the layout */
+    uint32_t reserved;
+    struct l2macd_ckpt_slot slots[2];
+};
+
+static struct l2macd_ckpt_file *ckpt_map = NULL;
+static char *ckpt_path = NULL;
+static uint64_t ckpt_writes = 0;
+
+/*-----------------------------------------------------------------------------
+ | Function: ckpt_checksum
+ | Responsibility: Compute the CRC-32C of the used part of a slot
+ | Parameters:
+ |      slot : checkpoint slot
+ | Return:
+ |      checksum
+ ------------------------------------------------------------------------------
+ */
+static uint32_t
+ckpt_checksum(const struct l2macd_ckpt_slot *slot)
+{
+    uint32_t crc;
+
+    crc = l2macd_crc32c(0, &slot->generation, sizeof slot->generation);
+    crc = l2macd_crc32c(crc, &slot->n_ports,
+                        offsetof(struct l2macd_ckpt_slot, ports)
+                        - offsetof(struct l2macd_ckpt_slot, n_ports));
+    crc = l2macd_crc32c(crc, slot->ports,
+                        slot->n_ports * sizeof slot->ports[0]);
+    return l2macd_crc32c(crc, slot->vlans,
+                         slot->n_vlans * sizeof slot->vlans[0]);
+} /* ckpt_checksum */
+
+/*-----------------------------------------------------------------------------
+ | Function: ckpt_slot_is_valid
+ | Responsibility: Check that a slot holds a complete checkpoint
+ | Parameters:
+ |      slot : checkpoint slot
+ | Return:
+ |      bool : true if the slot can be restored
+ ------------------------------------------------------------------------------
+ */
+static bool
+ckpt_slot_is_valid(const struct l2macd_ckpt_slot *slot)
+{
+    return (slot->generation != 0
+            && slot->n_ports <= L2MACD_CKPT_MAX_PORTS
+            && slot->n_vlans <= L2MACD_CKPT_MAX_VLANS
+            && slot->checksum == ckpt_checksum(slot));
+} /* ckpt_slot_is_valid */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_open
+ | Responsibility: Map the checkpoint file, creating it if needed
+ | Parameters:
+ |      path : checkpoint file path
+ | Return:
+ |      bool : true if the checkpoint file is mapped
+ ------------------------------------------------------------------------------
+ */
+bool
+l2macd_ckpt_open(const char *path)
+{
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (ckpt_map != NULL) {
+        return true;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        VLOG_WARN("%s: open failed (%s)", path, ovs_strerror(errno));
+        return false;
+    }
+
+    if (fstat(fd, &st) < 0
+        || (st.st_size != sizeof *ckpt_map
+            && ftruncate(fd, sizeof *ckpt_map) < 0)) {
+        VLOG_WARN("%s: resize failed (%s)", path, ovs_strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, sizeof *ckpt_map, PROT_READ | PROT_WRITE, MAP_SHARED,
+               fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        VLOG_WARN("%s: mmap failed (%s)", path, ovs_strerror(errno));
+        return false;
+    }
+
+    ckpt_map = map;
+    ckpt_path = xstrdup(path);
+
+    if (ckpt_map->magic != L2MACD_CKPT_MAGIC
+        || ckpt_map->version != L2MACD_CKPT_VERSION
+        || ckpt_map->slot_size != sizeof ckpt_map->slots[0]) {
+        /* New file or written by an incompatible version. */
+        if (st.st_size != 0) {
+            VLOG_INFO("%s: unknown checkpoint layout, ignoring it", path);
+        }
+        memset(ckpt_map, 0, sizeof *ckpt_map);
+        ckpt_map->magic = L2MACD_CKPT_MAGIC;
+        ckpt_map->version = L2MACD_CKPT_VERSION;
+        ckpt_map->slot_size = sizeof ckpt_map->slots[0];
+    }
+
+    return true;
+} /* l2macd_ckpt_open */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_close
+ | Responsibility: Unmap the checkpoint file
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_ckpt_close(void)
+{
+    if (ckpt_map == NULL) {
+        return;
+    }
+
+    msync(ckpt_map, sizeof *ckpt_map, MS_SYNC);
+    munmap(ckpt_map, sizeof *ckpt_map);
+    ckpt_map = NULL;
+    free(ckpt_path);
+    ckpt_path = NULL;
+} /* l2macd_ckpt_close */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_latest
+ | Responsibility: Get the latest valid checkpoint
+ | Parameters:
+ |      None
+ | Return:
+ |      checkpoint slot, NULL if there is none
+ ------------------------------------------------------------------------------
+ */
+const struct l2macd_ckpt_slot *
+l2macd_ckpt_latest(void)
+{
+    const struct l2macd_ckpt_slot *latest = NULL;
+    int i;
+
+    if (ckpt_map == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(ckpt_map->slots); i++) {
+        const struct l2macd_ckpt_slot *slot = &ckpt_map->slots[i];
+
+        if (ckpt_slot_is_valid(slot)
+            && (latest == NULL || slot->generation > latest->generation)) {
+            latest = slot;
+        }
+    }
+
+    return latest;
+} /* l2macd_ckpt_latest */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_begin
+ | Responsibility: Get an empty slot for a new checkpoint
+ | Parameters:
+ |      None
+ | Return:
+ |      checkpoint slot, NULL if the checkpoint file is not mapped
+ ------------------------------------------------------------------------------
+ */
+struct l2macd_ckpt_slot *
+l2macd_ckpt_begin(void)
+{
+    const struct l2macd_ckpt_slot *latest = l2macd_ckpt_latest();
+    struct l2macd_ckpt_slot *slot;
+
+    if (ckpt_map == NULL) {
+        return NULL;
+    }
+
+    /* Never overwrite the latest checkpoint. */
+    slot = &ckpt_map->slots[latest == &ckpt_map->slots[0] ? 1 : 0];
+    slot->generation = 0;
+    slot->n_ports = 0;
+    slot->n_vlans = 0;
+    return slot;
+} /* l2macd_ckpt_begin */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_commit
+ | Responsibility: Make a filled slot the latest checkpoint
+ | Parameters:
+ |      slot : slot returned by l2macd_ckpt_begin
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_ckpt_commit(struct l2macd_ckpt_slot *slot)
+{
+    const struct l2macd_ckpt_slot *latest = l2macd_ckpt_latest();
+
+    if (slot == NULL) {
+        return;
+    }
+
+    slot->time_msec = time_wall_msec();
+    slot->generation = latest ? latest->generation + 1 : 1;
+    slot->checksum = ckpt_checksum(slot);
+
+    /* Let the kernel write back the pages, the mapping survives a crash of
+     * the daemon and only a power loss needs the disk copy. */
+    msync(ckpt_map, sizeof *ckpt_map, MS_ASYNC);
+    ckpt_writes++;
+
+    VLOG_DBG("%s: generation %"PRIu64", %u ports, %u vlans", __FUNCTION__,
+             slot->generation, slot->n_ports, slot->n_vlans);
+} /* l2macd_ckpt_commit */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_ckpt_dump
+ | Responsibility: Append the checkpoint status to a debug dump
+ | Parameters:
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_ckpt_dump(struct ds *ds)
+{
+    const struct l2macd_ckpt_slot *latest = l2macd_ckpt_latest();
+
+    if (ckpt_map == NULL) {
+        ds_put_cstr(ds, "Checkpoint: disabled\n");
+        return;
+    }
+
+    ds_put_format(ds, "Checkpoint: %s\n", ckpt_path);
+    ds_put_format(ds, "  writes: %"PRIu64"\n", ckpt_writes);
+    if (latest) {
+        ds_put_format(ds, "  generation: %"PRIu64", %u ports, %u vlans, "
+                      "age %lld ms\n", latest->generation, latest->n_ports,
+                      latest->n_vlans, time_wall_msec() - latest->time_msec);
+    }
+} /* l2macd_ckpt_dump */
@@ -0,0 +1,56 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the checksum of the l2macd checkpoint and snapshot files.
+ *
+ ****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "l2macd_crc.h"
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_crc32c
+ | Responsibility: Extend a CRC-32C (Castagnoli) over a buffer
+ | Parameters:
+ |      crc : CRC of the previous buffers, 0 to start
+ |      data : buffer
+ |      n : size of the buffer
+ | Return:
+ |      CRC
+ ------------------------------------------------------------------------------
+ */
+uint32_t
+l2macd_crc32c(uint32_t crc, const void *data, size_t n)
+{
+    const uint8_t *p = data;
+    int i;
+
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+        }
+    }
+    return ~crc;
+} /* l2macd_crc32c */
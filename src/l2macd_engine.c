@@ -0,0 +1,225 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the ops-l2macd incremental processing engine.
+ *
+ ****************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dynamic-string.h>
+#include <openvswitch/vlog.h>
+#include "l2macd_engine.h"
+#include "util.h"
+#include "timeval.h"
+
+VLOG_DEFINE_THIS_MODULE(l2macd_engine);
+
+static bool engine_force_recompute = false;
+static uint64_t engine_visit_id = 0;      /* Marks the nodes of a traversal */
+static uint64_t engine_n_runs = 0;
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_engine_add_input
+ | Responsibility: Add a dependency to a node
+ | Parameters:
+ |      node : dependent node
+ |      input : node depended on
+ |      change_handler : incremental handler, NULL to recompute
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_engine_add_input(struct l2macd_engine_node *node,
+                        struct l2macd_engine_node *input,
+                        l2macd_engine_change_handler *change_handler)
+{
+    ovs_assert(node->n_inputs < L2MACD_ENGINE_MAX_INPUTS);
+
+    node->inputs[node->n_inputs].node = input;
+    node->inputs[node->n_inputs].change_handler = change_handler;
+    node->n_inputs++;
+} /* l2macd_engine_add_input */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_engine_force_recompute
+ | Responsibility: Recompute all the nodes at the next run
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_engine_force_recompute(void)
+{
+    engine_force_recompute = true;
+} /* l2macd_engine_force_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: engine_recompute
+ | Responsibility: Recompute a node from scratch
+ | Parameters:
+ |      node : engine node
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+engine_recompute(struct l2macd_engine_node *node)
+{
+    long long int start = time_msec();
+
+    node->run(node);
+    node->n_recompute++;
+    node->recompute_msec += time_msec() - start;
+} /* engine_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: engine_run_node
+ | Responsibility: Bring a node up to date, its inputs first
+ | Parameters:
+ |      node : engine node
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+engine_run_node(struct l2macd_engine_node *node)
+{
+    long long int start;
+    bool inputs_changed = false;
+    size_t i;
+
+    if (node->visit_id == engine_visit_id) {
+        /* Shared input, already evaluated in this run. */
+        return;
+    }
+    node->visit_id = engine_visit_id;
+    node->changed = false;
+
+    for (i = 0; i < node->n_inputs; i++) {
+        engine_run_node(node->inputs[i].node);
+        inputs_changed |= node->inputs[i].node->changed;
+    }
+
+    if (node->n_inputs == 0) {
+        /* Source node, check for changes. */
+        node->run(node);
+        return;
+    }
+
+    if (engine_force_recompute) {
+        engine_recompute(node);
+        return;
+    }
+
+    if (!inputs_changed) {
+        return;
+    }
+
+    start = time_msec();
+    for (i = 0; i < node->n_inputs; i++) {
+        const struct l2macd_engine_input *input = &node->inputs[i];
+
+        if (!input->node->changed) {
+            continue;
+        }
+
+        if (!input->change_handler || !input->change_handler(node)) {
+            VLOG_DBG("%s: recompute for a change of %s", node->name,
+                     input->node->name);
+            engine_recompute(node);
+            return;
+        }
+    }
+    node->n_incremental++;
+    node->incremental_msec += time_msec() - start;
+} /* engine_run_node */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_engine_run
+ | Responsibility: Bring a node and all the nodes it depends on up to date
+ | Parameters:
+ |      root : final node of the graph
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_engine_run(struct l2macd_engine_node *root)
+{
+    engine_visit_id++;
+    engine_n_runs++;
+    engine_run_node(root);
+    engine_force_recompute = false;
+} /* l2macd_engine_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: engine_dump_node
+ | Responsibility: Dump the statistics of a node, its inputs first
+ | Parameters:
+ |      node : engine node
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+engine_dump_node(struct l2macd_engine_node *node, struct ds *ds)
+{
+    size_t i;
+
+    if (node->visit_id == engine_visit_id) {
+        return;
+    }
+    node->visit_id = engine_visit_id;
+
+    for (i = 0; i < node->n_inputs; i++) {
+        engine_dump_node(node->inputs[i].node, ds);
+    }
+
+    ds_put_format(ds, "  %-16s recompute %"PRIu64" (%lld ms), "
+                  "incremental %"PRIu64" (%lld ms)\n", node->name,
+                  node->n_recompute, node->recompute_msec,
+                  node->n_incremental, node->incremental_msec);
+} /* engine_dump_node */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_engine_dump
+ | Responsibility: Dump the statistics of the engine nodes
+ | Parameters:
+ |      root : final node of the graph
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_engine_dump(struct l2macd_engine_node *root, struct ds *ds)
+{
+    ds_put_format(ds, "Engine: %"PRIu64" runs\n", engine_n_runs);
+    engine_visit_id++;
+    engine_dump_node(root, ds);
+} /* l2macd_engine_dump */
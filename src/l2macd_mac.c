@@ -0,0 +1,937 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the ops-l2macd MAC table monitor.
+ *
+ ****************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <openvswitch/vlog.h>
+#include <hash.h>
+#include "hmap.h"
+#include "l2macd.h"
+#include "l2macd_mac.h"
+#include "l2macd_metrics.h"
+#include "util.h"
+#include "timeval.h"
+#include "uuid.h"
+
+VLOG_DEFINE_THIS_MODULE(l2macd_mac);
+
+/* A learned MAC. The key packs the 48 bits of the MAC and the 12 bits of
+ * the VLAN ID. */
+struct l2macd_mac {
+    struct hmap_node hmap_node;     /* In mac_table, by key */
+    uint64_t key;
+    struct uuid row_uuid;           /* MAC row */
+    struct uuid port_uuid;          /* Port the MAC is learned on */
+    long long int window_start;     /* Start of the move window */
+    long long int hold_until;       /* End of the hold-down */
+    uint32_t n_moves;               /* Moves in the current window */
+};
+
+/* MAC counter of a port. */
+struct l2macd_mac_port {
+    struct hmap_node hmap_node;     /* In mac_ports, by uuid */
+    struct uuid uuid;               /* Port row */
+    struct l2macd_mac_counter counter;
+};
+
+struct l2macd_mac_stats {
+    uint64_t n_learned;
+    uint64_t n_moves;
+    uint64_t n_flaps;               /* Flapping MACs detected */
+    uint64_t n_held_moves;          /* Moves ignored in hold-down */
+    uint64_t n_limit_flushes;       /* MACs learned beyond a limit */
+};
+
+/* A watermark crossing. */
+struct l2macd_mac_event {
+    long long int when;             /* Wall clock ms */
+    bool high;                      /* Up the high watermark, or down the
+                                     * low one */
+    uint32_t n_macs;
+};
+
+static bool mac_enabled = false;
+static struct hmap mac_table = HMAP_INITIALIZER(&mac_table);
+static struct hmap mac_ports = HMAP_INITIALIZER(&mac_ports);
+static struct l2macd_mac_counter mac_vlans[L2MACD_MAC_N_VLANS];
+static bool mac_state_changed = false;
+static bool mac_counts_changed = false;
+static struct l2macd_mac_stats mac_stats;
+
+static struct l2macd_mac_utilization mac_util = {
+    .high_pct = L2MACD_MAC_HIGH_WATERMARK,
+    .low_pct = L2MACD_MAC_LOW_WATERMARK,
+};
+static struct l2macd_mac_event mac_events[L2MACD_MAC_N_WATERMARK_EVENTS];
+
+static unsigned int move_threshold = L2MACD_MAC_MOVE_THRESHOLD;
+static long long int move_window = L2MACD_MAC_MOVE_WINDOW_MSEC;
+static long long int hold_down = L2MACD_MAC_MOVE_HOLD_DOWN_MSEC;
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_enable
+ | Responsibility: Enable the MAC table monitor
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_enable(void)
+{
+    mac_enabled = true;
+} /* l2macd_mac_enable */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_enabled
+ | Responsibility: Tell whether the MAC table is monitored
+ | Parameters:
+ |      None
+ | Return:
+ |      bool : true if enabled
+ ------------------------------------------------------------------------------
+ */
+bool
+l2macd_mac_enabled(void)
+{
+    return mac_enabled;
+} /* l2macd_mac_enabled */
+
+/*-----------------------------------------------------------------------------
+ | Function: watermark_check
+ | Responsibility: Update the watermark state from the number of MACs. The
+ |                 state changes going over the high watermark and back under
+ |                 the low one, each change is a recorded crossing
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+watermark_check(void)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 5);
+    struct l2macd_mac_event *event;
+    uint64_t used, capacity;
+
+    mac_util.n_macs = hmap_count(&mac_table);
+    if (mac_util.capacity == 0) {
+        return;
+    }
+
+    /* Compared in percent of the capacity, without rounding. */
+    used = (uint64_t) mac_util.n_macs * 100;
+    capacity = mac_util.capacity;
+    if (mac_util.high ? used > capacity * mac_util.low_pct
+                      : used < capacity * mac_util.high_pct) {
+        return;
+    }
+
+    mac_util.high = !mac_util.high;
+    mac_util.last_crossing = time_wall_msec();
+    event = &mac_events[mac_util.n_crossings++
+                        % L2MACD_MAC_N_WATERMARK_EVENTS];
+    event->when = mac_util.last_crossing;
+    event->high = mac_util.high;
+    event->n_macs = mac_util.n_macs;
+    mac_state_changed = true;
+
+    if (mac_util.high) {
+        VLOG_WARN_RL(&rl, "MAC table over its high watermark: %"PRIu32" of "
+                     "%"PRIu32" entries (%u%%)", mac_util.n_macs,
+                     mac_util.capacity, mac_util.high_pct);
+    } else {
+        VLOG_INFO_RL(&rl, "MAC table back under its low watermark: %"PRIu32
+                     " of %"PRIu32" entries (%u%%)", mac_util.n_macs,
+                     mac_util.capacity, mac_util.low_pct);
+    }
+} /* watermark_check */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_configure
+ | Responsibility: Read the move detection parameters, the table capacity
+ |                 and its watermarks
+ | Parameters:
+ |      other_config : System:other_config, NULL for the defaults
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_configure(const struct smap *other_config)
+{
+    static const struct smap empty = SMAP_INITIALIZER(&empty);
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    int high, low;
+
+    if (other_config == NULL) {
+        other_config = &empty;
+    }
+
+    move_threshold = MAX(0, smap_get_int(other_config, "mac_move_threshold",
+                                         L2MACD_MAC_MOVE_THRESHOLD));
+    move_window = MAX(1, smap_get_int(other_config, "mac_move_window",
+                                      L2MACD_MAC_MOVE_WINDOW_MSEC));
+    hold_down = MAX(0, smap_get_int(other_config, "mac_move_hold_down",
+                                    L2MACD_MAC_MOVE_HOLD_DOWN_MSEC));
+
+    mac_util.capacity = MAX(0, smap_get_int(other_config,
+                                            L2MACD_MAC_CAPACITY_KEY, 0));
+    high = smap_get_int(other_config, L2MACD_MAC_HIGH_WATERMARK_KEY,
+                        L2MACD_MAC_HIGH_WATERMARK);
+    low = smap_get_int(other_config, L2MACD_MAC_LOW_WATERMARK_KEY,
+                       L2MACD_MAC_LOW_WATERMARK);
+    if (high < 1 || high > 100 || low < 0 || low >= high) {
+        VLOG_WARN_RL(&rl, "Invalid MAC watermarks: high %d%%, low %d%%, "
+                     "using %d%% and %d%%", high, low,
+                     L2MACD_MAC_HIGH_WATERMARK, L2MACD_MAC_LOW_WATERMARK);
+        high = L2MACD_MAC_HIGH_WATERMARK;
+        low = L2MACD_MAC_LOW_WATERMARK;
+    }
+    mac_util.high_pct = high;
+    mac_util.low_pct = low;
+
+    if (mac_util.capacity == 0 && mac_util.high) {
+        /* Watermarks disabled. */
+        mac_util.high = false;
+        mac_state_changed = true;
+    }
+    watermark_check();
+} /* l2macd_mac_configure */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_key
+ | Responsibility: Pack a MAC and a VLAN ID
+ | Parameters:
+ |      mac : MAC address
+ |      vid : VLAN ID
+ |      key : packed key
+ | Return:
+ |      bool : false if mac cannot be parsed
+ ------------------------------------------------------------------------------
+ */
+static bool
+mac_key(const char *mac, int vid, uint64_t *key)
+{
+    unsigned int b[6];
+    int i;
+
+    if (mac == NULL
+        || sscanf(mac, "%x:%x:%x:%x:%x:%x",
+                  &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+
+    *key = 0;
+    for (i = 0; i < 6; i++) {
+        *key = (*key << 8) | (b[i] & 0xff);
+    }
+    *key = (*key << 12) | (vid & 0xfff);
+    return true;
+} /* mac_key */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_lookup
+ | Responsibility: Find a MAC by key
+ | Parameters:
+ |      key : packed MAC and VLAN ID
+ | Return:
+ |      entry, NULL if not learned
+ ------------------------------------------------------------------------------
+ */
+static struct l2macd_mac *
+mac_lookup(uint64_t key)
+{
+    struct l2macd_mac *entry;
+
+    HMAP_FOR_EACH_WITH_HASH (entry, hmap_node, hash_uint64(key),
+                             &mac_table) {
+        if (entry->key == key) {
+            return entry;
+        }
+    }
+    return NULL;
+} /* mac_lookup */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_format
+ | Responsibility: Append the MAC and VLAN of a key
+ | Parameters:
+ |      ds : dynamic string
+ |      key : packed MAC and VLAN ID
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_format(struct ds *ds, uint64_t key)
+{
+    uint64_t mac = key >> 12;
+
+    ds_put_format(ds, "%02x:%02x:%02x:%02x:%02x:%02x vlan %d",
+                  (int) (mac >> 40) & 0xff, (int) (mac >> 32) & 0xff,
+                  (int) (mac >> 24) & 0xff, (int) (mac >> 16) & 0xff,
+                  (int) (mac >> 8) & 0xff, (int) mac & 0xff,
+                  (int) (key & 0xfff));
+} /* mac_format */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_port_lookup
+ | Responsibility: Find the counter of a port
+ | Parameters:
+ |      uuid : Port row UUID
+ |      create : add the counter if missing
+ | Return:
+ |      port counter, NULL if missing and not created
+ ------------------------------------------------------------------------------
+ */
+static struct l2macd_mac_port *
+mac_port_lookup(const struct uuid *uuid, bool create)
+{
+    struct l2macd_mac_port *port;
+
+    HMAP_FOR_EACH_WITH_HASH (port, hmap_node, uuid_hash(uuid), &mac_ports) {
+        if (uuid_equals(&port->uuid, uuid)) {
+            return port;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+    port = xzalloc(sizeof *port);
+    port->uuid = *uuid;
+    hmap_insert(&mac_ports, &port->hmap_node, uuid_hash(uuid));
+    return port;
+} /* mac_port_lookup */
+
+/*-----------------------------------------------------------------------------
+ | Function: counter_check
+ | Responsibility: Update the limit state of a counter
+ | Parameters:
+ |      counter : port or VLAN counter
+ | Return:
+ |      bool : true if the counter is over its limit
+ ------------------------------------------------------------------------------
+ */
+static bool
+counter_check(struct l2macd_mac_counter *counter)
+{
+    bool over = counter->limit && counter->n_macs > counter->limit;
+
+    if (over != counter->exceeded) {
+        counter->exceeded = over;
+        counter->n_violations += over;
+        counter->next_flush_msec = 0;
+        mac_state_changed = true;
+    }
+    return over;
+} /* counter_check */
+
+/*-----------------------------------------------------------------------------
+ | Function: counter_flush_due
+ | Responsibility: Check whether a counter over its limit is to be flushed:
+ |                 when it crosses the limit, then once per
+ |                 L2MACD_MAC_LIMIT_FLUSH_MSEC at most
+ | Parameters:
+ |      counter : port or VLAN counter over its limit
+ | Return:
+ |      bool : true if the port or VLAN is to be flushed now
+ ------------------------------------------------------------------------------
+ */
+static bool
+counter_flush_due(struct l2macd_mac_counter *counter)
+{
+    long long int now = time_msec();
+
+    if (now < counter->next_flush_msec) {
+        return false;
+    }
+    counter->next_flush_msec = now + L2MACD_MAC_LIMIT_FLUSH_MSEC;
+    return true;
+} /* counter_flush_due */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_count
+ | Responsibility: Count a MAC learned on, or removed from, a port. The
+ |                 port or VLAN going beyond its limit is flushed
+ | Parameters:
+ |      port_uuid : Port row UUID
+ |      vid : VLAN ID
+ |      learned : true if learned, false if removed
+ |      vlan : also count the MAC in its VLAN
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_count(const struct uuid *port_uuid, int vid, bool learned, bool vlan)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 5);
+    struct l2macd_mac_port *port = mac_port_lookup(port_uuid, learned);
+    struct l2macd_mac_counter *counter = &mac_vlans[vid & 0xfff];
+
+    mac_counts_changed = true;
+    if (port) {
+        if (learned) {
+            port->counter.n_macs++;
+        } else if (port->counter.n_macs) {
+            port->counter.n_macs--;
+        }
+        if (counter_check(&port->counter) && learned
+            && counter_flush_due(&port->counter)) {
+            VLOG_WARN_RL(&rl, "Port "UUID_FMT" over its limit of %"PRIu32
+                         " MACs, flushing it", UUID_ARGS(port_uuid),
+                         port->counter.limit);
+            mac_stats.n_limit_flushes++;
+            l2macd_flush_port(port_uuid, L2MACD_FLUSH_MAC_LIMIT);
+        }
+    }
+
+    if (!vlan) {
+        return;
+    }
+    if (learned) {
+        counter->n_macs++;
+    } else if (counter->n_macs) {
+        counter->n_macs--;
+    }
+    if (counter_check(counter) && learned && counter_flush_due(counter)) {
+        VLOG_WARN_RL(&rl, "VLAN %d over its limit of %"PRIu32" MACs, "
+                     "flushing it on port "UUID_FMT, vid & 0xfff,
+                     counter->limit, UUID_ARGS(port_uuid));
+        mac_stats.n_limit_flushes++;
+        l2macd_flush_port_vlan(port_uuid, vid & 0xfff, L2MACD_FLUSH_MAC_LIMIT);
+    }
+} /* mac_count */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_moved
+ | Responsibility: Account a move and dampen a flapping MAC
+ | Parameters:
+ |      entry : MAC, still on the previous port
+ |      port_uuid : new port
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+mac_moved(struct l2macd_mac *entry, const struct uuid *port_uuid)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 5);
+    long long int now = time_msec();
+    int vid = entry->key & 0xfff;
+
+    mac_stats.n_moves++;
+
+    if (now < entry->hold_until) {
+        mac_stats.n_held_moves++;
+        return;
+    }
+
+    if (now - entry->window_start >= move_window) {
+        entry->window_start = now;
+        entry->n_moves = 0;
+    }
+    entry->n_moves++;
+
+    if (move_threshold == 0 || entry->n_moves < move_threshold) {
+        return;
+    }
+
+    /* Flapping: flush the MAC from both ports and hold it down. */
+    mac_stats.n_flaps++;
+    entry->hold_until = now + hold_down;
+    entry->n_moves = 0;
+
+    if (!VLOG_DROP_WARN(&rl)) {
+        struct ds ds = DS_EMPTY_INITIALIZER;
+
+        mac_format(&ds, entry->key);
+        VLOG_WARN("MAC %s moved %u times in %lld ms, flushing and holding "
+                  "it down for %lld ms", ds_cstr(&ds), move_threshold,
+                  move_window, hold_down);
+        ds_destroy(&ds);
+    }
+
+    l2macd_flush_port_vlan(&entry->port_uuid, vid, L2MACD_FLUSH_MAC_MOVE);
+    l2macd_flush_port_vlan(port_uuid, vid, L2MACD_FLUSH_MAC_MOVE);
+} /* mac_moved */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_learn
+ | Responsibility: Record a MAC learned or moved on a port
+ | Parameters:
+ |      mac : MAC address
+ |      vid : VLAN ID
+ |      row_uuid : MAC row UUID
+ |      port_uuid : Port row UUID
+ |      detect : false to only record the port, the watermarks are then
+ |               checked by l2macd_mac_configure() after the load
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_learn(const char *mac, int vid, const struct uuid *row_uuid,
+                 const struct uuid *port_uuid, bool detect)
+{
+    struct l2macd_mac *entry;
+    uint64_t key;
+
+    if (!mac_key(mac, vid, &key)) {
+        return;
+    }
+
+    entry = mac_lookup(key);
+    if (entry == NULL) {
+        entry = xzalloc(sizeof *entry);
+        entry->key = key;
+        entry->row_uuid = *row_uuid;
+        entry->port_uuid = *port_uuid;
+        hmap_insert(&mac_table, &entry->hmap_node, hash_uint64(key));
+        mac_stats.n_learned++;
+        mac_count(port_uuid, vid, true, true);
+        if (detect) {
+            watermark_check();
+        } else {
+            mac_util.n_macs++;
+        }
+        return;
+    }
+
+    if (!uuid_equals(&entry->port_uuid, port_uuid)) {
+        if (detect) {
+            mac_moved(entry, port_uuid);
+        }
+        mac_count(&entry->port_uuid, vid, false, false);
+        mac_count(port_uuid, vid, true, false);
+    }
+
+    entry->row_uuid = *row_uuid;
+    entry->port_uuid = *port_uuid;
+} /* l2macd_mac_learn */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_forget
+ | Responsibility: Forget a MAC whose row was deleted
+ | Parameters:
+ |      mac : MAC address
+ |      vid : VLAN ID
+ |      row_uuid : deleted MAC row UUID
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_forget(const char *mac, int vid, const struct uuid *row_uuid)
+{
+    struct l2macd_mac *entry;
+    uint64_t key;
+
+    if (!mac_key(mac, vid, &key)) {
+        return;
+    }
+
+    /* A move may be a delete and an insert, the MAC is then already
+     * recorded with the new row. */
+    entry = mac_lookup(key);
+    if (entry && uuid_equals(&entry->row_uuid, row_uuid)) {
+        mac_count(&entry->port_uuid, vid, false, true);
+        hmap_remove(&mac_table, &entry->hmap_node);
+        free(entry);
+        watermark_check();
+    }
+} /* l2macd_mac_forget */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_learned
+ | Responsibility: Tell whether a MAC is learned
+ | Parameters:
+ |      mac : MAC address
+ |      vid : VLAN ID
+ | Return:
+ |      bool : true if the MAC is in the table
+ ------------------------------------------------------------------------------
+ */
+bool
+l2macd_mac_learned(const char *mac, int vid)
+{
+    uint64_t key;
+
+    return mac_key(mac, vid, &key) && mac_lookup(key) != NULL;
+} /* l2macd_mac_learned */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_clear
+ | Responsibility: Forget all the MACs
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_clear(void)
+{
+    struct l2macd_mac *entry, *next;
+    struct l2macd_mac_port *port;
+    int vid;
+
+    HMAP_FOR_EACH_SAFE (entry, next, hmap_node, &mac_table) {
+        hmap_remove(&mac_table, &entry->hmap_node);
+        free(entry);
+    }
+
+    /* The limits and the watermark state are kept, the states are checked
+     * again as the MACs are learned. */
+    HMAP_FOR_EACH (port, hmap_node, &mac_ports) {
+        port->counter.n_macs = 0;
+        port->counter.exceeded = false;
+    }
+    for (vid = 0; vid < L2MACD_MAC_N_VLANS; vid++) {
+        mac_vlans[vid].n_macs = 0;
+        mac_vlans[vid].exceeded = false;
+    }
+    mac_util.n_macs = 0;
+    mac_state_changed = true;
+    mac_counts_changed = true;
+} /* l2macd_mac_clear */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_set_port_limit
+ | Responsibility: Set the MAC limit of a port
+ | Parameters:
+ |      port_uuid : Port row UUID
+ |      limit : maximum number of MACs, 0 for no limit
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_set_port_limit(const struct uuid *port_uuid, uint32_t limit)
+{
+    struct l2macd_mac_port *port = mac_port_lookup(port_uuid, limit != 0);
+
+    if (port && port->counter.limit != limit) {
+        /* Lowering the limit marks the port, the MACs beyond it are
+         * flushed as they are learned. */
+        port->counter.limit = limit;
+        counter_check(&port->counter);
+    }
+} /* l2macd_mac_set_port_limit */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_set_vlan_limit
+ | Responsibility: Set the MAC limit of a VLAN
+ | Parameters:
+ |      vid : VLAN ID
+ |      limit : maximum number of MACs, 0 for no limit
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_set_vlan_limit(int vid, uint32_t limit)
+{
+    if (vid >= 0 && vid < L2MACD_MAC_N_VLANS
+        && mac_vlans[vid].limit != limit) {
+        mac_vlans[vid].limit = limit;
+        counter_check(&mac_vlans[vid]);
+    }
+} /* l2macd_mac_set_vlan_limit */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_port_deleted
+ | Responsibility: Forget the counter of a deleted port
+ | Parameters:
+ |      port_uuid : Port row UUID
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_port_deleted(const struct uuid *port_uuid)
+{
+    struct l2macd_mac_port *port = mac_port_lookup(port_uuid, false);
+
+    if (port) {
+        hmap_remove(&mac_ports, &port->hmap_node);
+        free(port);
+    }
+} /* l2macd_mac_port_deleted */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_port_counter
+ | Responsibility: Get the counter of a port
+ | Parameters:
+ |      port_uuid : Port row UUID
+ | Return:
+ |      port counter, NULL if the port has neither MAC nor limit
+ ------------------------------------------------------------------------------
+ */
+const struct l2macd_mac_counter *
+l2macd_mac_port_counter(const struct uuid *port_uuid)
+{
+    struct l2macd_mac_port *port = mac_port_lookup(port_uuid, false);
+
+    return port ? &port->counter : NULL;
+} /* l2macd_mac_port_counter */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_vlan_counter
+ | Responsibility: Get the counter of a VLAN
+ | Parameters:
+ |      vid : VLAN ID
+ | Return:
+ |      VLAN counter, NULL if vid is out of range
+ ------------------------------------------------------------------------------
+ */
+const struct l2macd_mac_counter *
+l2macd_mac_vlan_counter(int vid)
+{
+    return vid >= 0 && vid < L2MACD_MAC_N_VLANS ? &mac_vlans[vid] : NULL;
+} /* l2macd_mac_vlan_counter */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_state_changed
+ | Responsibility: Tell whether a limit state changed since the last call
+ | Parameters:
+ |      None
+ | Return:
+ |      bool : true if a port or a VLAN started or stopped exceeding its
+ |             limit
+ ------------------------------------------------------------------------------
+ */
+bool
+l2macd_mac_state_changed(void)
+{
+    bool changed = mac_state_changed;
+
+    mac_state_changed = false;
+    return changed;
+} /* l2macd_mac_state_changed */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_dump
+ | Responsibility: Append the monitor state to a debug dump
+ | Parameters:
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_dump(struct ds *ds)
+{
+    const struct l2macd_mac *entry;
+    const struct l2macd_mac_port *port;
+    long long int now = time_msec();
+    uint64_t i;
+    int vid;
+
+    if (!mac_enabled) {
+        ds_put_cstr(ds, "MAC monitor: disabled\n");
+        return;
+    }
+
+    ds_put_format(ds, "MAC monitor: %zu MACs\n", hmap_count(&mac_table));
+    ds_put_format(ds, "  move detection: %u moves in %lld ms, hold-down "
+                  "%lld ms\n", move_threshold, move_window, hold_down);
+    ds_put_format(ds, "  learned: %"PRIu64", moves: %"PRIu64", flaps: "
+                  "%"PRIu64", moves held down: %"PRIu64"\n",
+                  mac_stats.n_learned, mac_stats.n_moves, mac_stats.n_flaps,
+                  mac_stats.n_held_moves);
+
+    HMAP_FOR_EACH (entry, hmap_node, &mac_table) {
+        if (entry->hold_until > now) {
+            ds_put_cstr(ds, "  held down: ");
+            mac_format(ds, entry->key);
+            ds_put_format(ds, ", %lld ms left\n", entry->hold_until - now);
+        }
+    }
+
+    ds_put_format(ds, "  limit flushes: %"PRIu64"\n",
+                  mac_stats.n_limit_flushes);
+    HMAP_FOR_EACH (port, hmap_node, &mac_ports) {
+        if (port->counter.limit || port->counter.n_violations) {
+            ds_put_format(ds, "  port "UUID_FMT": %"PRIu32" MACs, limit "
+                          "%"PRIu32", %"PRIu64" violations%s\n",
+                          UUID_ARGS(&port->uuid), port->counter.n_macs,
+                          port->counter.limit, port->counter.n_violations,
+                          port->counter.exceeded ? ", exceeded" : "");
+        }
+    }
+    for (vid = 0; vid < L2MACD_MAC_N_VLANS; vid++) {
+        const struct l2macd_mac_counter *counter = &mac_vlans[vid];
+
+        if (counter->limit || counter->n_violations) {
+            ds_put_format(ds, "  vlan %d: %"PRIu32" MACs, limit %"PRIu32", "
+                          "%"PRIu64" violations%s\n", vid, counter->n_macs,
+                          counter->limit, counter->n_violations,
+                          counter->exceeded ? ", exceeded" : "");
+        }
+    }
+
+    if (mac_util.capacity) {
+        ds_put_format(ds, "  capacity: %"PRIu32" MACs, watermarks %u%%/%u%%, "
+                      "%s, %"PRIu64" crossings\n", mac_util.capacity,
+                      mac_util.high_pct, mac_util.low_pct,
+                      mac_util.high ? "high" : "normal",
+                      mac_util.n_crossings);
+    } else {
+        ds_put_cstr(ds, "  capacity: unknown\n");
+    }
+    i = mac_util.n_crossings > L2MACD_MAC_N_WATERMARK_EVENTS
+        ? mac_util.n_crossings - L2MACD_MAC_N_WATERMARK_EVENTS : 0;
+    for (; i < mac_util.n_crossings; i++) {
+        const struct l2macd_mac_event *event;
+
+        event = &mac_events[i % L2MACD_MAC_N_WATERMARK_EVENTS];
+        ds_put_format(ds, "  crossing %"PRIu64": %s watermark, %"PRIu32
+                      " MACs, %lld s ago\n", i + 1,
+                      event->high ? "over high" : "under low", event->n_macs,
+                      (time_wall_msec() - event->when) / 1000);
+    }
+} /* l2macd_mac_dump */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_metrics
+ | Responsibility: Append the monitor metrics
+ | Parameters:
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_metrics(struct ds *ds)
+{
+    const struct l2macd_mac_port *port;
+    uint64_t n_port_violations = 0;
+    uint64_t n_vlan_violations = 0;
+    int vid;
+
+    if (!mac_enabled) {
+        return;
+    }
+
+    l2macd_metrics_header(ds, "l2macd_macs", "gauge", "Learned MACs.");
+    ds_put_format(ds, "l2macd_macs %zu\n", hmap_count(&mac_table));
+
+    l2macd_metrics_header(ds, "l2macd_mac_table_capacity", "gauge",
+                          "MAC table size, 0 if unknown.");
+    ds_put_format(ds, "l2macd_mac_table_capacity %"PRIu32"\n",
+                  mac_util.capacity);
+
+    l2macd_metrics_header(ds, "l2macd_mac_watermark_high", "gauge",
+                          "1 while the MAC table is over its high "
+                          "watermark.");
+    ds_put_format(ds, "l2macd_mac_watermark_high %d\n", mac_util.high);
+
+    l2macd_metrics_header(ds, "l2macd_mac_watermark_crossings_total",
+                          "counter", "MAC table watermark crossings.");
+    ds_put_format(ds, "l2macd_mac_watermark_crossings_total %"PRIu64"\n",
+                  mac_util.n_crossings);
+
+    l2macd_metrics_header(ds, "l2macd_mac_moves_total", "counter",
+                          "MAC moves between ports.");
+    ds_put_format(ds, "l2macd_mac_moves_total %"PRIu64"\n",
+                  mac_stats.n_moves);
+
+    l2macd_metrics_header(ds, "l2macd_mac_flaps_total", "counter",
+                          "Flapping MACs detected.");
+    ds_put_format(ds, "l2macd_mac_flaps_total %"PRIu64"\n",
+                  mac_stats.n_flaps);
+
+    l2macd_metrics_header(ds, "l2macd_mac_limit_violations_total", "counter",
+                          "Ports and VLANs going over their MAC limit.");
+    HMAP_FOR_EACH (port, hmap_node, &mac_ports) {
+        n_port_violations += port->counter.n_violations;
+    }
+    for (vid = 0; vid < L2MACD_MAC_N_VLANS; vid++) {
+        n_vlan_violations += mac_vlans[vid].n_violations;
+    }
+    ds_put_format(ds, "l2macd_mac_limit_violations_total{scope=\"port\"} "
+                  "%"PRIu64"\n", n_port_violations);
+    ds_put_format(ds, "l2macd_mac_limit_violations_total{scope=\"vlan\"} "
+                  "%"PRIu64"\n", n_vlan_violations);
+} /* l2macd_mac_metrics */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_get_memory_usage
+ | Responsibility: Report the memory used by the monitor
+ | Parameters:
+ |      usage : counters by structure
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_get_memory_usage(struct simap *usage)
+{
+    if (!mac_enabled) {
+        return;
+    }
+
+    simap_increase(usage, "macs", hmap_count(&mac_table));
+    simap_increase(usage, "mac-bytes",
+                   (mac_table.mask + 1) * sizeof(void *)
+                   + hmap_count(&mac_table) * sizeof(struct l2macd_mac));
+    simap_increase(usage, "mac-ports", hmap_count(&mac_ports));
+    simap_increase(usage, "mac-port-bytes",
+                   (mac_ports.mask + 1) * sizeof(void *)
+                   + hmap_count(&mac_ports) * sizeof(struct l2macd_mac_port));
+} /* l2macd_mac_get_memory_usage */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_mac_destroy
+ | Responsibility: Free the monitor state
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_mac_destroy(void)
+{
+    struct l2macd_mac_port *port, *next;
+
+    l2macd_mac_clear();
+    hmap_destroy(&mac_table);
+
+    HMAP_FOR_EACH_SAFE (port, next, hmap_node, &mac_ports) {
+        hmap_remove(&mac_ports, &port->hmap_node);
+        free(port);
+    }
+    hmap_destroy(&mac_ports);
+} /* l2macd_mac_destroy */
@@ -0,0 +1,194 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the ops-l2macd metrics exporter.
+ *
+ ****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dynamic-string.h>
+#include <openvswitch/vlog.h>
+#include "l2macd.h"
+#include "l2macd_metrics.h"
+#include "l2macd_profile.h"
+#include "poll-loop.h"
+#include "util.h"
+#include "timeval.h"
+
+VLOG_DEFINE_THIS_MODULE(l2macd_metrics);
+
+static char *metrics_path = NULL;
+static char *metrics_tmp_path = NULL;
+static long long int metrics_interval = L2MACD_METRICS_INTERVAL_MSEC;
+static long long int metrics_next_msec = 0;
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_metrics_init
+ | Responsibility: Start exporting the metrics
+ | Parameters:
+ |      path : metrics file
+ |      interval_msec : time between two writes
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_metrics_init(const char *path, long long int interval_msec)
+{
+    metrics_path = xstrdup(path);
+    metrics_tmp_path = xasprintf("%s.tmp", path);
+    metrics_interval = interval_msec;
+    metrics_next_msec = time_msec() + interval_msec;
+} /* l2macd_metrics_init */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_metrics_header
+ | Responsibility: Append the HELP and TYPE lines of a metric
+ | Parameters:
+ |      ds : dynamic string
+ |      name : metric name
+ |      type : metric type
+ |      help : metric description
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_metrics_header(struct ds *ds, const char *name, const char *type,
+                      const char *help)
+{
+    ds_put_format(ds, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+} /* l2macd_metrics_header */
+
+/*-----------------------------------------------------------------------------
+ | Function: metrics_write
+ | Responsibility: Replace the metrics file. The collector reads either the
+ |                 previous or the new file, never a partial one
+ | Parameters:
+ |      ds : file contents
+ | Return:
+ |      int : 0 on success, errno otherwise
+ ------------------------------------------------------------------------------
+ */
+static int
+metrics_write(const struct ds *ds)
+{
+    ssize_t n;
+    int fd;
+
+    fd = open(metrics_tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return errno;
+    }
+
+    n = write(fd, ds->string, ds->length);
+    if (n != ds->length) {
+        int error = n < 0 ? errno : EIO;
+
+        close(fd);
+        unlink(metrics_tmp_path);
+        return error;
+    }
+
+    if (close(fd) < 0 || rename(metrics_tmp_path, metrics_path) < 0) {
+        int error = errno;
+
+        unlink(metrics_tmp_path);
+        return error;
+    }
+
+    return 0;
+} /* metrics_write */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_metrics_run
+ | Responsibility: Write the metrics file when the interval has elapsed
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_metrics_run(void)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    int error;
+
+    if (metrics_path == NULL || time_msec() < metrics_next_msec) {
+        return;
+    }
+    metrics_next_msec = time_msec() + metrics_interval;
+    l2macd_profile_note(L2MACD_WAKEUP_TIMER);
+
+    l2macd_get_metrics(&ds);
+    l2macd_profile_metrics(&ds);
+
+    error = metrics_write(&ds);
+    if (error) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        VLOG_WARN_RL(&rl, "%s: write failed (%s)", metrics_path,
+                     ovs_strerror(error));
+    }
+    ds_destroy(&ds);
+} /* l2macd_metrics_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_metrics_wait
+ | Responsibility: Wake up the main loop for the next write
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_metrics_wait(void)
+{
+    if (metrics_path) {
+        poll_timer_wait_until(metrics_next_msec);
+    }
+} /* l2macd_metrics_wait */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_metrics_destroy
+ | Responsibility: Stop exporting the metrics
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_metrics_destroy(void)
+{
+    free(metrics_path);
+    free(metrics_tmp_path);
+    metrics_path = NULL;
+    metrics_tmp_path = NULL;
+} /* l2macd_metrics_destroy */
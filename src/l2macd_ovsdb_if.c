@@ -23,23 +23,38 @@
  *
  ****************************************************************************/
 
+#include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <daemon.h>
+#include <dirs.h>
 #include <dynamic-string.h>
 #include <vswitch-idl.h>
 #include <openswitch-idl.h>
 #include <openvswitch/vlog.h>
 #include <hash.h>
 #include <shash.h>
+#include <sset.h>
+#include "bitmap.h"
 #include "hmap.h"
+#include "list.h"
 #include "l2macd.h"
+#include "l2macd_age.h"
+#include "l2macd_checkpoint.h"
+#include "l2macd_engine.h"
+#include "l2macd_mac.h"
+#include "l2macd_metrics.h"
+#include "l2macd_profile.h"
+#include "l2macd_warm.h"
 #include "poll-loop.h"
 #include "util.h"
 #include "timeval.h"
+#include "uuid.h"
 
 VLOG_DEFINE_THIS_MODULE(l2macd_ovsdb_if);
 
@@ -68,6 +83,273 @@ static int system_configured = false;
 
 static struct l2macd_data_cache *g_l2macd_cache = NULL;
 
+/* Port of each interface, to find the port of a changed interface without
+ * walking all the ports. Rebuilt when the interfaces of a port change. */
+struct iface_port {
+    struct hmap_node hmap_node;     /* In "g_iface_ports", by iface UUID. */
+    struct uuid iface_uuid;
+    struct uuid port_uuid;
+};
+
+static struct hmap g_iface_ports = HMAP_INITIALIZER(&g_iface_ports);
+static bool iface_ports_stale = true;
+
+/* Cache checkpoint state. */
+static bool cache_dirty = false;           /* Changed since last checkpoint */
+static long long int next_ckpt_msec = 0;   /* Earliest next checkpoint */
+
+/* Set once the cache holds the full DB contents. Until then the cache is
+ * empty or restored from a checkpoint and a complete sync is needed. */
+static bool cache_synced = false;
+static long long int l2macd_start_msec;
+
+#define L2MACD_VLAN_BITMAP_SIZE 4096
+
+/* MAC flush requests collected during a pass and sent in one transaction. */
+struct flush_batch {
+    struct sset ports;          /* Names of the ports to flush */
+    unsigned long *vlans;       /* IDs of the VLANs to flush */
+    struct shash port_vlans;    /* Port name to bitmap of its VLANs to flush */
+    long long int first_msec;   /* Oldest request of the batch */
+    unsigned int n_failures;    /* Failed commits of this batch */
+    long long int retry_msec;   /* Earliest next commit after a failure */
+};
+
+/* A batch which fails to commit is sent again after a delay, and given up
+ * after a few attempts so that a request the DB rejects is not retried
+ * forever. */
+#define L2MACD_FLUSH_RETRY_MSEC     1000
+#define L2MACD_FLUSH_MAX_FAILURES   5
+
+static struct flush_batch g_flush_batch;
+
+static const char *flush_reason_names[L2MACD_N_FLUSH_REASONS] = {
+    [L2MACD_FLUSH_PORT_DOWN] = "port_down",
+    [L2MACD_FLUSH_VLAN_DOWN] = "vlan_down",
+    [L2MACD_FLUSH_RESYNC] = "resync",
+    [L2MACD_FLUSH_TAKEOVER] = "takeover",
+    [L2MACD_FLUSH_MAC_MOVE] = "mac_move",
+    [L2MACD_FLUSH_MAC_LIMIT] = "mac_limit",
+};
+
+/* Upper bounds of the flush latency histogram buckets, in ms. */
+static const long long int flush_latency_bounds[] = {
+    1, 5, 10, 50, 100, 500, 1000, 5000, 30000,
+};
+
+#define L2MACD_N_LATENCY_BUCKETS ARRAY_SIZE(flush_latency_bounds)
+
+struct l2macd_flush_stats {
+    uint64_t n_requests[L2MACD_N_FLUSH_REASONS];
+    uint64_t n_sent;                /* Ports and VLANs flushed */
+    uint64_t n_txns;
+    uint64_t n_txn_errors;
+    /* From the oldest request of a batch to its commit. The last bucket
+     * holds the latencies above all bounds. */
+    uint64_t latency_buckets[L2MACD_N_LATENCY_BUCKETS + 1];
+    long long int latency_sum_msec;
+};
+
+static struct l2macd_flush_stats g_flush_stats;
+
+/* Hot standby. Without the "ops_l2macd" lock, the cache is still kept in
+ * sync but the flushes are only recorded. After a takeover, the ones
+ * recorded in the last L2MACD_TAKEOVER_REPLAY_MSEC are sent again since
+ * the previous instance may have gone away before sending them. When the
+ * lock was not held by another instance, e.g. before the first lock reply
+ * at startup or after a reconnect, all the recorded flushes are sent. */
+#define L2MACD_TAKEOVER_REPLAY_MSEC 2000
+
+struct l2macd_standby {
+    bool lock_held;                 /* Lock held at the last run */
+    bool was_standby;               /* Lock held by another instance */
+    long long int standby_since;    /* Time standby started */
+    struct shash ports;             /* Port name -> time of the flush */
+    long long int vlans[L2MACD_VLAN_BITMAP_SIZE]; /* Time of the flush */
+    struct shash port_vlans;        /* Port name -> "struct
+                                     * standby_port_vlans" */
+    uint64_t n_suppressed;          /* Flushes recorded while standby,
+                                     * a flush already pending is not
+                                     * counted again */
+    uint64_t n_replayed;            /* Recorded flushes sent again */
+    uint64_t n_takeovers;
+    long long int takeover_msec;    /* Time of the last takeover */
+    long long int takeover_latency; /* Lock acquired to flushes replayed */
+};
+
+static struct l2macd_standby g_standby;
+
+/* VLAN flushes of a port recorded while standby. */
+struct standby_port_vlans {
+    unsigned long *vlans;           /* VLANs to flush */
+    long long int when;             /* Time of the latest flush */
+};
+
+/* OVSDB connection state. After a reconnect the IDL replaces its contents
+ * with a fresh snapshot, which the tracked changes do not describe
+ * reliably, so the cache is synced again from the complete snapshot. */
+struct l2macd_conn {
+    bool alive;                     /* Session up at the last run */
+    bool resync_pending;            /* Waiting for the fresh snapshot */
+    unsigned int resync_seqno;      /* IDL seqno before the reconnect */
+    uint64_t n_reconnects;
+    long long int reconnect_msec;   /* Time of the last reconnect */
+};
+
+static struct l2macd_conn g_conn;
+
+/* ops-switchd restart or warm boot. While ops-switchd is not running, and
+ * until its pid has been stable for L2MACD_SWITCHD_SETTLE_MSEC, interface
+ * states may bounce. Flushes are then held in g_flush_batch and sent at the
+ * end of the window for the ports and VLANs which are still down.
+ * ops-switchd is watched through its pidfile, no DB column tells that it
+ * restarted. */
+#define L2MACD_SWITCHD_PIDFILE       "ops-switchd.pid"
+#define L2MACD_SWITCHD_POLL_MSEC     1000
+#define L2MACD_SWITCHD_SETTLE_MSEC   10000
+#define L2MACD_SWITCHD_HOLD_MAX_MSEC 60000
+
+struct l2macd_switchd_hold {
+    bool active;                    /* Flushes are being held */
+    long long int start_msec;
+    uint64_t n_held;                /* Flush requests held, collapsed */
+    uint64_t n_windows;
+    bool expired;                   /* Gave up waiting, until next ready */
+    char *pidfile;                  /* ops-switchd pidfile */
+    pid_t pid;                      /* ops-switchd pid, 0 if not running,
+                                     * -1 before the first poll */
+    long long int pid_msec;         /* Time the pid was first seen */
+    long long int next_poll_msec;
+};
+
+static struct l2macd_switchd_hold g_hold = { .pid = -1 };
+
+/* IDL change statistics. */
+struct l2macd_wakeups {
+    uint64_t n_runs;                /* l2macd_run calls */
+    uint64_t n_changes;             /* IDL seqno changes handled */
+    uint64_t n_skipped;             /* Changes with no tracked row */
+};
+
+static struct l2macd_wakeups g_wakeups;
+
+/* Replication statistics of the last full sync. */
+struct l2macd_sync_stats {
+    long long int start_msec;       /* Start of the sync */
+    long long int sync_msec;        /* Duration of the sync */
+    long long int ready_msec;       /* From start to the first sync */
+    size_t n_iface_rows;            /* Interface rows replicated */
+    size_t n_system_ifaces;         /* Of which are system interfaces */
+    size_t n_port_rows;
+    size_t n_vlan_rows;
+    size_t n_stale;                 /* Cached entries without a row */
+};
+
+static struct l2macd_sync_stats g_sync_stats;
+
+/* MAC age-time in effect, see l2macd_age.h. */
+struct l2macd_age {
+    int age_time;                   /* System wide, in seconds */
+    size_t n_overrides;             /* VLANs with their own age-time */
+    unsigned long overrides[BITMAP_N_LONGS(L2MACD_VLAN_BITMAP_SIZE)];
+    uint64_t n_invalid;             /* Invalid settings ignored */
+    uint64_t n_updates;             /* Status columns written */
+};
+
+static struct l2macd_age g_age = {
+    .age_time = L2MACD_AGE_TIME_DEFAULT,
+};
+
+/* The age-time, the MAC limit and watermark states are published in the
+ * status columns once the "ops_l2macd" lock is held, see status_publish().
+ * The MAC counts change with every MAC learned, they are published with
+ * the next status update or once per L2MACD_MAC_COUNT_PUBLISH_MSEC. */
+static bool status_pending = false;
+static bool counts_pending = false;
+static long long int next_count_msec = 0;
+
+/* Warm reboot MAC snapshot, see l2macd_warm.h. The snapshot read on boot
+ * is written to the seed file once the cache is synced; the reader of the
+ * seed file is not part of ops-l2macd. */
+#define L2MACD_MAC_FROM_DYNAMIC     "dynamic"
+
+struct l2macd_warm {
+    char *path;                     /* NULL when disabled */
+    char *seed_path;                /* Left for ops-switchd */
+    struct l2macd_warm_snapshot snap;   /* Read on boot */
+    bool pending;                   /* snap is to be seeded */
+    bool seeded;                    /* seed_path is written */
+    int load_error;                 /* Of the snapshot read on boot */
+    uint64_t n_saves;
+    size_t n_saved;                 /* MACs of the last save */
+    size_t n_seeded;                /* MACs written to seed_path */
+    size_t n_no_port;               /* Port missing or down */
+    size_t n_no_vlan;               /* VLAN missing, down or not on port */
+    size_t n_present;               /* Already learned again */
+};
+
+static struct l2macd_warm g_warm;
+
+/* Bounded-work scheduling. IDL messages are drained for at most
+ * L2MACD_DRAIN_BUDGET_MSEC per run. Tracked changes are queued and
+ * evaluated in slices of at most L2MACD_SLICE_BUDGET_MSEC, the main loop
+ * serves ovs-appctl between two slices. */
+#define L2MACD_DRAIN_BUDGET_MSEC    20
+#define L2MACD_SLICE_BUDGET_MSEC    10
+#define L2MACD_SLICE_CHECK_ITEMS    16  /* Items between two clock reads */
+
+enum l2macd_work_type {
+    L2MACD_WORK_PORT,               /* Port inserted or modified */
+    L2MACD_WORK_PORT_DEL,           /* Port deleted */
+    L2MACD_WORK_VLAN,               /* VLAN inserted or modified */
+    L2MACD_WORK_VLAN_DEL,           /* VLAN deleted */
+};
+
+struct l2macd_work {
+    struct ovs_list list_node;      /* In struct l2macd_sched "queue" */
+    struct hmap_node hmap_node;     /* In struct l2macd_sched "dirty" */
+    enum l2macd_work_type type;
+    struct uuid uuid;               /* Row to evaluate */
+};
+
+struct l2macd_sched {
+    struct ovs_list queue;          /* Pending struct l2macd_work */
+    struct hmap dirty;              /* Same, by row UUID */
+    bool sweep_ports;               /* Port deleted, sweep the cache */
+    bool sweep_vlans;               /* VLAN deleted, sweep the cache */
+    uint64_t n_changes;             /* Changes queued, before dedup */
+    uint64_t n_dedup;               /* Changes merged in the dirty set */
+    uint64_t n_sweeps;              /* del_old_port/vlan calls */
+    uint64_t n_sweep_dedup;         /* Deletes merged in a sweep */
+    size_t n_queued;
+    size_t max_queued;              /* Backlog high watermark */
+    bool drain_pending;             /* Drain budget exhausted */
+    bool immediate_wake;            /* Next run called without waiting */
+    uint64_t n_items;               /* Work items evaluated */
+    uint64_t n_slices;
+    uint64_t n_drains;              /* ovsdb_idl_run calls */
+    uint64_t n_drain_budget_hit;
+    uint64_t n_slice_budget_hit;
+    long long int run_max_msec;     /* Longest l2macd_run */
+    long long int run_total_msec;
+};
+
+static struct l2macd_sched g_sched = {
+    .queue = OVS_LIST_INITIALIZER(&g_sched.queue),
+    .dirty = HMAP_INITIALIZER(&g_sched.dirty),
+};
+
+static void sched_purge(bool ports, bool vlans);
+static void l2macd_engine_setup(void);
+static void flush_batch_clear_port_vlans(struct flush_batch *batch);
+static void standby_clear_port_vlans(void);
+static void iface_ports_clear(void);
+
+/* A change handler gives up on a batch of tracked rows larger than half
+ * the cache, and at least L2MACD_ENGINE_RECOMPUTE_MIN rows: one pass over
+ * the table is then cheaper than queueing every row. */
+#define L2MACD_ENGINE_RECOMPUTE_MIN 64
+
 #define IS_CHANGED(x,y) (x != y)
 
 /*-----------------------------------------------------------------------------
@@ -86,10 +368,15 @@ l2macd_ovsdb_init(const char *db_path)
     idl = ovsdb_idl_create(db_path, &ovsrec_idl_class, false, true);
     idl_seqno = ovsdb_idl_get_seqno(idl);
     ovsdb_idl_set_lock(idl, "ops_l2macd");
+    l2macd_start_msec = time_msec();
 
     /* Cache System table. */
     ovsdb_idl_add_table(idl, &ovsrec_table_system);
     ovsdb_idl_add_column(idl, &ovsrec_system_col_cur_cfg);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_status);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_status);
+    ovsdb_idl_track_add_column(idl, &ovsrec_system_col_other_config);
 
     /* Cache Interface table columns. */
     ovsdb_idl_add_table(idl, &ovsrec_table_interface);
@@ -97,6 +384,26 @@ l2macd_ovsdb_init(const char *db_path)
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_link_state);
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_type);
 
+    /* Track Interface table columns. */
+    ovsdb_idl_track_add_column(idl, &ovsrec_interface_col_link_state);
+    ovsdb_idl_track_add_column(idl, &ovsrec_interface_col_type);
+
+#ifdef HAVE_IDL_CONDITION
+    /* Only system interfaces are of interest, see check_system_iface().
+     * Internal, loopback and tunnel interfaces are left on the server.
+     * The IDL falls back to a full monitor with a server which does not
+     * support monitor_cond, check_system_iface() then filters them. */
+    {
+        struct ovsdb_idl_condition cond;
+
+        ovsdb_idl_condition_init(&cond);
+        ovsrec_interface_add_clause_type(&cond, OVSDB_F_EQ,
+                                         OVSREC_INTERFACE_TYPE_SYSTEM);
+        ovsrec_interface_set_condition(idl, &cond);
+        ovsdb_idl_condition_destroy(&cond);
+    }
+#endif
+
     /* Cache Port table columns. */
     ovsdb_idl_add_table(idl, &ovsrec_table_port);
     ovsdb_idl_add_column(idl, &ovsrec_port_col_name);
@@ -107,25 +414,59 @@ l2macd_ovsdb_init(const char *db_path)
     ovsdb_idl_add_column(idl, &ovsrec_port_col_macs_invalid);
     ovsdb_idl_add_column(idl, &ovsrec_port_col_macs_invalid_on_vlans);
 
+    /* The flush request columns are only written by l2macd. They must be
+     * replicated to be modified, but their changes, including our own
+     * writes and ops-switchd clearing them, must not wake l2macd up. */
+    ovsdb_idl_omit_alert(idl, &ovsrec_port_col_macs_invalid);
+    ovsdb_idl_omit_alert(idl, &ovsrec_port_col_macs_invalid_on_vlans);
+
     /* Track port table columns. */
     ovsdb_idl_track_add_column(idl, &ovsrec_port_col_name);
     ovsdb_idl_track_add_column(idl, &ovsrec_port_col_vlan_mode);
     ovsdb_idl_track_add_column(idl, &ovsrec_port_col_vlan_tag);
     ovsdb_idl_track_add_column(idl, &ovsrec_port_col_vlan_trunks);
     ovsdb_idl_track_add_column(idl, &ovsrec_port_col_interfaces);
-    ovsdb_idl_track_add_column(idl, &ovsrec_port_col_macs_invalid);
-    ovsdb_idl_track_add_column(idl, &ovsrec_port_col_macs_invalid_on_vlans);
 
     /* Cache VLAN table columns. */
     ovsdb_idl_add_table(idl, &ovsrec_table_vlan);
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_id);
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_oper_state);
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_macs_invalid);
+    ovsdb_idl_omit_alert(idl, &ovsrec_vlan_col_macs_invalid);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_vlan_col_status);
+    ovsdb_idl_omit_alert(idl, &ovsrec_vlan_col_status);
 
     /* Track VLAN table columns. */
     ovsdb_idl_track_add_column(idl, &ovsrec_vlan_col_id);
     ovsdb_idl_track_add_column(idl, &ovsrec_vlan_col_oper_state);
-    ovsdb_idl_track_add_column(idl, &ovsrec_vlan_col_macs_invalid);
+    ovsdb_idl_track_add_column(idl, &ovsrec_vlan_col_other_config);
+
+    /* MAC table, only replicated for the MAC monitor, and the MAC limits
+     * it enforces. */
+    if (l2macd_mac_enabled()) {
+        ovsdb_idl_add_column(idl, &ovsrec_port_col_other_config);
+        ovsdb_idl_add_column(idl, &ovsrec_port_col_status);
+        ovsdb_idl_omit_alert(idl, &ovsrec_port_col_status);
+        ovsdb_idl_track_add_column(idl, &ovsrec_port_col_other_config);
+
+        ovsdb_idl_add_table(idl, &ovsrec_table_mac);
+        ovsdb_idl_add_column(idl, &ovsrec_mac_col_mac_addr);
+        ovsdb_idl_add_column(idl, &ovsrec_mac_col_mac_vlan);
+        ovsdb_idl_add_column(idl, &ovsrec_mac_col_port);
+        ovsdb_idl_track_add_column(idl, &ovsrec_mac_col_mac_addr);
+        ovsdb_idl_track_add_column(idl, &ovsrec_mac_col_mac_vlan);
+        ovsdb_idl_track_add_column(idl, &ovsrec_mac_col_port);
+    }
+
+    /* The warm reboot snapshot only saves the learned MACs, the column does
+     * not wake l2macd up. */
+    if (g_warm.path) {
+        ovsdb_idl_add_column(idl, &ovsrec_mac_col_from);
+        ovsdb_idl_omit_alert(idl, &ovsrec_mac_col_from);
+    }
+
+    l2macd_engine_setup();
 } /* l2macd_ovsdb_init */
 
 /*-----------------------------------------------------------------------------
@@ -145,8 +486,129 @@ l2macd_cache_init(void)
     ovs_assert(g_l2macd_cache != NULL);
     hmap_init(&g_l2macd_cache->vlan_table);
     hmap_init(&g_l2macd_cache->port_table);
+
+    sset_init(&g_flush_batch.ports);
+    g_flush_batch.vlans = bitmap_allocate(L2MACD_VLAN_BITMAP_SIZE);
+    shash_init(&g_flush_batch.port_vlans);
+
+    shash_init(&g_standby.ports);
+    shash_init(&g_standby.port_vlans);
 }   /* l2macd_cache_init */
 
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_cache_restore
+ | Responsibility: Seed the cache with the latest checkpoint. The restored
+ |                 state is reconciled with the DB once the system is
+ |                 configured
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_cache_restore(void)
+{
+    const struct l2macd_ckpt_slot *slot = l2macd_ckpt_latest();
+    uint32_t i;
+
+    if (slot == NULL) {
+        VLOG_INFO("No cache checkpoint, starting with an empty cache");
+        return;
+    }
+
+    hmap_reserve(&g_l2macd_cache->port_table, slot->n_ports);
+    hmap_reserve(&g_l2macd_cache->vlan_table, slot->n_vlans);
+
+    for (i = 0; i < slot->n_ports; i++) {
+        const struct l2macd_ckpt_port *ckpt_port = &slot->ports[i];
+        struct port_data *port_data = xzalloc(sizeof *port_data);
+
+        port_data->name = xmemdup0(ckpt_port->name,
+                                   strnlen(ckpt_port->name,
+                                           sizeof ckpt_port->name));
+        port_data->link_state = ckpt_port->link_state;
+        hmap_insert(&g_l2macd_cache->port_table, &port_data->hmap_node,
+                    hash_string(port_data->name, 0));
+    }
+
+    for (i = 0; i < slot->n_vlans; i++) {
+        const struct l2macd_ckpt_vlan *ckpt_vlan = &slot->vlans[i];
+        struct vlan_data *vlan_data = xzalloc(sizeof *vlan_data);
+
+        vlan_data->vlan_id = ckpt_vlan->vlan_id;
+        vlan_data->op_state = ckpt_vlan->op_state;
+        hmap_insert(&g_l2macd_cache->vlan_table, &vlan_data->hmap_node,
+                    hash_int(vlan_data->vlan_id, 0));
+    }
+
+    VLOG_INFO("Restored cache checkpoint generation %"PRIu64": %u ports, "
+              "%u vlans", slot->generation, slot->n_ports, slot->n_vlans);
+}   /* l2macd_cache_restore */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_cache_checkpoint
+ | Responsibility: Write the cache to the checkpoint file
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_cache_checkpoint(void)
+{
+    struct l2macd_ckpt_slot *slot;
+    const struct port_data *port;
+    const struct vlan_data *vlan;
+
+    cache_dirty = false;
+    next_ckpt_msec = time_msec() + L2MACD_CKPT_INTERVAL_MSEC;
+
+    /* Never save a restored cache before it has been reconciled, nor
+     * invalidate the slot holding the checkpoint it was restored from. */
+    if (!cache_synced) {
+        return;
+    }
+
+    slot = l2macd_ckpt_begin();
+    if (slot == NULL) {
+        return;
+    }
+
+    HMAP_FOR_EACH (port, hmap_node, &g_l2macd_cache->port_table) {
+        struct l2macd_ckpt_port *ckpt_port;
+
+        if (slot->n_ports >= L2MACD_CKPT_MAX_PORTS
+            || strlen(port->name) >= sizeof ckpt_port->name) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+            /* The port is then handled as a new port after a restart. */
+            VLOG_WARN_RL(&rl, "%s: port %s not saved", __FUNCTION__,
+                         port->name);
+            continue;
+        }
+
+        ckpt_port = &slot->ports[slot->n_ports++];
+        ovs_strlcpy(ckpt_port->name, port->name, sizeof ckpt_port->name);
+        ckpt_port->link_state = port->link_state;
+    }
+
+    HMAP_FOR_EACH (vlan, hmap_node, &g_l2macd_cache->vlan_table) {
+        struct l2macd_ckpt_vlan *ckpt_vlan;
+
+        if (slot->n_vlans >= L2MACD_CKPT_MAX_VLANS) {
+            break;
+        }
+
+        ckpt_vlan = &slot->vlans[slot->n_vlans++];
+        ckpt_vlan->vlan_id = vlan->vlan_id;
+        ckpt_vlan->op_state = vlan->op_state;
+    }
+
+    l2macd_ckpt_commit(slot);
+}   /* l2macd_cache_checkpoint */
+
 /*-----------------------------------------------------------------------------
  | Function: l2macd_ovsdb_exit
  | Responsibility: l2macd exit function
@@ -162,502 +624,2728 @@ l2macd_ovsdb_exit(void)
     struct port_data *port, *next_port;
     struct vlan_data *vlan, *next_vlan;
 
+    /* Save the latest state for the next start. */
+    if (g_standby.lock_held && cache_dirty) {
+        l2macd_cache_checkpoint();
+    }
+
     /* Free port table. */
     HMAP_FOR_EACH_SAFE (port, next_port, hmap_node,
                         &g_l2macd_cache->port_table) {
+        hmap_remove(&g_l2macd_cache->port_table, &port->hmap_node);
+        free(port->name);
         free(port);
     }
 
     /* Free vlan table.*/
     HMAP_FOR_EACH_SAFE (vlan, next_vlan, hmap_node,
                         &g_l2macd_cache->vlan_table) {
+        hmap_remove(&g_l2macd_cache->vlan_table, &vlan->hmap_node);
         free(vlan);
     }
 
     hmap_destroy(&g_l2macd_cache->vlan_table);
     hmap_destroy(&g_l2macd_cache->port_table);
+    iface_ports_clear();
+    hmap_destroy(&g_iface_ports);
     free(g_l2macd_cache);
+
+    sset_destroy(&g_flush_batch.ports);
+    bitmap_free(g_flush_batch.vlans);
+    flush_batch_clear_port_vlans(&g_flush_batch);
+    shash_destroy(&g_flush_batch.port_vlans);
+
+    shash_destroy_free_data(&g_standby.ports);
+    free(g_hold.pidfile);
+    standby_clear_port_vlans();
+    shash_destroy(&g_standby.port_vlans);
+    l2macd_mac_destroy();
+    if (g_warm.path) {
+        l2macd_warm_destroy(&g_warm.snap);
+        free(g_warm.path);
+        free(g_warm.seed_path);
+    }
+    sched_purge(true, true);
     ovsdb_idl_destroy(idl);
 } /* l2macd_ovsdb_exit */
 
 
 /*-----------------------------------------------------------------------------
- | Function: mac_flush_by_port
- | Responsibility: Trigger mac flush on specific port by setting mac_invalid column
+ | Function: flush_batch_is_empty
+ | Responsibility: Check for pending flush requests
  | Parameters:
- |      port_row: port row in the idl
+ |      batch: flush batch
  | Return:
- |      None
+ |      bool : true if nothing is to be flushed
      ------------------------------------------------------------------------------
  */
-static void
-mac_flush_by_port(const struct ovsrec_port *port_row)
+static inline bool
+flush_batch_is_empty(const struct flush_batch *batch)
 {
-    struct ovsdb_idl_txn *txn = NULL;
-    enum ovsdb_idl_txn_status status = TXN_SUCCESS;
-    bool mac_invalid = true;
-
-    if (port_row == NULL)   {
-        return;
-    }
-
-    txn = ovsdb_idl_txn_create(idl);
-
-    /* Set MAC flush request on this port */
-    ovsrec_port_set_macs_invalid(port_row, &mac_invalid, 1);
-    ovsrec_port_verify_macs_invalid(port_row);
-
-    ovsdb_idl_txn_add_comment(txn, "l2macd-%s-flush", port_row->name);
-    status = ovsdb_idl_txn_commit_block(txn);
-
-    VLOG_DBG("%s: flush %s \n", __FUNCTION__, port_row->name);
-
-    if (status != TXN_SUCCESS)    {
-        ovsdb_idl_txn_abort(txn);
-        VLOG_ERR("%s: txn_commit status %d \n",
-                 __FUNCTION__, status);
-    }
-
-    ovsdb_idl_txn_destroy(txn);
-
-}/* mac_flush_by_port */
+    return (sset_is_empty(&batch->ports)
+            && bitmap_is_all_zeros(batch->vlans, L2MACD_VLAN_BITMAP_SIZE)
+            && shash_is_empty(&batch->port_vlans));
+}   /* flush_batch_is_empty */
 
 /*-----------------------------------------------------------------------------
- | Function: check_system_iface
- | Responsibility: Checks interface is system type
+ | Function: flush_batch_add_vlan
+ | Responsibility: Request a mac flush on a VLAN
  | Parameters:
- |      port_row: port row in the idl
+ |      batch: flush batch
+ |      vid: VLAN ID
+ |      reason: why the VLAN is flushed
  | Return:
- |      bool : if the interface type is system, return true
+ |      None
      ------------------------------------------------------------------------------
  */
-static bool
-check_system_iface(const struct ovsrec_port *port)
+static inline void
+flush_batch_add_vlan(struct flush_batch *batch, int vid,
+                     enum l2macd_flush_reason reason)
 {
-    int i = 0;
-    bool rc = false;
-
-    if (port == NULL)   {
-        return rc;
+    if (vid < 0 || vid >= L2MACD_VLAN_BITMAP_SIZE
+        || bitmap_is_set(batch->vlans, vid)) {
+        return;
     }
 
-    for (i = 0; i < port->n_interfaces; i++) {
-        const char *type = port->interfaces[i]->type;
-        if (!strncmp(type, OVSREC_INTERFACE_TYPE_SYSTEM,
-                     strlen(OVSREC_INTERFACE_TYPE_SYSTEM))) {
-            rc = true;
-        }
+    if (flush_batch_is_empty(batch)) {
+        batch->first_msec = time_msec();
     }
-
-    return rc;
-}   /* check_system_iface */
+    bitmap_set1(batch->vlans, vid);
+    g_flush_stats.n_requests[reason]++;
+}   /* flush_batch_add_vlan */
 
 /*-----------------------------------------------------------------------------
- | Function: port_lookup
- | Responsibility: port lookup in the global cache
+ | Function: flush_batch_add_port
+ | Responsibility: Request a mac flush on a port
  | Parameters:
- |      port_hmap: ports hash map
+ |      batch: flush batch
  |      name: port name
+ |      reason: why the port is flushed
  | Return:
- |      port_data: return the port_data, if the specified port name exists
+ |      None
      ------------------------------------------------------------------------------
  */
-static struct port_data *
-port_lookup(const struct hmap* port_hmap, const char *name)
+static inline void
+flush_batch_add_port(struct flush_batch *batch, const char *name,
+                     enum l2macd_flush_reason reason)
 {
-    struct port_data *local_port = NULL;
-
-    if (port_hmap == NULL || name == NULL)   {
-        return local_port;
+    if (sset_contains(&batch->ports, name)) {
+        return;
     }
 
-    HMAP_FOR_EACH_WITH_HASH (local_port, hmap_node, hash_string(name, 0),
-                             port_hmap) {
-        if (!strncmp(local_port->name, name,
-                     strlen(name))) {
-            return local_port;
-        }
+    if (flush_batch_is_empty(batch)) {
+        batch->first_msec = time_msec();
     }
-
-    return local_port;
-}   /* port_lookup */
-
+    sset_add(&batch->ports, name);
+    g_flush_stats.n_requests[reason]++;
+}   /* flush_batch_add_port */
 
 /*-----------------------------------------------------------------------------
- | Function: update_port_state
- | Responsibility: Update the port details in the global cache and flush the mac
- |                      if port state is down
+ | Function: flush_batch_add_port_vlan
+ | Responsibility: Request a mac flush on a VLAN of a port
  | Parameters:
- |      port_row: port row in the idl
- |      port_data: port_data cache
+ |      batch: flush batch
+ |      name: port name
+ |      vid: VLAN ID
+ |      reason: why the port VLAN is flushed
  | Return:
  |      None
      ------------------------------------------------------------------------------
  */
 static void
-update_port_state(const struct ovsrec_port *port_row,
-                     struct port_data *port_data)
+flush_batch_add_port_vlan(struct flush_batch *batch, const char *name,
+                          int vid, enum l2macd_flush_reason reason)
 {
-    int i = 0;
-    bool link_up = false;
-    bool flush = false;
+    unsigned long *vlans;
 
-    if (port_row == NULL || port_data == NULL)   {
+    if (vid <= 0 || vid >= L2MACD_VLAN_BITMAP_SIZE
+        || sset_contains(&batch->ports, name)
+        || bitmap_is_set(batch->vlans, vid)) {
+        /* Covered by a wider flush. */
         return;
     }
 
-    /* Make sure all the interfaces part of the logical port is down.*/
-    for (i = 0; i < port_row->n_interfaces; i++) {
-        struct ovsrec_interface *iface_row = port_row->interfaces[i];
-
-        if (iface_row && iface_row->link_state &&
-            !strncmp(iface_row->link_state, OVSREC_INTERFACE_LINK_STATE_UP,
-                     strlen(OVSREC_INTERFACE_LINK_STATE_UP))) {
-            link_up = true;
-        }
+    vlans = shash_find_data(&batch->port_vlans, name);
+    if (vlans && bitmap_is_set(vlans, vid)) {
+        return;
     }
 
-    if (IS_CHANGED(port_data->link_state, link_up)) {
-        flush = true;
+    if (flush_batch_is_empty(batch)) {
+        batch->first_msec = time_msec();
     }
-
-    VLOG_DBG("%s: %s flush %d %d",
-              __FUNCTION__,
-              port_row->name, flush, link_up);
-
-    /* Flush only link down cases */
-    if (flush && !link_up){
-        mac_flush_by_port(port_row);
+    if (vlans == NULL) {
+        vlans = bitmap_allocate(L2MACD_VLAN_BITMAP_SIZE);
+        shash_add(&batch->port_vlans, name, vlans);
     }
-
-    /* Update link status */
-    port_data->link_state = link_up;
-}/* update_port_state */
+    bitmap_set1(vlans, vid);
+    g_flush_stats.n_requests[reason]++;
+}   /* flush_batch_add_port_vlan */
 
 /*-----------------------------------------------------------------------------
- | Function: update_port
- | Responsibility: Create/Update the port details in the global cache
+ | Function: flush_batch_clear_port_vlans
+ | Responsibility: Drop the port VLAN flush requests
  | Parameters:
- |      port_row: port row in the idl
+ |      batch: flush batch
  | Return:
  |      None
      ------------------------------------------------------------------------------
  */
 static void
-update_port(const struct ovsrec_port *port_row)
+flush_batch_clear_port_vlans(struct flush_batch *batch)
 {
-    struct port_data *port_data = NULL;
+    struct shash_node *node;
 
-    /* Check interface table for valid physical interface */
-    if (!check_system_iface(port_row))  {
-       VLOG_DBG("%s: %s interface type is not system",
-                 __FUNCTION__,
-                 port_row->name);
-       return;
+    SHASH_FOR_EACH (node, &batch->port_vlans) {
+        bitmap_free(node->data);
     }
+    shash_clear(&batch->port_vlans);
+}   /* flush_batch_clear_port_vlans */
 
-    port_data = port_lookup(&g_l2macd_cache->port_table, port_row->name);
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_flush_port_vlan
+ | Responsibility: Request a mac flush on a VLAN of a port, sent with the
+ |                 flush batch
+ | Parameters:
+ |      port_uuid: Port row UUID
+ |      vid: VLAN ID
+ |      reason: why the port VLAN is flushed
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_flush_port_vlan(const struct uuid *port_uuid, int vid,
+                       enum l2macd_flush_reason reason)
+{
+    const struct ovsrec_port *port_row;
 
-    if (!port_data)  {
-        port_data = xzalloc(sizeof *port_data);
-        port_data->name = xstrdup(port_row->name);
-        hmap_insert(&g_l2macd_cache->port_table, &port_data->hmap_node,
-                    hash_string(port_row->name, 0));
-        port_data->link_state= false;
+    port_row = ovsrec_port_get_for_uuid(idl, port_uuid);
+    if (port_row == NULL) {
+        return;
     }
 
-    update_port_state(port_row, port_data);
-
-    VLOG_DBG("%s: %s added count %zu", __FUNCTION__,
-              port_data->name, hmap_count(&g_l2macd_cache->port_table));
-} /* update_port */
+    VLOG_DBG("%s: flush %s vlan %d", __FUNCTION__, port_row->name, vid);
+    flush_batch_add_port_vlan(&g_flush_batch, port_row->name, vid, reason);
+}   /* l2macd_flush_port_vlan */
 
 /*-----------------------------------------------------------------------------
- | Function: del_old_port
- | Responsibility: Delete the port from the global cache
+ | Function: l2macd_flush_port
+ | Responsibility: Request a mac flush on a port, sent with the flush batch
  | Parameters:
- |      None
+ |      port_uuid: Port row UUID
+ |      reason: why the port is flushed
  | Return:
  |      None
- |Note : Don't access port_row, Track looses deleted port_row information except UUID
      ------------------------------------------------------------------------------
  */
-static void
-del_old_port(void)
+void
+l2macd_flush_port(const struct uuid *port_uuid,
+                  enum l2macd_flush_reason reason)
+{
+    const struct ovsrec_port *port_row;
+
+    port_row = ovsrec_port_get_for_uuid(idl, port_uuid);
+    if (port_row == NULL) {
+        return;
+    }
+
+    VLOG_DBG("%s: flush %s", __FUNCTION__, port_row->name);
+    flush_batch_add_port(&g_flush_batch, port_row->name, reason);
+}   /* l2macd_flush_port */
+
+/*-----------------------------------------------------------------------------
+ | Function: standby_record_port
+ | Responsibility: Record a port flush not sent while standby
+ | Parameters:
+ |      name: port name
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+standby_record_port(const char *name)
+{
+    long long int *when = shash_find_data(&g_standby.ports, name);
+
+    if (when == NULL) {
+        when = xmalloc(sizeof *when);
+        shash_add(&g_standby.ports, name, when);
+        g_standby.n_suppressed++;
+    }
+    *when = time_msec();
+}   /* standby_record_port */
+
+/*-----------------------------------------------------------------------------
+ | Function: standby_record_vlan
+ | Responsibility: Record a VLAN flush not sent while standby
+ | Parameters:
+ |      vid: VLAN ID
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+standby_record_vlan(int vid)
+{
+    if (vid >= 0 && vid < L2MACD_VLAN_BITMAP_SIZE) {
+        g_standby.n_suppressed += !g_standby.vlans[vid];
+        g_standby.vlans[vid] = time_msec();
+    }
+}   /* standby_record_vlan */
+
+/*-----------------------------------------------------------------------------
+ | Function: standby_record_port_vlans
+ | Responsibility: Record the VLAN flushes of a port not sent while standby
+ | Parameters:
+ |      name: port name
+ |      vlans: VLANs to flush
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+standby_record_port_vlans(const char *name, const unsigned long *vlans)
+{
+    struct standby_port_vlans *spv;
+    size_t vid;
+
+    spv = shash_find_data(&g_standby.port_vlans, name);
+    if (spv == NULL) {
+        spv = xzalloc(sizeof *spv);
+        spv->vlans = bitmap_allocate(L2MACD_VLAN_BITMAP_SIZE);
+        shash_add(&g_standby.port_vlans, name, spv);
+    }
+    BITMAP_FOR_EACH_1 (vid, L2MACD_VLAN_BITMAP_SIZE, vlans) {
+        if (!bitmap_is_set(spv->vlans, vid)) {
+            bitmap_set1(spv->vlans, vid);
+            g_standby.n_suppressed++;
+        }
+    }
+    spv->when = time_msec();
+}   /* standby_record_port_vlans */
+
+/*-----------------------------------------------------------------------------
+ | Function: standby_clear_port_vlans
+ | Responsibility: Drop the port VLAN flushes recorded while standby
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+standby_clear_port_vlans(void)
+{
+    struct shash_node *node;
+
+    SHASH_FOR_EACH (node, &g_standby.port_vlans) {
+        struct standby_port_vlans *spv = node->data;
+
+        bitmap_free(spv->vlans);
+        free(spv);
+    }
+    shash_clear(&g_standby.port_vlans);
+}   /* standby_clear_port_vlans */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_flush_by_port
+ | Responsibility: Trigger mac flush on specific port by setting mac_invalid column.
+ |                 The request is sent with the flush batch at the end of the
+ |                 current slice
+ | Parameters:
+ |      port_row: port row in the idl
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+mac_flush_by_port(const struct ovsrec_port *port_row)
+{
+    if (port_row == NULL)   {
+        return;
+    }
+
+    VLOG_DBG("%s: flush %s", __FUNCTION__, port_row->name);
+    flush_batch_add_port(&g_flush_batch, port_row->name,
+                         L2MACD_FLUSH_PORT_DOWN);
+}/* mac_flush_by_port */
+
+/*-----------------------------------------------------------------------------
+ | Function: check_system_iface
+ | Responsibility: Checks interface is system type
+ | Parameters:
+ |      port_row: port row in the idl
+ | Return:
+ |      bool : if the interface type is system, return true
+     ------------------------------------------------------------------------------
+ */
+static bool
+check_system_iface(const struct ovsrec_port *port)
+{
+    int i = 0;
+    bool rc = false;
+
+    if (port == NULL)   {
+        return rc;
+    }
+
+    for (i = 0; i < port->n_interfaces; i++) {
+        const char *type = port->interfaces[i]->type;
+        if (!strncmp(type, OVSREC_INTERFACE_TYPE_SYSTEM,
+                     strlen(OVSREC_INTERFACE_TYPE_SYSTEM))) {
+            rc = true;
+        }
+    }
+
+    return rc;
+}   /* check_system_iface */
+
+/*-----------------------------------------------------------------------------
+ | Function: port_lookup
+ | Responsibility: port lookup in the global cache
+ | Parameters:
+ |      port_hmap: ports hash map
+ |      name: port name
+ | Return:
+ |      port_data: return the port_data, if the specified port name exists
+     ------------------------------------------------------------------------------
+ */
+static struct port_data *
+port_lookup(const struct hmap* port_hmap, const char *name)
+{
+    struct port_data *local_port = NULL;
+
+    if (port_hmap == NULL || name == NULL)   {
+        return local_port;
+    }
+
+    HMAP_FOR_EACH_WITH_HASH (local_port, hmap_node, hash_string(name, 0),
+                             port_hmap) {
+        if (!strncmp(local_port->name, name,
+                     strlen(name))) {
+            return local_port;
+        }
+    }
+
+    return local_port;
+}   /* port_lookup */
+
+
+/*-----------------------------------------------------------------------------
+ | Function: port_link_up
+ | Responsibility: Get the link status of a logical port
+ | Parameters:
+ |      port_row: port row in the idl
+ | Return:
+ |      bool : false if all the interfaces of the port are down
+     ------------------------------------------------------------------------------
+ */
+static bool
+port_link_up(const struct ovsrec_port *port_row)
+{
+    int i = 0;
+
+    for (i = 0; i < port_row->n_interfaces; i++) {
+        struct ovsrec_interface *iface_row = port_row->interfaces[i];
+
+        if (iface_row && iface_row->link_state &&
+            !strncmp(iface_row->link_state, OVSREC_INTERFACE_LINK_STATE_UP,
+                     strlen(OVSREC_INTERFACE_LINK_STATE_UP))) {
+            return true;
+        }
+    }
+
+    return false;
+}   /* port_link_up */
+
+/*-----------------------------------------------------------------------------
+ | Function: update_port_state
+ | Responsibility: Update the port details in the global cache and flush the mac
+ |                      if port state is down
+ | Parameters:
+ |      port_row: port row in the idl
+ |      port_data: port_data cache
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+update_port_state(const struct ovsrec_port *port_row,
+                     struct port_data *port_data)
+{
+    bool link_up = false;
+    bool flush = false;
+
+    if (port_row == NULL || port_data == NULL)   {
+        return;
+    }
+
+    link_up = port_link_up(port_row);
+
+    if (IS_CHANGED(port_data->link_state, link_up)) {
+        flush = true;
+    }
+
+    VLOG_DBG("%s: %s flush %d %d",
+              __FUNCTION__,
+              port_row->name, flush, link_up);
+
+    /* Flush only link down cases */
+    if (flush && !link_up){
+        mac_flush_by_port(port_row);
+    }
+
+    /* Update link status */
+    if (port_data->link_state != link_up) {
+        cache_dirty = true;
+    }
+    port_data->link_state = link_up;
+}/* update_port_state */
+
+/*-----------------------------------------------------------------------------
+ | Function: update_port
+ | Responsibility: Create/Update the port details in the global cache
+ | Parameters:
+ |      port_row: port row in the idl
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+update_port(const struct ovsrec_port *port_row)
+{
+    struct port_data *port_data = NULL;
+
+    /* Check interface table for valid physical interface */
+    if (!check_system_iface(port_row))  {
+       VLOG_DBG("%s: %s interface type is not system",
+                 __FUNCTION__,
+                 port_row->name);
+       return;
+    }
+
+    port_data = port_lookup(&g_l2macd_cache->port_table, port_row->name);
+
+    if (!port_data)  {
+        port_data = xzalloc(sizeof *port_data);
+        port_data->name = xstrdup(port_row->name);
+        hmap_insert(&g_l2macd_cache->port_table, &port_data->hmap_node,
+                    hash_string(port_row->name, 0));
+        port_data->link_state= false;
+        cache_dirty = true;
+    }
+
+    update_port_state(port_row, port_data);
+
+    VLOG_DBG("%s: %s added count %zu", __FUNCTION__,
+              port_data->name, hmap_count(&g_l2macd_cache->port_table));
+} /* update_port */
+
+/*-----------------------------------------------------------------------------
+ | Function: del_old_port
+ | Responsibility: Delete the port from the global cache
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ |Note : Don't access port_row, Track looses deleted port_row information except UUID
+     ------------------------------------------------------------------------------
+ */
+static void
+del_old_port(void)
 {
     struct shash all_ports;
     const struct ovsrec_port *ports = NULL;
     struct port_data *port_data = NULL, *next_port_data = NULL;
 
-    shash_init(&all_ports);
-    OVSREC_PORT_FOR_EACH(ports, idl)    {
-        const char *name = ports->name;
-        if (!shash_add_once(&all_ports, name, ports)) {
-            VLOG_WARN("port %s specified twice ", name);
-        }
+    shash_init(&all_ports);
+    OVSREC_PORT_FOR_EACH(ports, idl)    {
+        const char *name = ports->name;
+        if (!shash_add_once(&all_ports, name, ports)) {
+            VLOG_WARN("port %s specified twice ", name);
+        }
+    }
+
+    HMAP_FOR_EACH_SAFE (port_data, next_port_data, hmap_node,
+                        &g_l2macd_cache->port_table) {
+        /* Check port is deleted */
+        if (shash_find_data(&all_ports, port_data->name) == NULL)   {
+            VLOG_DBG("%s: %s ports count %zu", __FUNCTION__,
+                      port_data->name,
+                      hmap_count(&g_l2macd_cache->port_table));
+            hmap_remove(&g_l2macd_cache->port_table, &port_data->hmap_node);
+            free(port_data->name);
+            free(port_data);
+            cache_dirty = true;
+        }
+    }
+
+    /* Destroy ports hash */
+    shash_destroy(&all_ports);
+} /* del_old_port */
+
+/*-----------------------------------------------------------------------------
+ | Function: sched_enqueue
+ | Responsibility: Mark a changed row dirty. A row already dirty is only
+ |                 evaluated once, however many changes it received
+ | Parameters:
+ |      type: kind of change
+ |      uuid: row UUID
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+sched_enqueue(enum l2macd_work_type type, const struct uuid *uuid)
+{
+    uint32_t hash = uuid_hash(uuid);
+    struct l2macd_work *work;
+
+    g_sched.n_changes++;
+
+    HMAP_FOR_EACH_WITH_HASH (work, hmap_node, hash, &g_sched.dirty) {
+        if (uuid_equals(&work->uuid, uuid)) {
+            /* A delete supersedes any earlier change of the row. */
+            if (type == L2MACD_WORK_PORT_DEL || type == L2MACD_WORK_VLAN_DEL) {
+                work->type = type;
+            }
+            g_sched.n_dedup++;
+            return;
+        }
+    }
+
+    work = xmalloc(sizeof *work);
+    work->type = type;
+    work->uuid = *uuid;
+    list_push_back(&g_sched.queue, &work->list_node);
+    hmap_insert(&g_sched.dirty, &work->hmap_node, hash);
+
+    g_sched.n_queued++;
+    if (g_sched.n_queued > g_sched.max_queued) {
+        g_sched.max_queued = g_sched.n_queued;
+    }
+}   /* sched_enqueue */
+
+/*-----------------------------------------------------------------------------
+ | Function: sched_purge
+ | Responsibility: Drop the queued work of a table, its recompute covers it
+ | Parameters:
+ |      ports: drop the Port work
+ |      vlans: drop the VLAN work
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+sched_purge(bool ports, bool vlans)
+{
+    struct l2macd_work *work, *next;
+
+    LIST_FOR_EACH_SAFE (work, next, list_node, &g_sched.queue) {
+        bool is_port = (work->type == L2MACD_WORK_PORT
+                        || work->type == L2MACD_WORK_PORT_DEL);
+
+        if (is_port ? !ports : !vlans) {
+            continue;
+        }
+        list_remove(&work->list_node);
+        hmap_remove(&g_sched.dirty, &work->hmap_node);
+        free(work);
+        g_sched.n_queued--;
+    }
+    g_sched.sweep_ports &= !ports;
+    g_sched.sweep_vlans &= !vlans;
+}   /* sched_purge */
+
+/*-----------------------------------------------------------------------------
+ | Function: port_cache_port_handler
+ | Responsibility: Engine handler queueing the tracked Port changes
+ | Parameters:
+ |      node: port_cache engine node
+ | Return:
+ |      bool : false if the port cache is cheaper to recompute
+     ------------------------------------------------------------------------------
+ */
+static bool
+port_cache_port_handler(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_port *port_row = NULL;
+    size_t n_tracked = 0;
+
+    OVSREC_PORT_FOR_EACH_TRACKED(port_row, idl) {
+        n_tracked++;
+    }
+    if (n_tracked >= L2MACD_ENGINE_RECOMPUTE_MIN
+        && n_tracked > hmap_count(&g_l2macd_cache->port_table) / 2) {
+        return false;
+    }
+
+    /* Track all the ports changes in the DB. Several IDL runs may have been
+     * drained since the last pass, so compare with the last handled seqno.
+     */
+    OVSREC_PORT_FOR_EACH_TRACKED(port_row, idl) {
+        /* Delete ports from the cache. */
+        if(ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_DELETE)
+                   > idl_seqno)  {
+            sched_enqueue(L2MACD_WORK_PORT_DEL, &port_row->header_.uuid);
+            continue;
+        }
+
+        /* Add new ports or update modified ports to the cache. */
+        if(ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_INSERT)
+                           > idl_seqno
+           || ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_MODIFY)
+                   > idl_seqno)  {
+            sched_enqueue(L2MACD_WORK_PORT, &port_row->header_.uuid);
+        }
+    }
+
+    node->changed = true;
+    return true;
+} /* port_cache_port_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: iface_ports_clear
+ | Responsibility: Empty the interface to port index
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+iface_ports_clear(void)
+{
+    struct iface_port *ip, *next;
+
+    HMAP_FOR_EACH_SAFE (ip, next, hmap_node, &g_iface_ports) {
+        hmap_remove(&g_iface_ports, &ip->hmap_node);
+        free(ip);
+    }
+}   /* iface_ports_clear */
+
+/*-----------------------------------------------------------------------------
+ | Function: iface_ports_update
+ | Responsibility: Rebuild the interface to port index if the interfaces of
+ |                 a port changed since the last pass
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+iface_ports_update(void)
+{
+    const struct ovsrec_port *port_row = NULL;
+    size_t i;
+
+    OVSREC_PORT_FOR_EACH_TRACKED(port_row, idl) {
+        if (ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_DELETE)
+                   > idl_seqno
+            || ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_INSERT)
+                   > idl_seqno
+            || ovsrec_port_is_updated(port_row, OVSREC_PORT_COL_INTERFACES)) {
+            iface_ports_stale = true;
+            break;
+        }
+    }
+
+    if (!iface_ports_stale) {
+        return;
+    }
+
+    iface_ports_clear();
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        for (i = 0; i < port_row->n_interfaces; i++) {
+            struct iface_port *ip = xmalloc(sizeof *ip);
+
+            ip->iface_uuid = port_row->interfaces[i]->header_.uuid;
+            ip->port_uuid = port_row->header_.uuid;
+            hmap_insert(&g_iface_ports, &ip->hmap_node,
+                        uuid_hash(&ip->iface_uuid));
+        }
+    }
+    iface_ports_stale = false;
+}   /* iface_ports_update */
+
+/*-----------------------------------------------------------------------------
+ | Function: iface_port_find
+ | Responsibility: Find the port of an interface
+ | Parameters:
+ |      iface_uuid: Interface row UUID
+ | Return:
+ |      Port row UUID, NULL if the interface is in no port
+     ------------------------------------------------------------------------------
+ */
+static const struct uuid *
+iface_port_find(const struct uuid *iface_uuid)
+{
+    const struct iface_port *ip;
+
+    HMAP_FOR_EACH_WITH_HASH (ip, hmap_node, uuid_hash(iface_uuid),
+                             &g_iface_ports) {
+        if (uuid_equals(&ip->iface_uuid, iface_uuid)) {
+            return &ip->port_uuid;
+        }
+    }
+    return NULL;
+}   /* iface_port_find */
+
+/*-----------------------------------------------------------------------------
+ | Function: port_cache_iface_handler
+ | Responsibility: Engine handler queueing the ports of the changed
+ |                 interfaces
+ | Parameters:
+ |      node: port_cache engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+port_cache_iface_handler(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_interface *iface_row = NULL;
+
+    iface_ports_update();
+
+    /* Interfaces added to or removed from a port change the port, which
+     * port_cache_port_handler() queues. */
+    OVSREC_INTERFACE_FOR_EACH_TRACKED(iface_row, idl) {
+        const struct uuid *port_uuid;
+
+        if (!OVSREC_IDL_IS_ROW_MODIFIED(iface_row, idl_seqno)) {
+            continue;
+        }
+        port_uuid = iface_port_find(&iface_row->header_.uuid);
+        if (port_uuid) {
+            sched_enqueue(L2MACD_WORK_PORT, port_uuid);
+            node->changed = true;
+        }
+    }
+
+    return true;
+} /* port_cache_iface_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_flush_by_vlan
+ | Responsibility: Triggers the mac flush on the spcified vlan by setting mac_invalid column.
+ |                 The request is sent with the flush batch at the end of the
+ |                 current slice
+ | Parameters:
+ |      vlan_row: VLAN row in the IDL
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+mac_flush_by_vlan(const struct ovsrec_vlan *vlan_row)
+{
+    if (vlan_row == NULL)   {
+        return;
+    }
+
+    VLOG_DBG("%s: flush vlan %" PRIi64, __FUNCTION__, vlan_row->id);
+    flush_batch_add_vlan(&g_flush_batch, vlan_row->id, L2MACD_FLUSH_VLAN_DOWN);
+} /* mac_flush_by_vlan */
+
+/*-----------------------------------------------------------------------------
+ | Function: vlan_oper_up
+ | Responsibility: Get the operational status of a VLAN
+ | Parameters:
+ |      row: VLAN row in the idl
+ | Return:
+ |      bool : true if the VLAN is operationally up
+     ------------------------------------------------------------------------------
+ */
+static inline bool
+vlan_oper_up(const struct ovsrec_vlan *row)
+{
+    return (row->oper_state &&
+            !strncmp(OVSREC_VLAN_OPER_STATE_UP, row->oper_state,
+                     strlen(OVSREC_VLAN_OPER_STATE_UP)));
+}   /* vlan_oper_up */
+
+/*-----------------------------------------------------------------------------
+ | Function: update_vlan_state
+ | Responsibility: Update the VLAN details in the global cache and flush the mac
+ |                      if VLAN state is down
+ | Parameters:
+ |      row: VLAN row in the idl
+ |      vlan_data: vlan_data cache
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+update_vlan_state(const struct ovsrec_vlan *row, struct vlan_data *vlan_ptr)
+{
+    bool prev_op_up = false, op_up = false;
+
+    if (row == NULL || vlan_ptr == NULL)   {
+        return;
+    }
+
+    vlan_ptr->vlan_id = (int) row->id;
+    prev_op_up = vlan_ptr->op_state;
+    op_up = vlan_oper_up(row);
+
+    /* Flush only VLAN operational down cases. The row may be evaluated a
+     * few passes after its change, so the cached state is compared. */
+    if (prev_op_up == true && op_up == false) {
+        mac_flush_by_vlan(row);
+    }
+
+    /* Update the VLAN oper_state */
+    if (vlan_ptr->op_state != op_up) {
+        cache_dirty = true;
+    }
+    vlan_ptr->op_state = op_up;
+} /* update_vlan_state */
+
+
+/*-----------------------------------------------------------------------------
+ | Function: vlan_lookup_by_vid
+ | Responsibility: VLAN lookup in the global cache
+ | Parameters:
+ |      vlan_hmap: VLANs hash map
+ |      vid: VLAN ID
+ | Return:
+ |      vlan_data: return the vlan_data, if the specified vlan exists
+     ------------------------------------------------------------------------------
+ */
+static inline struct vlan_data *
+vlan_lookup_by_vid(const struct hmap* vlan_hmap, int vid)
+{
+    struct vlan_data *vlan = NULL;
+
+    if (vlan_hmap == NULL)   {
+        return vlan;
+    }
+
+    HMAP_FOR_EACH_WITH_HASH (vlan, hmap_node, hash_int(vid, 0), vlan_hmap) {
+        if (vlan->vlan_id == vid) {
+            return vlan;
+        }
+    }
+    return vlan;
+}
+
+/*-----------------------------------------------------------------------------
+ | Function: update_vlan
+ | Responsibility: Create/Update the VLAN details in the global cache
+ | Parameters:
+ |      vlan_row: VLAN row in the idl
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+update_vlan(const struct ovsrec_vlan *vlan_row)
+{
+    struct vlan_data *new_vlan = NULL;
+
+    if (vlan_row == NULL)   {
+        return;
+    }
+
+    new_vlan = vlan_lookup_by_vid(&g_l2macd_cache->vlan_table,
+                                  vlan_row->id);
+    if(!new_vlan)  {
+        /* Allocate structure to save state information for this VLAN. */
+        new_vlan = xzalloc(sizeof(struct vlan_data));
+        new_vlan->vlan_id = (int) vlan_row->id;
+        new_vlan->op_state= false;
+        hmap_insert(&g_l2macd_cache->vlan_table, &new_vlan->hmap_node,
+                        hash_int(vlan_row->id, 0));
+        cache_dirty = true;
+    }
+
+    /* Update VLAN configuration into internal format. */
+    update_vlan_state(vlan_row, new_vlan);
+
+    VLOG_DBG("%s: %d, hmap count %zu", __FUNCTION__, (int)vlan_row->id,
+             hmap_count(&g_l2macd_cache->vlan_table));
+} /* add_new_vlan */
+
+/*-----------------------------------------------------------------------------
+ | Function: del_old_vlan
+ | Responsibility: Delete the VLAN from the global cache
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ |Note : Don't access vlan_row, Track looses deleted vlan_row information except UUID
+     ------------------------------------------------------------------------------
+ */
+static void
+del_old_vlan(void)
+{
+    const struct ovsrec_vlan *vlan_row = NULL;
+    struct vlan_data *vlan = NULL, *vlan_next = NULL;
+    bool vlan_found = false;
+
+    /* Check all the VLANs present in the DB. */
+    HMAP_FOR_EACH_SAFE (vlan, vlan_next, hmap_node,
+                        &g_l2macd_cache->vlan_table) {
+
+        vlan_found = false;
+        OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+            if ((vlan->vlan_id == vlan_row->id)) {
+                vlan_found = true;
+                break;
+            }
+        }
+
+        /* Handle deleted vlans */
+        if (vlan_found == false)   {
+            VLOG_DBG("%s: vlan_id %d hmap count %zu", __FUNCTION__,
+                      vlan->vlan_id,
+                      hmap_count(&g_l2macd_cache->vlan_table));
+            hmap_remove(&g_l2macd_cache->vlan_table,
+                        &vlan->hmap_node);
+            /* Free the VLAN data */
+            free(vlan);
+            cache_dirty = true;
+
+        }
+    }
+
+    VLOG_DBG("%s: hmap count %zu", __FUNCTION__,
+              hmap_count(&g_l2macd_cache->vlan_table));
+} /* del_old_vlan */
+
+/*-----------------------------------------------------------------------------
+ | Function: vlan_cache_vlan_handler
+ | Responsibility: Engine handler queueing the tracked VLAN changes
+ | Parameters:
+ |      node: vlan_cache engine node
+ | Return:
+ |      bool : false if the VLAN cache is cheaper to recompute
+     ------------------------------------------------------------------------------
+ */
+static bool
+vlan_cache_vlan_handler(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_vlan *vlan_row;
+    size_t n_tracked = 0;
+
+    OVSREC_VLAN_FOR_EACH_TRACKED(vlan_row, idl) {
+        n_tracked++;
+    }
+    if (n_tracked >= L2MACD_ENGINE_RECOMPUTE_MIN
+        && n_tracked > hmap_count(&g_l2macd_cache->vlan_table) / 2) {
+        return false;
+    }
+
+    /* Track all the VLAN changes in the DB. */
+    OVSREC_VLAN_FOR_EACH_TRACKED(vlan_row, idl) {
+        /* Delete VLAN from the cache */
+        if(ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_DELETE)
+                           > idl_seqno)  {
+            sched_enqueue(L2MACD_WORK_VLAN_DEL, &vlan_row->header_.uuid);
+            continue;
+        }
+
+        /* Add new VLAN or update modified VLAN to the cache */
+        if(ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_INSERT)
+                           > idl_seqno
+           || ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_MODIFY)
+                           > idl_seqno)  {
+            sched_enqueue(L2MACD_WORK_VLAN, &vlan_row->header_.uuid);
+        }
+    }
+
+    node->changed = true;
+    return true;
+} /* vlan_cache_vlan_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: flush_batch_commit
+ | Responsibility: Send all the pending flush requests in one transaction
+ | Parameters:
+ |      batch: flush batch
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+flush_batch_commit(struct flush_batch *batch)
+{
+    const struct ovsrec_port *port_row = NULL;
+    const struct ovsrec_vlan *vlan_row = NULL;
+    struct ovsdb_idl_txn *txn = NULL;
+    enum ovsdb_idl_txn_status status = TXN_SUCCESS;
+    enum l2macd_phase phase;
+    bool mac_invalid = true;
+    size_t n_ports = 0, n_vlans = 0;
+
+    if (flush_batch_is_empty(batch)) {
+        return;
+    }
+
+    if (g_hold.active && ovsdb_idl_has_lock(idl)) {
+        /* Sent at the end of the ops-switchd restart window. */
+        return;
+    }
+
+    if (!ovsdb_idl_has_lock(idl)) {
+        struct shash_node *node;
+        const char *name;
+        size_t vid;
+
+        SSET_FOR_EACH (name, &batch->ports) {
+            standby_record_port(name);
+        }
+        BITMAP_FOR_EACH_1 (vid, L2MACD_VLAN_BITMAP_SIZE, batch->vlans) {
+            standby_record_vlan(vid);
+        }
+        SHASH_FOR_EACH (node, &batch->port_vlans) {
+            standby_record_port_vlans(node->name, node->data);
+        }
+        goto out;
+    }
+
+    if (batch->n_failures && time_msec() < batch->retry_msec) {
+        return;
+    }
+
+    txn = ovsdb_idl_txn_create(idl);
+
+    if (!sset_is_empty(&batch->ports) || !shash_is_empty(&batch->port_vlans)) {
+        OVSREC_PORT_FOR_EACH(port_row, idl) {
+            unsigned long *vlans;
+
+            if (sset_contains(&batch->ports, port_row->name)) {
+                ovsrec_port_set_macs_invalid(port_row, &mac_invalid, 1);
+                n_ports++;
+                continue;
+            }
+
+            vlans = shash_find_data(&batch->port_vlans, port_row->name);
+            if (vlans) {
+                unsigned long *merged;
+                int64_t *vids;
+                size_t n = 0, i;
+                size_t vid;
+
+                /* Keep the requests ops-switchd has not handled yet. The
+                 * column is verified, as ops-switchd clears it meanwhile. */
+                merged = bitmap_clone(vlans, L2MACD_VLAN_BITMAP_SIZE);
+                for (i = 0; i < port_row->n_macs_invalid_on_vlans; i++) {
+                    int64_t pending = port_row->macs_invalid_on_vlans[i];
+
+                    if (pending > 0 && pending < L2MACD_VLAN_BITMAP_SIZE) {
+                        bitmap_set1(merged, pending);
+                    }
+                }
+                vids = xmalloc(bitmap_count1(merged, L2MACD_VLAN_BITMAP_SIZE)
+                               * sizeof *vids);
+                BITMAP_FOR_EACH_1 (vid, L2MACD_VLAN_BITMAP_SIZE, merged) {
+                    vids[n++] = vid;
+                }
+                ovsrec_port_verify_macs_invalid_on_vlans(port_row);
+                ovsrec_port_set_macs_invalid_on_vlans(port_row, vids, n);
+                free(vids);
+                bitmap_free(merged);
+                n_ports++;
+            }
+        }
+    }
+
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        if (vlan_row->id >= 0 && vlan_row->id < L2MACD_VLAN_BITMAP_SIZE
+            && bitmap_is_set(batch->vlans, vlan_row->id)) {
+            ovsrec_vlan_set_macs_invalid(vlan_row, &mac_invalid, 1);
+            n_vlans++;
+        }
+    }
+
+    ovsdb_idl_txn_add_comment(txn, "l2macd-batch-flush");
+    phase = l2macd_profile_enter(L2MACD_PHASE_COMMIT);
+    status = ovsdb_idl_txn_commit_block(txn);
+    l2macd_profile_enter(phase);
+
+    VLOG_DBG("%s: flush %zu ports %zu vlans status %d", __FUNCTION__,
+             n_ports, n_vlans, status);
+
+    g_flush_stats.n_txns++;
+    if (status == TXN_TRY_AGAIN) {
+        /* A verified column changed, the batch is kept and sent again
+         * with the new DB contents on the next pass. */
+        VLOG_DBG("%s: flush batch retried", __FUNCTION__);
+        ovsdb_idl_txn_destroy(txn);
+        return;
+    }
+
+    /* Unchanged when every request was already pending in the DB. */
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        ovsdb_idl_txn_abort(txn);
+        ovsdb_idl_txn_destroy(txn);
+        g_flush_stats.n_txn_errors++;
+
+        /* The batch is kept and sent again on a later pass. */
+        if (++batch->n_failures < L2MACD_FLUSH_MAX_FAILURES) {
+            VLOG_WARN_RL(&rl, "%s: txn_commit status %d, retrying in "
+                         "%d ms", __FUNCTION__, status,
+                         L2MACD_FLUSH_RETRY_MSEC);
+            batch->retry_msec = time_msec() + L2MACD_FLUSH_RETRY_MSEC;
+            return;
+        }
+        VLOG_ERR("%s: txn_commit status %d, dropping %zu port and %zu vlan "
+                 "flushes after %u attempts", __FUNCTION__, status,
+                 n_ports, n_vlans, batch->n_failures);
+        goto out;
+    } else {
+        long long int latency = time_msec() - batch->first_msec;
+        size_t i;
+
+        for (i = 0; i < L2MACD_N_LATENCY_BUCKETS; i++) {
+            if (latency <= flush_latency_bounds[i]) {
+                break;
+            }
+        }
+        g_flush_stats.latency_buckets[i]++;
+        g_flush_stats.latency_sum_msec += latency;
+        g_flush_stats.n_sent += n_ports + n_vlans;
+    }
+
+    ovsdb_idl_txn_destroy(txn);
+
+out:
+    batch->n_failures = 0;
+    sset_clear(&batch->ports);
+    flush_batch_clear_port_vlans(batch);
+    memset(batch->vlans, 0,
+           BITMAP_N_LONGS(L2MACD_VLAN_BITMAP_SIZE) * sizeof(unsigned long));
+}   /* flush_batch_commit */
+
+/*-----------------------------------------------------------------------------
+ | Function: standby_takeover
+ | Responsibility: Start acting as the active l2macd: send again the flushes
+ |                 recorded before the lock was acquired
+ | Parameters:
+ |      lock_msec: time the lock was seen acquired
+ |      contended: true if another instance held the lock, only the flushes
+ |                 recorded shortly before lock_msec are then sent
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+standby_takeover(long long int lock_msec, bool contended)
+{
+    struct shash_node *node, *next;
+    long long int since = (contended
+                           ? lock_msec - L2MACD_TAKEOVER_REPLAY_MSEC
+                           : LLONG_MIN);
+    int vid;
+
+    SHASH_FOR_EACH_SAFE (node, next, &g_standby.ports) {
+        long long int *when = node->data;
+
+        if (*when >= since) {
+            flush_batch_add_port(&g_flush_batch, node->name,
+                                 L2MACD_FLUSH_TAKEOVER);
+            g_standby.n_replayed++;
+        }
+        free(when);
+        shash_delete(&g_standby.ports, node);
+    }
+
+    for (vid = 0; vid < L2MACD_VLAN_BITMAP_SIZE; vid++) {
+        if (g_standby.vlans[vid] && g_standby.vlans[vid] >= since) {
+            flush_batch_add_vlan(&g_flush_batch, vid, L2MACD_FLUSH_TAKEOVER);
+            g_standby.n_replayed++;
+        }
+        g_standby.vlans[vid] = 0;
+    }
+
+    /* Only the time of the latest VLAN flush of a port is kept, all its
+     * VLANs are sent again if it is recent. */
+    SHASH_FOR_EACH (node, &g_standby.port_vlans) {
+        struct standby_port_vlans *spv = node->data;
+        size_t port_vid;
+
+        if (spv->when < since) {
+            continue;
+        }
+        BITMAP_FOR_EACH_1 (port_vid, L2MACD_VLAN_BITMAP_SIZE, spv->vlans) {
+            flush_batch_add_port_vlan(&g_flush_batch, node->name, port_vid,
+                                      L2MACD_FLUSH_TAKEOVER);
+            g_standby.n_replayed++;
+        }
+    }
+    standby_clear_port_vlans();
+
+    flush_batch_commit(&g_flush_batch);
+
+    if (!contended) {
+        return;
+    }
+
+    g_standby.n_takeovers++;
+    g_standby.takeover_msec = lock_msec;
+    g_standby.takeover_latency = time_msec() - lock_msec;
+
+    VLOG_INFO("Took over as active l2macd after %lld ms standby, "
+              "takeover latency %lld ms", lock_msec - g_standby.standby_since,
+              g_standby.takeover_latency);
+}   /* standby_takeover */
+
+/*-----------------------------------------------------------------------------
+ | Function: port_cache_recompute
+ | Responsibility: Engine recompute of the port cache. The cache, possibly
+ |                 restored from a checkpoint, is compared with the DB:
+ |                 ports which went down are flushed and entries whose row
+ |                 is gone are dropped
+ | Parameters:
+ |      node: port_cache engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+port_cache_recompute(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_interface *iface_row = NULL;
+    const struct ovsrec_port *port_row = NULL;
+    struct port_data *port_data = NULL, *next_port_data = NULL;
+    struct hmap old_ports;
+    size_t n_rows = 0;
+
+    /* The table supersedes the port changes still queued. */
+    sched_purge(true, false);
+    iface_ports_stale = true;
+
+    /* Previous contents are moved out and picked back by each row. */
+    hmap_init(&old_ports);
+    hmap_swap(&old_ports, &g_l2macd_cache->port_table);
+
+    g_sync_stats.n_iface_rows = 0;
+    g_sync_stats.n_system_ifaces = 0;
+    OVSREC_INTERFACE_FOR_EACH(iface_row, idl) {
+        g_sync_stats.n_iface_rows++;
+        if (iface_row->type
+            && !strcmp(iface_row->type, OVSREC_INTERFACE_TYPE_SYSTEM)) {
+            g_sync_stats.n_system_ifaces++;
+        }
+    }
+
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        n_rows++;
+    }
+    g_sync_stats.n_port_rows = n_rows;
+    hmap_reserve(&g_l2macd_cache->port_table, n_rows);
+
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        bool link_up;
+
+        if (!check_system_iface(port_row)) {
+            continue;
+        }
+
+        link_up = port_link_up(port_row);
+        port_data = port_lookup(&old_ports, port_row->name);
+        if (port_data) {
+            hmap_remove(&old_ports, &port_data->hmap_node);
+            if (port_data->link_state && !link_up) {
+                flush_batch_add_port(&g_flush_batch, port_row->name,
+                                     L2MACD_FLUSH_RESYNC);
+            }
+        } else {
+            port_data = xzalloc(sizeof *port_data);
+            port_data->name = xstrdup(port_row->name);
+        }
+        port_data->link_state = link_up;
+        hmap_insert(&g_l2macd_cache->port_table, &port_data->hmap_node,
+                    hash_string(port_data->name, 0));
+    }
+
+    /* Whatever is left has no row anymore. */
+    HMAP_FOR_EACH_SAFE (port_data, next_port_data, hmap_node, &old_ports) {
+        hmap_remove(&old_ports, &port_data->hmap_node);
+        free(port_data->name);
+        free(port_data);
+        g_sync_stats.n_stale++;
+    }
+    hmap_destroy(&old_ports);
+
+    node->changed = true;
+    cache_dirty = true;
+} /* port_cache_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: vlan_cache_recompute
+ | Responsibility: Engine recompute of the VLAN cache, see
+ |                 port_cache_recompute()
+ | Parameters:
+ |      node: vlan_cache engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+vlan_cache_recompute(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_vlan *vlan_row = NULL;
+    struct vlan_data *vlan_data = NULL, *next_vlan_data = NULL;
+    struct hmap old_vlans;
+    size_t n_rows = 0;
+
+    sched_purge(false, true);
+
+    hmap_init(&old_vlans);
+    hmap_swap(&old_vlans, &g_l2macd_cache->vlan_table);
+
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        n_rows++;
+    }
+    g_sync_stats.n_vlan_rows = n_rows;
+    hmap_reserve(&g_l2macd_cache->vlan_table, n_rows);
+
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        bool op_up = vlan_oper_up(vlan_row);
+
+        vlan_data = vlan_lookup_by_vid(&old_vlans, vlan_row->id);
+        if (vlan_data) {
+            hmap_remove(&old_vlans, &vlan_data->hmap_node);
+            if (vlan_data->op_state && !op_up) {
+                flush_batch_add_vlan(&g_flush_batch, vlan_row->id,
+                                     L2MACD_FLUSH_RESYNC);
+            }
+        } else {
+            vlan_data = xzalloc(sizeof *vlan_data);
+            vlan_data->vlan_id = (int) vlan_row->id;
+        }
+        vlan_data->op_state = op_up;
+        hmap_insert(&g_l2macd_cache->vlan_table, &vlan_data->hmap_node,
+                    hash_int(vlan_data->vlan_id, 0));
+    }
+
+    HMAP_FOR_EACH_SAFE (vlan_data, next_vlan_data, hmap_node, &old_vlans) {
+        hmap_remove(&old_vlans, &vlan_data->hmap_node);
+        free(vlan_data);
+        g_sync_stats.n_stale++;
+    }
+    hmap_destroy(&old_vlans);
+
+    node->changed = true;
+    cache_dirty = true;
+} /* vlan_cache_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_cache_recompute
+ | Responsibility: Engine recompute of the whole cache, run on the initial
+ |                 or a fresh snapshot once both tables are recomputed. The
+ |                 resulting flushes go in one transaction
+ | Parameters:
+ |      node: l2macd engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+l2macd_cache_recompute(struct l2macd_engine_node *node)
+{
+    g_sync_stats.sync_msec = time_msec() - g_sync_stats.start_msec;
+    if (!g_sync_stats.ready_msec) {
+        g_sync_stats.ready_msec = time_msec() - l2macd_start_msec;
+    }
+
+    VLOG_INFO("Replicated %zu interface rows (%zu system), %zu port rows, "
+              "%zu vlan rows", g_sync_stats.n_iface_rows,
+              g_sync_stats.n_system_ifaces, g_sync_stats.n_port_rows,
+              g_sync_stats.n_vlan_rows);
+    VLOG_INFO("Cache synced in %lld ms, ready %lld ms after start: "
+              "%zu ports, %zu vlans, %zu stale, %zu port and %zu vlan "
+              "flushes", g_sync_stats.sync_msec,
+              time_msec() - l2macd_start_msec,
+              hmap_count(&g_l2macd_cache->port_table),
+              hmap_count(&g_l2macd_cache->vlan_table), g_sync_stats.n_stale,
+              sset_count(&g_flush_batch.ports),
+              bitmap_count1(g_flush_batch.vlans, L2MACD_VLAN_BITMAP_SIZE));
+
+    flush_batch_commit(&g_flush_batch);
+
+    cache_synced = true;
+    node->changed = true;
+} /* l2macd_cache_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_cache_handler
+ | Responsibility: Engine handler for a change of the port or VLAN cache
+ |                 or of the MAC monitor. The queued work and the flushes
+ |                 are handled by sched_run_slice()
+ | Parameters:
+ |      node: l2macd engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+l2macd_cache_handler(struct l2macd_engine_node *node OVS_UNUSED)
+{
+    return true;
+} /* l2macd_cache_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_snapshot_reloaded
+ | Responsibility: Check whether the IDL has received a fresh snapshot since
+ |                 a reconnect
+ | Parameters:
+ |      since: IDL seqno before the reconnect
+ | Return:
+ |      bool : true if Port or VLAN rows were inserted after since
+     ------------------------------------------------------------------------------
+ */
+static bool
+l2macd_snapshot_reloaded(unsigned int since)
+{
+    const struct ovsrec_port *port_row = NULL;
+    const struct ovsrec_vlan *vlan_row = NULL;
+
+    OVSREC_PORT_FOR_EACH_TRACKED(port_row, idl) {
+        if (ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_INSERT)
+            > since) {
+            return true;
+        }
+    }
+
+    OVSREC_VLAN_FOR_EACH_TRACKED(vlan_row, idl) {
+        if (ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_INSERT)
+            > since) {
+            return true;
+        }
+    }
+
+    return false;
+}   /* l2macd_snapshot_reloaded */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_chk_for_reconnect
+ | Responsibility: Detect an OVSDB reconnect and schedule a full resync
+ | Parameters:
+ |      prev_seqno: IDL seqno before this run
+ |      lost_lock: the lock held at the last run is gone
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+l2macd_chk_for_reconnect(unsigned int prev_seqno, bool lost_lock)
+{
+    bool alive = ovsdb_idl_is_alive(idl);
+    bool reconnected = false;
+
+    if (g_conn.alive && !alive) {
+        VLOG_WARN("Connection to OVSDB lost");
+    } else if (!g_conn.alive && alive && cache_synced) {
+        reconnected = true;
+    }
+    g_conn.alive = alive;
+
+    /* The lock only goes away with the session, the reconnect may have
+     * happened within a single run. */
+    if (lost_lock && cache_synced) {
+        reconnected = true;
+    }
+
+    if (reconnected && !g_conn.resync_pending) {
+        g_conn.resync_pending = true;
+        g_conn.resync_seqno = prev_seqno;
+        g_conn.n_reconnects++;
+        g_conn.reconnect_msec = time_msec();
+        VLOG_INFO("Reconnected to OVSDB, resyncing the cache");
+    }
+}   /* l2macd_chk_for_reconnect */
+
+/*-----------------------------------------------------------------------------
+ | Function: switchd_poll
+ | Responsibility: Read the pid of ops-switchd, once per
+ |                 L2MACD_SWITCHD_POLL_MSEC at most
+ | Parameters:
+ |      None
+ | Return:
+ |      bool : true if ops-switchd runs and its pid is settled
+     ------------------------------------------------------------------------------
+ */
+static bool
+switchd_poll(void)
+{
+    long long int now = time_msec();
+    pid_t pid;
+
+    if (g_hold.pid >= 0 && now < g_hold.next_poll_msec) {
+        return (g_hold.pid > 0
+                && now - g_hold.pid_msec >= L2MACD_SWITCHD_SETTLE_MSEC);
+    }
+    g_hold.next_poll_msec = now + L2MACD_SWITCHD_POLL_MSEC;
+
+    if (g_hold.pidfile == NULL) {
+        g_hold.pidfile = xasprintf("%s/%s", ovs_rundir(),
+                                   L2MACD_SWITCHD_PIDFILE);
+    }
+    pid = read_pidfile(g_hold.pidfile);
+    if (pid < 0) {
+        pid = 0;
+    }
+
+    if (pid != g_hold.pid) {
+        /* An ops-switchd already running at start is settled. */
+        g_hold.pid_msec = (g_hold.pid < 0 ? LLONG_MIN : now);
+        g_hold.pid = pid;
+        if (pid > 0) {
+            VLOG_DBG("ops-switchd running, pid %ld", (long int) pid);
+        }
+    }
+
+    return (g_hold.pid > 0
+            && now - g_hold.pid_msec >= L2MACD_SWITCHD_SETTLE_MSEC);
+}   /* switchd_poll */
+
+/*-----------------------------------------------------------------------------
+ | Function: switchd_hold_end
+ | Responsibility: Send the flushes held during an ops-switchd restart for
+ |                 the ports and VLANs which are still down
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+switchd_hold_end(void)
+{
+    const char *name, *next_name;
+    size_t vid;
+    size_t n_ports = sset_count(&g_flush_batch.ports);
+    size_t n_vlans = bitmap_count1(g_flush_batch.vlans,
+                                   L2MACD_VLAN_BITMAP_SIZE);
+
+    g_hold.active = false;
+    g_hold.n_held += n_ports + n_vlans;
+
+    SSET_FOR_EACH_SAFE (name, next_name, &g_flush_batch.ports) {
+        const struct port_data *port = port_lookup(&g_l2macd_cache->port_table,
+                                                   name);
+        if (port == NULL || port->link_state) {
+            sset_delete(&g_flush_batch.ports, SSET_NODE_FROM_NAME(name));
+        }
+    }
+
+    BITMAP_FOR_EACH_1 (vid, L2MACD_VLAN_BITMAP_SIZE, g_flush_batch.vlans) {
+        const struct vlan_data *vlan =
+            vlan_lookup_by_vid(&g_l2macd_cache->vlan_table, vid);
+
+        if (vlan == NULL || vlan->op_state) {
+            bitmap_set0(g_flush_batch.vlans, vid);
+        }
+    }
+
+    VLOG_INFO("ops-switchd ready after %lld ms, %zu of %zu port and "
+              "%zu of %zu vlan flushes still needed",
+              time_msec() - g_hold.start_msec,
+              sset_count(&g_flush_batch.ports), n_ports,
+              bitmap_count1(g_flush_batch.vlans, L2MACD_VLAN_BITMAP_SIZE),
+              n_vlans);
+
+    flush_batch_commit(&g_flush_batch);
+}   /* switchd_hold_end */
+
+/*-----------------------------------------------------------------------------
+ | Function: switchd_hold_start
+ | Responsibility: Start holding the flushes while ops-switchd is not ready
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+switchd_hold_start(void)
+{
+    if (switchd_poll()) {
+        g_hold.expired = false;
+        return;
+    }
+
+    if (g_hold.active || g_hold.expired) {
+        return;
+    }
+
+    g_hold.active = true;
+    g_hold.start_msec = time_msec();
+    g_hold.n_windows++;
+    VLOG_INFO("ops-switchd %s, holding MAC flushes",
+              g_hold.pid > 0 ? "restarted" : "not running");
+}   /* switchd_hold_start */
+
+/*-----------------------------------------------------------------------------
+ | Function: switchd_hold_check
+ | Responsibility: End the hold once ops-switchd is ready again, or after
+ |                 L2MACD_SWITCHD_HOLD_MAX_MSEC at most
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+switchd_hold_check(void)
+{
+    if (!g_hold.active) {
+        return;
+    }
+
+    if (switchd_poll()) {
+        /* Check the held flushes once the backlog is evaluated. */
+        if (list_is_empty(&g_sched.queue)) {
+            switchd_hold_end();
+        }
+    } else if (time_msec() - g_hold.start_msec
+               >= L2MACD_SWITCHD_HOLD_MAX_MSEC) {
+        VLOG_WARN("ops-switchd still not ready after %d ms, "
+                  "sending held MAC flushes", L2MACD_SWITCHD_HOLD_MAX_MSEC);
+        g_hold.expired = true;
+        l2macd_profile_note(L2MACD_WAKEUP_TIMER);
+        switchd_hold_end();
+    }
+}   /* switchd_hold_check */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_has_tracked_changes
+ | Responsibility: Check whether any tracked row changed since the last pass
+ | Parameters:
+ |      None
+ | Return:
+ |      bool : true if a Port, VLAN, Interface, MAC or System row changed
+     ------------------------------------------------------------------------------
+ */
+static bool
+l2macd_has_tracked_changes(void)
+{
+    return (ovsrec_port_track_get_first(idl) != NULL
+            || ovsrec_vlan_track_get_first(idl) != NULL
+            || ovsrec_interface_track_get_first(idl) != NULL
+            || ovsrec_system_track_get_first(idl) != NULL
+            || (l2macd_mac_enabled()
+                && ovsrec_mac_track_get_first(idl) != NULL));
+}   /* l2macd_has_tracked_changes */
+
+/*-----------------------------------------------------------------------------
+ | Function: sched_run_slice
+ | Responsibility: Evaluate queued changes for L2MACD_SLICE_BUDGET_MSEC at
+ |                 most and send the resulting flushes
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+sched_run_slice(void)
+{
+    long long int start = time_msec();
+    struct l2macd_work *work;
+    size_t n = 0;
+
+    if (list_is_empty(&g_sched.queue)) {
+        /* A recomputed cache may have left flushes. */
+        flush_batch_commit(&g_flush_batch);
+        return;
     }
 
-    HMAP_FOR_EACH_SAFE (port_data, next_port_data, hmap_node,
-                        &g_l2macd_cache->port_table) {
-        /* Check port is deleted */
-        if (shash_find_data(&all_ports, port_data->name) == NULL)   {
-            VLOG_DBG("%s: %s ports count %zu", __FUNCTION__,
-                      port_data->name,
-                      hmap_count(&g_l2macd_cache->port_table));
-            hmap_remove(&g_l2macd_cache->port_table, &port_data->hmap_node);
-            free(port_data->name);
-            free(port_data);
+    LIST_FOR_EACH_POP (work, list_node, &g_sched.queue) {
+        const struct ovsrec_port *port_row;
+        const struct ovsrec_vlan *vlan_row;
+
+        hmap_remove(&g_sched.dirty, &work->hmap_node);
+        g_sched.n_queued--;
+
+        /* Deleted rows are only looked up by name or id in the cache, all
+         * the deletes of the slice are handled by a single sweep. */
+        switch (work->type) {
+        case L2MACD_WORK_PORT:
+            /* The row may be gone since it was queued. */
+            port_row = ovsrec_port_get_for_uuid(idl, &work->uuid);
+            if (port_row) {
+                update_port(port_row);
+                break;
+            }
+            /* fall through */
+        case L2MACD_WORK_PORT_DEL:
+            g_sched.n_sweep_dedup += g_sched.sweep_ports;
+            g_sched.sweep_ports = true;
+            break;
+
+        case L2MACD_WORK_VLAN:
+            vlan_row = ovsrec_vlan_get_for_uuid(idl, &work->uuid);
+            if (vlan_row) {
+                update_vlan(vlan_row);
+                break;
+            }
+            /* fall through */
+        case L2MACD_WORK_VLAN_DEL:
+            g_sched.n_sweep_dedup += g_sched.sweep_vlans;
+            g_sched.sweep_vlans = true;
+            break;
+        }
+        free(work);
+
+        if (++n % L2MACD_SLICE_CHECK_ITEMS == 0
+            && time_msec() - start >= L2MACD_SLICE_BUDGET_MSEC) {
+            g_sched.n_slice_budget_hit++;
+            break;
         }
     }
 
-    /* Destroy ports hash */
-    shash_destroy(&all_ports);
-} /* del_old_port */
+    if (g_sched.sweep_ports) {
+        del_old_port();
+        g_sched.sweep_ports = false;
+        g_sched.n_sweeps++;
+    }
+    if (g_sched.sweep_vlans) {
+        del_old_vlan();
+        g_sched.sweep_vlans = false;
+        g_sched.n_sweeps++;
+    }
+
+    g_sched.n_items += n;
+    g_sched.n_slices++;
+
+    /* One transaction for the flushes of the whole slice. */
+    flush_batch_commit(&g_flush_batch);
+}   /* sched_run_slice */
 
 /*-----------------------------------------------------------------------------
- | Function: update_port_cache
- | Responsibility: Track the port changes and update cache
+ | Function: idl_port_run
+ | Responsibility: Engine source node for the tracked Port rows
  | Parameters:
+ |      node: idl_port engine node
+ | Return:
  |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+idl_port_run(struct l2macd_engine_node *node)
+{
+    node->changed = (ovsrec_port_track_get_first(idl) != NULL);
+} /* idl_port_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: idl_iface_run
+ | Responsibility: Engine source node for the tracked Interface rows
+ | Parameters:
+ |      node: idl_iface engine node
  | Return:
  |      None
      ------------------------------------------------------------------------------
  */
 static void
-update_port_cache(void)
+idl_iface_run(struct l2macd_engine_node *node)
 {
-    const struct ovsrec_port *port_row = NULL;
-    int i = 0;
-    unsigned int new_idl_seqno = ovsdb_idl_get_seqno(idl);
+    node->changed = (ovsrec_interface_track_get_first(idl) != NULL);
+} /* idl_iface_run */
 
-    /* Track all the ports changes in the DB. */
-    OVSREC_PORT_FOR_EACH_TRACKED(port_row, idl) {
-        /* Add new ports to the cache. */
-        if(ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_INSERT)
-                           >= new_idl_seqno)  {
-            update_port(port_row);
+/*-----------------------------------------------------------------------------
+ | Function: idl_vlan_run
+ | Responsibility: Engine source node for the tracked VLAN rows
+ | Parameters:
+ |      node: idl_vlan engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+idl_vlan_run(struct l2macd_engine_node *node)
+{
+    node->changed = (ovsrec_vlan_track_get_first(idl) != NULL);
+} /* idl_vlan_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: idl_mac_run
+ | Responsibility: Engine source node for the tracked MAC rows
+ | Parameters:
+ |      node: idl_mac engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+idl_mac_run(struct l2macd_engine_node *node)
+{
+    node->changed = (l2macd_mac_enabled()
+                     && ovsrec_mac_track_get_first(idl) != NULL);
+} /* idl_mac_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: idl_system_run
+ | Responsibility: Engine source node for the tracked System row
+ | Parameters:
+ |      node: idl_system engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+idl_system_run(struct l2macd_engine_node *node)
+{
+    node->changed = (ovsrec_system_track_get_first(idl) != NULL);
+} /* idl_system_run */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_row_vid
+ | Responsibility: Get the VLAN ID of a MAC row
+ | Parameters:
+ |      row: MAC row
+ | Return:
+ |      int : VLAN ID, 0 if unknown
+     ------------------------------------------------------------------------------
+ */
+static inline int
+mac_row_vid(const struct ovsrec_mac *row)
+{
+    return row->mac_vlan ? row->mac_vlan->id : 0;
+} /* mac_row_vid */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_limit_parse
+ | Responsibility: Read a MAC limit setting
+ | Parameters:
+ |      other_config: Port or VLAN other_config
+ | Return:
+ |      uint32_t : maximum number of MACs, 0 for no limit
+     ------------------------------------------------------------------------------
+ */
+static inline uint32_t
+mac_limit_parse(const struct smap *other_config)
+{
+    return MAX(0, smap_get_int(other_config, L2MACD_MAC_LIMIT_KEY, 0));
+} /* mac_limit_parse */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_table_recompute
+ | Responsibility: Engine recompute of the MAC monitor, without move
+ |                 detection
+ | Parameters:
+ |      node: mac_table engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+mac_table_recompute(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    const struct ovsrec_mac *mac_row;
+
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+
+    if (l2macd_mac_enabled()) {
+        /* Limits first, the MACs learned beyond them are flushed. */
+        OVSREC_PORT_FOR_EACH (port_row, idl) {
+            l2macd_mac_set_port_limit(&port_row->header_.uuid,
+                                      mac_limit_parse(&port_row->other_config));
+        }
+        OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+            l2macd_mac_set_vlan_limit(vlan_row->id,
+                                      mac_limit_parse(&vlan_row->other_config));
         }
 
-        /* Delete ports from the cache. */
-        if(ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_DELETE)
-                   >= new_idl_seqno)  {
-            del_old_port();
+        l2macd_mac_clear();
+        OVSREC_MAC_FOR_EACH (mac_row, idl) {
+            if (mac_row->port) {
+                l2macd_mac_learn(mac_row->mac_addr, mac_row_vid(mac_row),
+                                 &mac_row->header_.uuid,
+                                 &mac_row->port->header_.uuid, false);
+            }
         }
+    }
+
+    /* Checks the watermarks against the loaded table. */
+    l2macd_mac_configure(system_row ? &system_row->other_config : NULL);
 
-        /* Update modified ports to the cache. */
-        if(ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_MODIFY)
-                   >= new_idl_seqno)  {
-            update_port(port_row);
+    node->changed = true;
+} /* mac_table_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_table_mac_handler
+ | Responsibility: Engine handler feeding the tracked MAC rows to the MAC
+ |                 monitor
+ | Parameters:
+ |      node: mac_table engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+mac_table_mac_handler(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_mac *mac_row;
+
+    /* A move may be sent as a delete and an insert: learn first, so that
+     * the deleted row does not forget the moved MAC. */
+    OVSREC_MAC_FOR_EACH_TRACKED (mac_row, idl) {
+        if (ovsrec_mac_row_get_seqno(mac_row, OVSDB_IDL_CHANGE_DELETE)
+            <= idl_seqno && mac_row->port) {
+            l2macd_mac_learn(mac_row->mac_addr, mac_row_vid(mac_row),
+                             &mac_row->header_.uuid,
+                             &mac_row->port->header_.uuid, true);
         }
     }
 
-    /* Update port table cache for interface row changes also. */
-    OVSREC_PORT_FOR_EACH(port_row, idl) {
-        /* Handle Interface changes */
-        for (i = 0; i < port_row->n_interfaces; i++) {
-            struct ovsrec_interface *iface_row = port_row->interfaces[i];
-            if (OVSREC_IDL_IS_ROW_MODIFIED(iface_row, idl_seqno)) {
-                update_port(port_row);
-            }
+    OVSREC_MAC_FOR_EACH_TRACKED (mac_row, idl) {
+        if (ovsrec_mac_row_get_seqno(mac_row, OVSDB_IDL_CHANGE_DELETE)
+            > idl_seqno) {
+            l2macd_mac_forget(mac_row->mac_addr, mac_row_vid(mac_row),
+                              &mac_row->header_.uuid);
         }
     }
 
-} /* update_port_cache */
+    node->changed = true;
+    return true;
+} /* mac_table_mac_handler */
 
 /*-----------------------------------------------------------------------------
- | Function: mac_flush_by_vlan
- | Responsibility: Triggers the mac flush on the spcified vlan by setting mac_invalid column
+ | Function: mac_table_system_handler
+ | Responsibility: Engine handler applying the MAC monitor configuration
  | Parameters:
- |      vlan_row: VLAN row in the IDL
+ |      node: mac_table engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+mac_table_system_handler(struct l2macd_engine_node *node OVS_UNUSED)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+
+    l2macd_mac_configure(system_row ? &system_row->other_config : NULL);
+    return true;
+} /* mac_table_system_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_table_port_handler
+ | Responsibility: Engine handler applying the MAC limits of the tracked
+ |                 ports
+ | Parameters:
+ |      node: mac_table engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+mac_table_port_handler(struct l2macd_engine_node *node OVS_UNUSED)
+{
+    const struct ovsrec_port *port_row;
+
+    if (!l2macd_mac_enabled()) {
+        return true;
+    }
+
+    OVSREC_PORT_FOR_EACH_TRACKED (port_row, idl) {
+        if (ovsrec_port_row_get_seqno(port_row, OVSDB_IDL_CHANGE_DELETE)
+            > idl_seqno) {
+            l2macd_mac_port_deleted(&port_row->header_.uuid);
+        } else {
+            l2macd_mac_set_port_limit(&port_row->header_.uuid,
+                                      mac_limit_parse(&port_row->other_config));
+        }
+    }
+    return true;
+} /* mac_table_port_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: mac_table_vlan_handler
+ | Responsibility: Engine handler applying the MAC limits of the tracked
+ |                 VLANs
+ | Parameters:
+ |      node: mac_table engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+mac_table_vlan_handler(struct l2macd_engine_node *node OVS_UNUSED)
+{
+    const struct ovsrec_vlan *vlan_row;
+
+    if (!l2macd_mac_enabled()) {
+        return true;
+    }
+
+    OVSREC_VLAN_FOR_EACH_TRACKED (vlan_row, idl) {
+        if (ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_DELETE)
+            > idl_seqno) {
+            l2macd_mac_set_vlan_limit(vlan_row->id, 0);
+        } else {
+            l2macd_mac_set_vlan_limit(vlan_row->id,
+                                      mac_limit_parse(&vlan_row->other_config));
+        }
+    }
+    return true;
+} /* mac_table_vlan_handler */
+
+/*-----------------------------------------------------------------------------
+ | Function: age_time_parse
+ | Responsibility: Read an age-time setting
+ | Parameters:
+ |      other_config: System or VLAN other_config
+ |      what: owner of the setting, for the log
+ |      fallback: age-time if unset or invalid
+ | Return:
+ |      int : age-time in seconds
+     ------------------------------------------------------------------------------
+ */
+static int
+age_time_parse(const struct smap *other_config, const char *what,
+               int fallback)
+{
+    const char *value = smap_get(other_config, L2MACD_AGE_TIME_KEY);
+    char *end;
+    long age;
+
+    if (value == NULL) {
+        return fallback;
+    }
+
+    errno = 0;
+    age = strtol(value, &end, 10);
+    if (errno || end == value || *end != '\0'
+        || !L2MACD_AGE_TIME_VALID(age)) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        VLOG_WARN_RL(&rl, "%s: invalid %s \"%s\", using %d", what,
+                     L2MACD_AGE_TIME_KEY, value, fallback);
+        g_age.n_invalid++;
+        return fallback;
+    }
+    return age;
+} /* age_time_parse */
+
+/*-----------------------------------------------------------------------------
+ | Function: age_time_vlan
+ | Responsibility: Get the age-time in effect on a VLAN
+ | Parameters:
+ |      vlan_row: VLAN row
+ | Return:
+ |      int : age-time in seconds
+     ------------------------------------------------------------------------------
+ */
+static int
+age_time_vlan(const struct ovsrec_vlan *vlan_row)
+{
+    return age_time_parse(&vlan_row->other_config, vlan_row->name
+                          ? vlan_row->name : "vlan", g_age.age_time);
+} /* age_time_vlan */
+/*-----------------------------------------------------------------------------
+ | Function: status_update
+ | Responsibility: Set a key of a status map
+ | Parameters:
+ |      status: System, Port or VLAN status
+ |      key: status key
+ |      value: new value, NULL to remove the key
+ | Return:
+ |      bool : true if status changed
+     ------------------------------------------------------------------------------
+ */
+static bool
+status_update(struct smap *status, const char *key, const char *value)
+{
+    const char *old = smap_get(status, key);
+
+    if (value == NULL) {
+        return old ? smap_remove(status, key) : false;
+    }
+    if (old && !strcmp(old, value)) {
+        return false;
+    }
+    smap_replace(status, key, value);
+    return true;
+} /* status_update */
+
+/*-----------------------------------------------------------------------------
+ | Function: status_update_counter
+ | Responsibility: Set the MAC count and limit state of a Port or VLAN
+ |                 status map
+ | Parameters:
+ |      status: Port or VLAN status
+ |      counter: port or VLAN counter, NULL if none
+ | Return:
+ |      bool : true if status changed
+     ------------------------------------------------------------------------------
+ */
+static bool
+status_update_counter(struct smap *status,
+                      const struct l2macd_mac_counter *counter)
+{
+    char value[24];
+    bool changed;
+
+    snprintf(value, sizeof value, "%"PRIu32, counter ? counter->n_macs : 0);
+    changed = status_update(status, "mac_count",
+                            counter && counter->n_macs ? value : NULL);
+
+    changed |= status_update(status, "mac_limit_exceeded",
+                            counter && counter->exceeded ? "true" : NULL);
+
+    snprintf(value, sizeof value, "%"PRIu64,
+             counter ? counter->n_violations : 0);
+    changed |= status_update(status, "mac_limit_violations",
+                             counter && counter->n_violations ? value : NULL);
+    return changed;
+} /* status_update_counter */
+
+/*-----------------------------------------------------------------------------
+ | Function: status_update_utilization
+ | Responsibility: Set the MAC table occupancy and watermark state of the
+ |                 System status map
+ | Parameters:
+ |      status: System status
+ | Return:
+ |      bool : true if status changed
+     ------------------------------------------------------------------------------
+ */
+static bool
+status_update_utilization(struct smap *status)
+{
+    const struct l2macd_mac_utilization *util = l2macd_mac_utilization();
+    char value[24];
+    bool changed;
+
+    snprintf(value, sizeof value, "%"PRIu32, util->n_macs);
+    changed = status_update(status, "mac_count", value);
+
+    snprintf(value, sizeof value, "%"PRIu32, util->capacity);
+    changed |= status_update(status, L2MACD_MAC_CAPACITY_KEY,
+                             util->capacity ? value : NULL);
+    snprintf(value, sizeof value, "%u", util->high_pct);
+    changed |= status_update(status, L2MACD_MAC_HIGH_WATERMARK_KEY,
+                             util->capacity ? value : NULL);
+    snprintf(value, sizeof value, "%u", util->low_pct);
+    changed |= status_update(status, L2MACD_MAC_LOW_WATERMARK_KEY,
+                             util->capacity ? value : NULL);
+    changed |= status_update(status, "mac_watermark_state",
+                             !util->capacity ? NULL
+                             : util->high ? "high" : "normal");
+
+    snprintf(value, sizeof value, "%"PRIu64, util->n_crossings);
+    changed |= status_update(status, "mac_watermark_crossings",
+                             util->n_crossings ? value : NULL);
+    snprintf(value, sizeof value, "%lld", util->last_crossing / 1000);
+    changed |= status_update(status, "mac_watermark_last_crossing",
+                             util->n_crossings ? value : NULL);
+    return changed;
+} /* status_update_utilization */
+
+/*-----------------------------------------------------------------------------
+ | Function: status_publish
+ | Responsibility: Publish the age-time in effect, the MAC counts and the
+ |                 MAC limit and watermark states in the System, VLAN and
+ |                 Port status columns, for ops-switchd and the CLI. Only
+ |                 the changed values are written, the keys of the other
+ |                 daemons are kept: the columns are verified and the
+ |                 publish retried if another daemon wrote them meanwhile
+ | Parameters:
+ |      None
  | Return:
  |      None
      ------------------------------------------------------------------------------
  */
 static void
-mac_flush_by_vlan(const struct ovsrec_vlan *vlan_row)
+status_publish(void)
 {
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
     struct ovsdb_idl_txn *txn;
-    bool mac_invalid = true;
-    enum ovsdb_idl_txn_status status = TXN_SUCCESS;
-
-    if (vlan_row == NULL)   {
+    enum ovsdb_idl_txn_status status;
+    enum l2macd_phase phase;
+    size_t n_updates = 0;
+    char value[16];
+    struct smap smap;
+    bool changed;
+
+    if (system_row == NULL || !ovsdb_idl_has_lock(idl)) {
         return;
     }
 
     txn = ovsdb_idl_txn_create(idl);
 
-    /* Set MAC flush request on this VLAN. */
-    ovsrec_vlan_set_macs_invalid(vlan_row, &mac_invalid, 1);
-    ovsrec_vlan_verify_macs_invalid(vlan_row);
-    ovsdb_idl_txn_add_comment(txn, "l2macd-%" PRIi64 "-flush", vlan_row->id);
+    smap_clone(&smap, &system_row->status);
+    snprintf(value, sizeof value, "%d", g_age.age_time);
+    changed = status_update(&smap, L2MACD_AGE_TIME_KEY, value);
+    if (l2macd_mac_enabled()) {
+        changed |= status_update_utilization(&smap);
+    }
+    if (changed) {
+        ovsrec_system_verify_status(system_row);
+        ovsrec_system_set_status(system_row, &smap);
+        n_updates++;
+    }
+    smap_destroy(&smap);
+
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        smap_clone(&smap, &vlan_row->status);
+        snprintf(value, sizeof value, "%d", age_time_vlan(vlan_row));
+        changed = status_update(&smap, L2MACD_AGE_TIME_KEY, value);
+        if (l2macd_mac_enabled()) {
+            const struct l2macd_mac_counter *counter;
+
+            counter = l2macd_mac_vlan_counter(vlan_row->id);
+            changed |= status_update_counter(&smap, counter);
+        }
+        if (changed) {
+            ovsrec_vlan_verify_status(vlan_row);
+            ovsrec_vlan_set_status(vlan_row, &smap);
+            n_updates++;
+        }
+        smap_destroy(&smap);
+    }
+
+    if (l2macd_mac_enabled()) {
+        OVSREC_PORT_FOR_EACH(port_row, idl) {
+            const struct l2macd_mac_counter *counter;
+
+            counter = l2macd_mac_port_counter(&port_row->header_.uuid);
+            smap_clone(&smap, &port_row->status);
+            if (status_update_counter(&smap, counter)) {
+                ovsrec_port_verify_status(port_row);
+                ovsrec_port_set_status(port_row, &smap);
+                n_updates++;
+            }
+            smap_destroy(&smap);
+        }
+    }
+
+    if (n_updates == 0) {
+        ovsdb_idl_txn_destroy(txn);
+        status_pending = false;
+        counts_pending = false;
+        return;
+    }
 
+    ovsdb_idl_txn_add_comment(txn, "l2macd-status");
+    phase = l2macd_profile_enter(L2MACD_PHASE_COMMIT);
     status = ovsdb_idl_txn_commit_block(txn);
-    VLOG_DBG("%s: vlan %" PRIi64 " status %d \n", __FUNCTION__,
-             vlan_row->id, status);
+    l2macd_profile_enter(phase);
+
+    if (status == TXN_SUCCESS || status == TXN_UNCHANGED) {
+        status_pending = false;
+        counts_pending = false;
+        next_count_msec = time_msec() + L2MACD_MAC_COUNT_PUBLISH_MSEC;
+        g_age.n_updates += n_updates;
+    } else if (status == TXN_TRY_AGAIN) {
+        /* Another daemon changed a status column, published again with its
+         * keys once the IDL holds the new contents. */
+        VLOG_DBG("%s: status publish retried", __FUNCTION__);
+    } else {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        /* Retried on the next run. */
+        VLOG_WARN_RL(&rl, "%s: txn_commit status %d", __FUNCTION__, status);
+    }
+    ovsdb_idl_txn_destroy(txn);
+} /* status_publish */
+/*-----------------------------------------------------------------------------
+ | Function: age_time_recompute
+ | Responsibility: Engine recompute of the age-time in effect. There are
+ |                 4094 VLANs at most, the status columns are compared
+ |                 when published
+ | Parameters:
+ |      node: age_time engine node
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+static void
+age_time_recompute(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    const struct ovsrec_vlan *vlan_row;
+    int age_time = L2MACD_AGE_TIME_DEFAULT;
+
+    if (system_row) {
+        age_time = age_time_parse(&system_row->other_config, "system",
+                                  L2MACD_AGE_TIME_DEFAULT);
+    }
+    if (age_time != g_age.age_time) {
+        VLOG_INFO("MAC age-time %d seconds", age_time);
+        g_age.age_time = age_time;
+    }
+
+    g_age.n_overrides = 0;
+    memset(g_age.overrides, 0, sizeof g_age.overrides);
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        if (smap_get(&vlan_row->other_config, L2MACD_AGE_TIME_KEY)
+            && vlan_row->id >= 0 && vlan_row->id < L2MACD_VLAN_BITMAP_SIZE) {
+            bitmap_set1(g_age.overrides, vlan_row->id);
+            g_age.n_overrides++;
+        }
+    }
+
+    status_pending = true;
+    node->changed = true;
+} /* age_time_recompute */
+
+/*-----------------------------------------------------------------------------
+ | Function: age_time_system_handler
+ | Responsibility: Engine handler for the System age-time. Only a change of
+ |                 the value in effect needs the VLAN status to be published
+ | Parameters:
+ |      node: age_time engine node
+ | Return:
+ |      bool : always true
+     ------------------------------------------------------------------------------
+ */
+static bool
+age_time_system_handler(struct l2macd_engine_node *node)
+{
+    const struct ovsrec_system *system_row = ovsrec_system_first(idl);
+    int age_time = L2MACD_AGE_TIME_DEFAULT;
 
-    if (status != TXN_SUCCESS)    {
-        ovsdb_idl_txn_abort(txn);
-        VLOG_ERR("%s: txn_commit status %d \n",
-                 __FUNCTION__, status);
+    if (system_row) {
+        age_time = age_time_parse(&system_row->other_config, "system",
+                                  L2MACD_AGE_TIME_DEFAULT);
+    }
+    if (age_time == g_age.age_time) {
+        return true;
     }
 
-    ovsdb_idl_txn_destroy(txn);
-}
+    VLOG_INFO("MAC age-time %d seconds", age_time);
+    g_age.age_time = age_time;
+    status_pending = true;
+    node->changed = true;
+    return true;
+} /* age_time_system_handler */
 
 /*-----------------------------------------------------------------------------
- | Function: update_vlan_state
- | Responsibility: Update the VLAN details in the global cache and flush the mac
- |                      if VLAN state is down
+ | Function: age_time_vlan_handler
+ | Responsibility: Engine handler for the VLAN age-time overrides. The VLAN
+ |                 rows whose other_config did not change are skipped, the
+ |                 status is only published for a new VLAN or a changed
+ |                 age-time
  | Parameters:
- |      row: VLAN row in the idl
- |      vlan_data: vlan_data cache
+ |      node: age_time engine node
  | Return:
- |      None
+ |      bool : false on a VLAN ID out of range
      ------------------------------------------------------------------------------
  */
-static void
-update_vlan_state(const struct ovsrec_vlan *row, struct vlan_data *vlan_ptr)
+static bool
+age_time_vlan_handler(struct l2macd_engine_node *node)
 {
-    bool prev_op_up = false, op_up = false;
+    const struct ovsrec_vlan *vlan_row;
+    bool changed = false;
 
-    if (row == NULL || vlan_ptr == NULL)   {
-        return;
-    }
+    OVSREC_VLAN_FOR_EACH_TRACKED(vlan_row, idl) {
+        bool deleted, has_override;
+        const char *published;
+        char value[16];
 
-    vlan_ptr->vlan_id = (int) row->id;
-    prev_op_up = vlan_ptr->op_state;
+        if (vlan_row->id < 0 || vlan_row->id >= L2MACD_VLAN_BITMAP_SIZE) {
+            return false;
+        }
 
-    /* Update oper_state to unknown. */
-    if (row->oper_state &&
-        !strncmp(OVSREC_VLAN_OPER_STATE_UP, row->oper_state,
-                 strlen(OVSREC_VLAN_OPER_STATE_UP))) {
-        op_up = true;
-    }
+        deleted = (ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_DELETE)
+                   > idl_seqno);
+        if (!deleted
+            && ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_INSERT)
+               <= idl_seqno
+            && !ovsrec_vlan_is_updated(vlan_row,
+                                       OVSREC_VLAN_COL_OTHER_CONFIG)) {
+            continue;
+        }
 
-    /* Flush only VLAN operational down cases */
-    if (OVSREC_IDL_IS_COLUMN_MODIFIED(ovsrec_vlan_col_oper_state,
-                                      idl_seqno)
-        && prev_op_up == true && op_up == false) {
-        mac_flush_by_vlan(row);
+        has_override = (!deleted
+                        && smap_get(&vlan_row->other_config,
+                                    L2MACD_AGE_TIME_KEY) != NULL);
+        if (has_override != bitmap_is_set(g_age.overrides, vlan_row->id)) {
+            bitmap_set(g_age.overrides, vlan_row->id, has_override);
+            if (has_override) {
+                g_age.n_overrides++;
+            } else {
+                g_age.n_overrides--;
+            }
+            changed = true;
+        }
+        if (deleted) {
+            continue;
+        }
+
+        snprintf(value, sizeof value, "%d", age_time_vlan(vlan_row));
+        published = smap_get(&vlan_row->status, L2MACD_AGE_TIME_KEY);
+        if (published == NULL || strcmp(published, value)) {
+            status_pending = true;
+            changed = true;
+        }
     }
 
-    /* Update the VLAN oper_state */
-    vlan_ptr->op_state = op_up;
-} /* update_vlan_state */
+    node->changed |= changed;
+    return true;
+} /* age_time_vlan_handler */
 
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_macs_init
+ | Responsibility: Enable the warm reboot MAC snapshot and read the one saved
+ |                 before the restart, before l2macd_ovsdb_init()
+ | Parameters:
+ |      path: snapshot file path
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_warm_macs_init(const char *path)
+{
+    int error;
+
+    g_warm.path = xstrdup(path);
+    g_warm.seed_path = xasprintf("%s/%s", ovs_rundir(),
+                                 L2MACD_WARM_SEED_FILE);
+    /* A seed file left by a previous instance is not this boot's. */
+    unlink(g_warm.seed_path);
+
+    error = l2macd_warm_read(&g_warm.snap, path);
+    if (error == 0) {
+        g_warm.pending = true;
+        VLOG_INFO("%s: %zu MACs on %zu ports saved %lld ms ago, handing "
+                  "them over to ops-switchd", path, g_warm.snap.n_macs,
+                  g_warm.snap.n_ports,
+                  time_wall_msec() - g_warm.snap.time_msec);
+    } else if (error != ENOENT) {
+        g_warm.load_error = error;
+        VLOG_WARN("%s: %s, ignoring it", path, error == EINVAL
+                  ? "not a valid MAC snapshot" : ovs_strerror(error));
+        unlink(path);
+    }
+} /* l2macd_warm_macs_init */
 
 /*-----------------------------------------------------------------------------
- | Function: vlan_lookup_by_vid
- | Responsibility: VLAN lookup in the global cache
+ | Function: l2macd_warm_macs_save
+ | Responsibility: Save the learned MACs for a warm reboot. Static and
+ |                 controller MACs are restored by their owners
  | Parameters:
- |      vlan_hmap: VLANs hash map
- |      vid: VLAN ID
+ |      ds: reply, or error message
  | Return:
- |      vlan_data: return the vlan_data, if the specified vlan exists
+ |      bool : true if the snapshot is written
      ------------------------------------------------------------------------------
  */
-static inline struct vlan_data *
-vlan_lookup_by_vid(const struct hmap* vlan_hmap, int vid)
+bool
+l2macd_warm_macs_save(struct ds *ds)
 {
-    struct vlan_data *vlan = NULL;
+    const struct ovsrec_mac *mac_row;
+    struct l2macd_warm_snapshot snap;
+    size_t n_skipped = 0;
+    int error;
+
+    if (g_warm.path == NULL) {
+        ds_put_cstr(ds, "warm reboot MAC snapshot disabled, see --warm-macs");
+        return false;
+    }
 
-    if (vlan_hmap == NULL)   {
-        return vlan;
+    l2macd_warm_init(&snap);
+    OVSREC_MAC_FOR_EACH (mac_row, idl) {
+        if (mac_row->port == NULL || mac_row->from == NULL
+            || strcmp(mac_row->from, L2MACD_MAC_FROM_DYNAMIC)) {
+            continue;
+        }
+        if (!l2macd_warm_add(&snap, mac_row->mac_addr, mac_row_vid(mac_row),
+                             mac_row->port->name)) {
+            n_skipped++;
+        }
     }
 
-    HMAP_FOR_EACH (vlan, hmap_node, vlan_hmap) {
-        if (vlan->vlan_id == vid) {
-            return vlan;
+    error = l2macd_warm_write(&snap, g_warm.path);
+    if (error) {
+        ds_put_format(ds, "%s: %s", g_warm.path, ovs_strerror(error));
+    } else {
+        g_warm.n_saves++;
+        g_warm.n_saved = snap.n_macs;
+        ds_put_format(ds, "%zu MACs on %zu ports saved to %s",
+                      snap.n_macs, snap.n_ports, g_warm.path);
+        if (n_skipped) {
+            ds_put_format(ds, ", %zu skipped", n_skipped);
         }
+        VLOG_INFO("%s", ds_cstr(ds));
     }
-    return vlan;
-}
+    l2macd_warm_destroy(&snap);
+    return !error;
+} /* l2macd_warm_macs_save */
 
 /*-----------------------------------------------------------------------------
- | Function: update_vlan
- | Responsibility: Create/Update the VLAN details in the global cache
+ | Function: warm_macs_done
+ | Responsibility: Forget the snapshot read on boot, it is only used once
  | Parameters:
- |      vlan_row: VLAN row in the idl
+ |      None
  | Return:
  |      None
      ------------------------------------------------------------------------------
  */
 static void
-update_vlan(const struct ovsrec_vlan *vlan_row)
+warm_macs_done(void)
 {
-    struct vlan_data *new_vlan = NULL;
+    g_warm.pending = false;
+    l2macd_warm_destroy(&g_warm.snap);
+    unlink(g_warm.path);
+} /* warm_macs_done */
 
-    if (vlan_row == NULL)   {
-        return;
-    }
+/*-----------------------------------------------------------------------------
+ | Function: port_has_vlan
+ | Responsibility: Check that a port carries a VLAN, as its native VLAN or
+ |                 one of its trunks
+ | Parameters:
+ |      port_row: port row in the idl
+ |      vid: VLAN ID
+ | Return:
+ |      bool : true if the port is a member of the VLAN
+     ------------------------------------------------------------------------------
+ */
+static bool
+port_has_vlan(const struct ovsrec_port *port_row, int vid)
+{
+    size_t i;
 
-    new_vlan = vlan_lookup_by_vid(&g_l2macd_cache->vlan_table,
-                                  vlan_row->id);
-    if(!new_vlan)  {
-        /* Allocate structure to save state information for this VLAN. */
-        new_vlan = xzalloc(sizeof(struct vlan_data));
-        new_vlan->vlan_id = (int) vlan_row->id;
-        new_vlan->op_state= false;
-        hmap_insert(&g_l2macd_cache->vlan_table, &new_vlan->hmap_node,
-                        hash_int(vlan_row->id, 0));
+    if (port_row->vlan_tag && port_row->vlan_tag->id == vid) {
+        return true;
     }
-
-    /* Update VLAN configuration into internal format. */
-    update_vlan_state(vlan_row, new_vlan);
-
-    VLOG_DBG("%s: %d, hmap count %zu", __FUNCTION__, (int)vlan_row->id,
-             hmap_count(&g_l2macd_cache->vlan_table));
-} /* add_new_vlan */
+    for (i = 0; i < port_row->n_vlan_trunks; i++) {
+        if (port_row->vlan_trunks[i] && port_row->vlan_trunks[i]->id == vid) {
+            return true;
+        }
+    }
+    return false;
+} /* port_has_vlan */
 
 /*-----------------------------------------------------------------------------
- | Function: del_old_vlan
- | Responsibility: Delete the VLAN from the global cache
+ | Function: warm_macs_handover
+ | Responsibility: Write to the seed file the saved MACs whose port is up and
+ |                 carries their VLAN, and whose VLAN is up, for ops-switchd.
+ |                 MACs learned again since the boot are left out
  | Parameters:
  |      None
  | Return:
  |      None
- |Note : Don't access vlan_row, Track looses deleted vlan_row information except UUID
      ------------------------------------------------------------------------------
  */
 static void
-del_old_vlan(void)
+warm_macs_handover(void)
 {
-    const struct ovsrec_vlan *vlan_row = NULL;
-    struct vlan_data *vlan = NULL, *vlan_next = NULL;
-    bool vlan_found = false;
+    const struct ovsrec_port **ports;
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+    struct l2macd_warm_snapshot *snap = &g_warm.snap;
+    struct l2macd_warm_snapshot seed;
+    unsigned long *vlans;
+    struct shash port_rows;
+    long long int age;
+    int error;
+    size_t i;
+
+    /* The MACs would have aged out in the meantime. */
+    age = time_wall_msec() - snap->time_msec;
+    if (g_age.age_time && age > g_age.age_time * 1000LL) {
+        VLOG_INFO("MAC snapshot saved %lld ms ago, older than the age-time, "
+                  "dropping it", age);
+        warm_macs_done();
+        return;
+    }
 
-    /* Check all the VLANs present in the DB. */
-    HMAP_FOR_EACH_SAFE (vlan, vlan_next, hmap_node,
-                        &g_l2macd_cache->vlan_table) {
+    shash_init(&port_rows);
+    OVSREC_PORT_FOR_EACH (port_row, idl) {
+        shash_add_once(&port_rows, port_row->name, port_row);
+    }
+    ports = xcalloc(MAX(1, snap->n_ports), sizeof *ports);
+    for (i = 0; i < snap->n_ports; i++) {
+        port_row = shash_find_data(&port_rows, snap->ports[i]);
+        if (port_row && port_link_up(port_row)) {
+            ports[i] = port_row;
+        }
+    }
+    shash_destroy(&port_rows);
 
-        vlan_found = false;
-        OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
-            if ((vlan->vlan_id == vlan_row->id)) {
-                vlan_found = true;
-                break;
-            }
+    vlans = bitmap_allocate(L2MACD_VLAN_BITMAP_SIZE);
+    OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+        if (vlan_row->id > 0 && vlan_row->id < L2MACD_VLAN_BITMAP_SIZE
+            && vlan_oper_up(vlan_row)) {
+            bitmap_set1(vlans, vlan_row->id);
         }
+    }
 
-        /* Handle deleted vlans */
-        if (vlan_found == false)   {
-            VLOG_DBG("%s: vlan_id %d hmap count %zu", __FUNCTION__,
-                      vlan->vlan_id,
-                      hmap_count(&g_l2macd_cache->vlan_table));
-            hmap_remove(&g_l2macd_cache->vlan_table,
-                        &vlan->hmap_node);
-            /* Free the VLAN data */
-            free(vlan);
+    g_warm.n_seeded = g_warm.n_no_port = 0;
+    g_warm.n_no_vlan = g_warm.n_present = 0;
+
+    l2macd_warm_init(&seed);
+    for (i = 0; i < snap->n_macs; i++) {
+        const struct l2macd_warm_mac *mac = &snap->macs[i];
+        char addr[18];
 
+        port_row = ports[mac->port];
+        if (port_row == NULL) {
+            g_warm.n_no_port++;
+            continue;
+        }
+        if (!bitmap_is_set(vlans, mac->vid)
+            || !port_has_vlan(port_row, mac->vid)) {
+            g_warm.n_no_vlan++;
+            continue;
+        }
+
+        l2macd_warm_format_mac(mac, addr);
+        if (l2macd_mac_learned(addr, mac->vid)) {
+            g_warm.n_present++;
+            continue;
+        }
+
+        if (l2macd_warm_add(&seed, addr, mac->vid, port_row->name)) {
+            g_warm.n_seeded++;
+        }
+    }
+    free(ports);
+    bitmap_free(vlans);
+
+    if (g_warm.n_seeded) {
+        error = l2macd_warm_write(&seed, g_warm.seed_path);
+        if (error) {
+            g_warm.n_seeded = 0;
+        } else {
+            g_warm.seeded = true;
         }
     }
+    l2macd_warm_destroy(&seed);
 
-    VLOG_DBG("%s: hmap count %zu", __FUNCTION__,
-              hmap_count(&g_l2macd_cache->vlan_table));
-} /* del_old_vlan */
+    VLOG_INFO("Wrote %zu of %zu saved MACs to the seed file, %zu on a "
+              "missing or down port, %zu on a missing or down VLAN, %zu "
+              "learned again", g_warm.n_seeded, snap->n_macs,
+              g_warm.n_no_port, g_warm.n_no_vlan, g_warm.n_present);
+    warm_macs_done();
+} /* warm_macs_handover */
+
+/* Incremental processing graph, each node with its inputs:
+ *
+ *   port_cache <- idl_port, idl_iface
+ *   vlan_cache <- idl_vlan
+ *   mac_table  <- idl_system, idl_port, idl_vlan, idl_mac
+ *   age_time   <- idl_system, idl_vlan
+ *   l2macd     <- port_cache, vlan_cache, mac_table, age_time
+ */
+static L2MACD_ENGINE_NODE_DEFINE(idl_port, idl_port_run);
+static L2MACD_ENGINE_NODE_DEFINE(idl_iface, idl_iface_run);
+static L2MACD_ENGINE_NODE_DEFINE(idl_vlan, idl_vlan_run);
+static L2MACD_ENGINE_NODE_DEFINE(idl_mac, idl_mac_run);
+static L2MACD_ENGINE_NODE_DEFINE(idl_system, idl_system_run);
+static L2MACD_ENGINE_NODE_DEFINE(port_cache, port_cache_recompute);
+static L2MACD_ENGINE_NODE_DEFINE(vlan_cache, vlan_cache_recompute);
+static L2MACD_ENGINE_NODE_DEFINE(mac_table, mac_table_recompute);
+static L2MACD_ENGINE_NODE_DEFINE(age_time, age_time_recompute);
+static L2MACD_ENGINE_NODE_DEFINE(l2macd, l2macd_cache_recompute);
 
 /*-----------------------------------------------------------------------------
- | Function: update_vlan_cache
- | Responsibility: Track the VLAN table changes and update cache
+ | Function: l2macd_engine_setup
+ | Responsibility: Build the incremental processing graph
  | Parameters:
  |      None
  | Return:
@@ -665,34 +3353,36 @@ del_old_vlan(void)
      ------------------------------------------------------------------------------
  */
 static void
-update_vlan_cache(void)
+l2macd_engine_setup(void)
 {
-    const struct ovsrec_vlan *vlan_row;
-    unsigned int new_idl_seqno = ovsdb_idl_get_seqno(idl);
-
-    /* Track all the VLAN changes in the DB. */
-    OVSREC_VLAN_FOR_EACH_TRACKED(vlan_row, idl) {
-        /* Add new VLAN to the cache */
-        if(ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_INSERT)
-                           >= new_idl_seqno)  {
-            update_vlan(vlan_row);
-        }
-
-        /* Update modified VLAN to the cache */
-        if(ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_MODIFY)
-                           >= new_idl_seqno)  {
-            update_vlan(vlan_row);
-        }
-
-        /* Delete VLAN from the cache */
-        if(ovsrec_vlan_row_get_seqno(vlan_row, OVSDB_IDL_CHANGE_DELETE)
-                           >= new_idl_seqno)  {
-            del_old_vlan();
-        }
-    }
-
-    return;
-} /* update_vlan_cache */
+    l2macd_engine_add_input(&engine_node_port_cache, &engine_node_idl_port,
+                            port_cache_port_handler);
+    l2macd_engine_add_input(&engine_node_port_cache, &engine_node_idl_iface,
+                            port_cache_iface_handler);
+    l2macd_engine_add_input(&engine_node_vlan_cache, &engine_node_idl_vlan,
+                            vlan_cache_vlan_handler);
+    /* The settings and limits are applied before the MACs are counted. */
+    l2macd_engine_add_input(&engine_node_mac_table, &engine_node_idl_system,
+                            mac_table_system_handler);
+    l2macd_engine_add_input(&engine_node_mac_table, &engine_node_idl_port,
+                            mac_table_port_handler);
+    l2macd_engine_add_input(&engine_node_mac_table, &engine_node_idl_vlan,
+                            mac_table_vlan_handler);
+    l2macd_engine_add_input(&engine_node_mac_table, &engine_node_idl_mac,
+                            mac_table_mac_handler);
+    l2macd_engine_add_input(&engine_node_age_time, &engine_node_idl_system,
+                            age_time_system_handler);
+    l2macd_engine_add_input(&engine_node_age_time, &engine_node_idl_vlan,
+                            age_time_vlan_handler);
+    l2macd_engine_add_input(&engine_node_l2macd, &engine_node_port_cache,
+                            l2macd_cache_handler);
+    l2macd_engine_add_input(&engine_node_l2macd, &engine_node_vlan_cache,
+                            l2macd_cache_handler);
+    l2macd_engine_add_input(&engine_node_l2macd, &engine_node_mac_table,
+                            l2macd_cache_handler);
+    l2macd_engine_add_input(&engine_node_l2macd, &engine_node_age_time,
+                            l2macd_cache_handler);
+} /* l2macd_engine_setup */
 
 /*-----------------------------------------------------------------------------
  | Function: l2macd_reconfigure
@@ -713,11 +3403,30 @@ l2macd_reconfigure(void)
         return;
     }
 
-    /* Update Port table cache. */
-    update_port_cache();
+    if (g_conn.resync_pending) {
+        /* Keep the cache and the tracked changes until the fresh
+         * snapshot is in. */
+        if (!l2macd_snapshot_reloaded(g_conn.resync_seqno)) {
+            return;
+        }
+        g_conn.resync_pending = false;
+        cache_synced = false;
+    }
+
+    g_wakeups.n_changes++;
 
-    /* Update VLAN table cache. */
-    update_vlan_cache();
+    if (!cache_synced) {
+        /* Initial or fresh snapshot, diffed with the cache at once. */
+        g_sync_stats.start_msec = time_msec();
+        g_sync_stats.n_stale = 0;
+        l2macd_engine_force_recompute();
+    } else if (!l2macd_has_tracked_changes()) {
+        /* Only untracked columns changed, e.g. System:cur_cfg. */
+        g_wakeups.n_skipped++;
+    }
+
+    /* Only the nodes whose inputs changed are evaluated. */
+    l2macd_engine_run(&engine_node_l2macd);
 
     /* Update IDL sequence # after we've handled everything. */
     idl_seqno = new_idl_seqno;
@@ -767,27 +3476,115 @@ l2macd_chk_for_system_configured(void)
 void
 l2macd_run(void)
 {
-    /* Process a batch of messages from OVSDB. */
-    ovsdb_idl_run(idl);
+    enum l2macd_phase phase;
+    bool has_lock;
+    long long int lock_msec = 0;
+    long long int start = time_msec();
+    unsigned int prev_seqno = ovsdb_idl_get_seqno(idl);
+    unsigned int run_seqno;
+
+    g_wakeups.n_runs++;
+    if (g_sched.immediate_wake) {
+        l2macd_profile_note(L2MACD_WAKEUP_IMMEDIATE);
+    }
+
+    /* Process messages from OVSDB until none is left or the drain budget
+     * is exhausted, many small batches are then handled in one pass. */
+    g_sched.drain_pending = false;
+    phase = l2macd_profile_enter(L2MACD_PHASE_IDL);
+    do {
+        run_seqno = ovsdb_idl_get_seqno(idl);
+        ovsdb_idl_run(idl);
+        g_sched.n_drains++;
+        if (time_msec() - start >= L2MACD_DRAIN_BUDGET_MSEC) {
+            g_sched.drain_pending = ovsdb_idl_get_seqno(idl) != run_seqno;
+            g_sched.n_drain_budget_hit += g_sched.drain_pending;
+            break;
+        }
+    } while (ovsdb_idl_get_seqno(idl) != run_seqno);
+    l2macd_profile_enter(phase);
+
+    if (ovsdb_idl_get_seqno(idl) != prev_seqno) {
+        l2macd_profile_note(L2MACD_WAKEUP_IDL);
+    }
 
+    /* Without the lock, keep the cache in sync as a standby. Flushes are
+     * recorded instead of sent, see mac_flush_by_port(). */
     if (ovsdb_idl_is_lock_contended(idl)) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
 
-        VLOG_ERR_RL(&rl, "Another l2macd process is running, "
-                    "disabling this process until it goes away");
+        VLOG_INFO_RL(&rl, "Another l2macd process is running, "
+                     "standing by until it goes away");
 
-        return;
-    } else if (!ovsdb_idl_has_lock(idl)) {
-        return;
+        if (!g_standby.was_standby) {
+            g_standby.was_standby = true;
+            g_standby.standby_since = time_msec();
+        }
+    }
+
+    has_lock = ovsdb_idl_has_lock(idl);
+    if (has_lock && !g_standby.lock_held) {
+        lock_msec = time_msec();
     }
 
+    l2macd_chk_for_reconnect(prev_seqno, !has_lock && g_standby.lock_held);
+    g_standby.lock_held = has_lock;
+
     /* Update the local configuration and push any changes to the DB.
      * Only do this after the system has been configured by CFGD, i.e.
      * table System "cur_cfg" > 1.
     */
     l2macd_chk_for_system_configured();
     if (system_configured) {
+        /* Link changes seen with the restart are held as well, the held
+         * flushes are checked against the state after this pass. */
+        switchd_hold_start();
         l2macd_reconfigure();
+        if (!g_conn.resync_pending) {
+            sched_run_slice();
+        }
+        switchd_hold_check();
+    }
+
+    /* The flushes recorded before the lock was acquired are not lost,
+     * whether or not another instance held it. */
+    if (lock_msec) {
+        standby_takeover(lock_msec, g_standby.was_standby);
+        g_standby.was_standby = false;
+    }
+
+    /* Warm reboot, once the DB contents are in the cache. A standby keeps
+     * the snapshot until it takes over. */
+    if (g_warm.pending && system_configured && has_lock && cache_synced
+        && !g_conn.resync_pending) {
+        warm_macs_handover();
+    }
+
+    /* A standby publishes the status once it takes over. */
+    if (l2macd_mac_state_changed()) {
+        status_pending = true;
+    }
+    if (l2macd_mac_counts_changed()) {
+        counts_pending = true;
+    }
+    if (counts_pending && !status_pending && time_msec() >= next_count_msec) {
+        l2macd_profile_note(L2MACD_WAKEUP_TIMER);
+        status_pending = true;
+    }
+    if (system_configured && has_lock && status_pending) {
+        status_publish();
+    }
+
+    /* Save the cache once per interval at most. The checkpoint file
+     * belongs to the active instance. */
+    if (has_lock && cache_dirty && time_msec() >= next_ckpt_msec) {
+        l2macd_profile_note(L2MACD_WAKEUP_TIMER);
+        l2macd_cache_checkpoint();
+    }
+
+    g_sched.run_total_msec += time_msec() - start;
+    if (time_msec() - start > g_sched.run_max_msec) {
+        g_sched.run_max_msec = time_msec() - start;
     }
 
     return;
@@ -806,4 +3603,339 @@ void
 l2macd_wait(void)
 {
     ovsdb_idl_wait(idl);
+
+    if (g_standby.lock_held && cache_dirty) {
+        poll_timer_wait_until(next_ckpt_msec);
+    }
+
+    if (g_standby.lock_held && counts_pending) {
+        poll_timer_wait_until(next_count_msec);
+    }
+
+    if (g_flush_batch.n_failures) {
+        poll_timer_wait_until(g_flush_batch.retry_msec);
+    }
+
+    if (g_hold.active) {
+        poll_timer_wait_until(MIN(g_hold.next_poll_msec,
+                                  g_hold.start_msec
+                                  + L2MACD_SWITCHD_HOLD_MAX_MSEC));
+    }
+
+    /* Backlog left, come back right after serving ovs-appctl. */
+    g_sched.immediate_wake = (g_sched.drain_pending
+                              || (!list_is_empty(&g_sched.queue)
+                                  && !g_conn.resync_pending));
+    if (g_sched.immediate_wake) {
+        poll_immediate_wake();
+    }
 } /* l2macd_wait */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_get_memory_usage
+ | Responsibility: Report the memory used by the cache structures and the
+ |                 OVSDB replica
+ | Parameters:
+ |      usage : counters by structure
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_get_memory_usage(struct simap *usage)
+{
+    const struct ovsrec_interface *iface_row;
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+    const struct port_data *port;
+    const struct shash_node *node;
+    const char *name;
+    size_t n_bytes, n_rows;
+
+    /* Cache entries with their strings and hash buckets. */
+    n_bytes = (g_l2macd_cache->port_table.mask + 1) * sizeof(void *);
+    HMAP_FOR_EACH (port, hmap_node, &g_l2macd_cache->port_table) {
+        n_bytes += sizeof *port + strlen(port->name) + 1;
+    }
+    simap_increase(usage, "ports", hmap_count(&g_l2macd_cache->port_table));
+    simap_increase(usage, "port-bytes", n_bytes);
+
+    n_bytes = (g_l2macd_cache->vlan_table.mask + 1) * sizeof(void *)
+              + hmap_count(&g_l2macd_cache->vlan_table)
+                * sizeof(struct vlan_data);
+    simap_increase(usage, "vlans", hmap_count(&g_l2macd_cache->vlan_table));
+    simap_increase(usage, "vlan-bytes", n_bytes);
+
+    /* Scheduler backlog and its dirty set. */
+    n_bytes = (g_sched.dirty.mask + 1) * sizeof(void *)
+              + g_sched.n_queued * sizeof(struct l2macd_work);
+    simap_increase(usage, "work-items", g_sched.n_queued);
+    simap_increase(usage, "work-bytes", n_bytes);
+
+    /* Pending flushes and intents recorded as a standby. */
+    n_bytes = bitmap_n_bytes(L2MACD_VLAN_BITMAP_SIZE);
+    SSET_FOR_EACH (name, &g_flush_batch.ports) {
+        n_bytes += sizeof(struct sset_node) + strlen(name);
+    }
+    SHASH_FOR_EACH (node, &g_flush_batch.port_vlans) {
+        n_bytes += sizeof *node + strlen(node->name) + 1
+                   + bitmap_n_bytes(L2MACD_VLAN_BITMAP_SIZE);
+    }
+    simap_increase(usage, "flush-ports", sset_count(&g_flush_batch.ports));
+    simap_increase(usage, "flush-bytes", n_bytes);
+
+    n_bytes = 0;
+    SHASH_FOR_EACH (node, &g_standby.ports) {
+        n_bytes += sizeof *node + strlen(node->name) + 1
+                   + sizeof(long long int);
+    }
+    SHASH_FOR_EACH (node, &g_standby.port_vlans) {
+        n_bytes += sizeof *node + strlen(node->name) + 1
+                   + sizeof(struct standby_port_vlans)
+                   + bitmap_n_bytes(L2MACD_VLAN_BITMAP_SIZE);
+    }
+    simap_increase(usage, "standby-ports", shash_count(&g_standby.ports)
+                   + shash_count(&g_standby.port_vlans));
+    simap_increase(usage, "standby-bytes", n_bytes);
+
+    /* Rows in the IDL replica. */
+    n_rows = 0;
+    OVSREC_INTERFACE_FOR_EACH(iface_row, idl) {
+        n_rows++;
+    }
+    simap_increase(usage, "idl-interfaces", n_rows);
+    simap_increase(usage, "iface-ports", hmap_count(&g_iface_ports));
+
+    n_rows = 0;
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        n_rows++;
+    }
+    simap_increase(usage, "idl-ports", n_rows);
+
+    n_rows = 0;
+    OVSREC_VLAN_FOR_EACH(vlan_row, idl) {
+        n_rows++;
+    }
+    simap_increase(usage, "idl-vlans", n_rows);
+
+    l2macd_mac_get_memory_usage(usage);
+
+    if (g_warm.pending) {
+        simap_increase(usage, "warm-macs", g_warm.snap.n_macs);
+        simap_increase(usage, "warm-mac-bytes",
+                       g_warm.snap.n_macs * sizeof g_warm.snap.macs[0]
+                       + g_warm.snap.n_ports * sizeof g_warm.snap.ports[0]);
+    }
+} /* l2macd_get_memory_usage */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_get_metrics
+ | Responsibility: Append the flush, cache and OVSDB metrics in the
+ |                 Prometheus text format
+ | Parameters:
+ |      ds : dynamic string into which the output data is written
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_get_metrics(struct ds *ds)
+{
+    uint64_t n_latencies = 0;
+    size_t i;
+
+    l2macd_metrics_header(ds, "l2macd_flush_requests_total", "counter",
+                          "MAC flush requests by reason.");
+    for (i = 0; i < L2MACD_N_FLUSH_REASONS; i++) {
+        ds_put_format(ds, "l2macd_flush_requests_total{reason=\"%s\"} "
+                      "%"PRIu64"\n", flush_reason_names[i],
+                      g_flush_stats.n_requests[i]);
+    }
+
+    l2macd_metrics_header(ds, "l2macd_flush_sent_total", "counter",
+                          "Ports and VLANs flushed.");
+    ds_put_format(ds, "l2macd_flush_sent_total %"PRIu64"\n",
+                  g_flush_stats.n_sent);
+
+    l2macd_metrics_header(ds, "l2macd_flush_transactions_total", "counter",
+                          "MAC flush transactions.");
+    ds_put_format(ds, "l2macd_flush_transactions_total %"PRIu64"\n",
+                  g_flush_stats.n_txns);
+
+    l2macd_metrics_header(ds, "l2macd_flush_transaction_errors_total",
+                          "counter", "Failed MAC flush transactions.");
+    ds_put_format(ds, "l2macd_flush_transaction_errors_total %"PRIu64"\n",
+                  g_flush_stats.n_txn_errors);
+
+    l2macd_metrics_header(ds, "l2macd_flush_latency_seconds", "histogram",
+                          "Time from a MAC flush request to its commit.");
+    for (i = 0; i < L2MACD_N_LATENCY_BUCKETS; i++) {
+        n_latencies += g_flush_stats.latency_buckets[i];
+        ds_put_format(ds, "l2macd_flush_latency_seconds_bucket{le=\"%g\"} "
+                      "%"PRIu64"\n", flush_latency_bounds[i] / 1000.0,
+                      n_latencies);
+    }
+    n_latencies += g_flush_stats.latency_buckets[L2MACD_N_LATENCY_BUCKETS];
+    ds_put_format(ds, "l2macd_flush_latency_seconds_bucket{le=\"+Inf\"} "
+                  "%"PRIu64"\n", n_latencies);
+    ds_put_format(ds, "l2macd_flush_latency_seconds_sum %.3f\n",
+                  g_flush_stats.latency_sum_msec / 1000.0);
+    ds_put_format(ds, "l2macd_flush_latency_seconds_count %"PRIu64"\n",
+                  n_latencies);
+
+    l2macd_metrics_header(ds, "l2macd_cache_entries", "gauge",
+                          "Entries in the l2macd cache.");
+    ds_put_format(ds, "l2macd_cache_entries{table=\"port\"} %zu\n",
+                  hmap_count(&g_l2macd_cache->port_table));
+    ds_put_format(ds, "l2macd_cache_entries{table=\"vlan\"} %zu\n",
+                  hmap_count(&g_l2macd_cache->vlan_table));
+
+    l2macd_metrics_header(ds, "l2macd_scheduler_backlog", "gauge",
+                          "Changed rows waiting for evaluation.");
+    ds_put_format(ds, "l2macd_scheduler_backlog %zu\n", g_sched.n_queued);
+
+    l2macd_metrics_header(ds, "l2macd_run_seconds_max", "gauge",
+                          "Longest main loop run.");
+    ds_put_format(ds, "l2macd_run_seconds_max %.3f\n",
+                  g_sched.run_max_msec / 1000.0);
+
+    l2macd_metrics_header(ds, "l2macd_ovsdb_reconnects_total", "counter",
+                          "Reconnections to the OVSDB server.");
+    ds_put_format(ds, "l2macd_ovsdb_reconnects_total %"PRIu64"\n",
+                  g_conn.n_reconnects);
+
+    l2macd_metrics_header(ds, "l2macd_active", "gauge",
+                          "1 if this instance holds the l2macd lock.");
+    ds_put_format(ds, "l2macd_active %d\n", g_standby.lock_held ? 1 : 0);
+
+    l2macd_mac_metrics(ds);
+} /* l2macd_get_metrics */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_debug_dump
+ | Responsibility: Dump the l2macd internal cache
+ | Parameters:
+ |      ds : dynamic string into which the output data is written
+ | Return:
+ |      None
+     ------------------------------------------------------------------------------
+ */
+void
+l2macd_debug_dump(struct ds *ds)
+{
+    const struct port_data *port;
+    const struct vlan_data *vlan;
+
+    ds_put_format(ds, "Ports: %zu\n",
+                  hmap_count(&g_l2macd_cache->port_table));
+    HMAP_FOR_EACH (port, hmap_node, &g_l2macd_cache->port_table) {
+        ds_put_format(ds, "  %-16s link %s\n", port->name,
+                      port->link_state ? "up" : "down");
+    }
+
+    ds_put_format(ds, "VLANs: %zu\n",
+                  hmap_count(&g_l2macd_cache->vlan_table));
+    HMAP_FOR_EACH (vlan, hmap_node, &g_l2macd_cache->vlan_table) {
+        ds_put_format(ds, "  %-16d oper %s\n", vlan->vlan_id,
+                      vlan->op_state ? "up" : "down");
+    }
+
+    ds_put_format(ds, "Role: %s\n",
+                  g_standby.lock_held ? "active" : "standby");
+    ds_put_format(ds, "  suppressed flushes: %"PRIu64", "
+                  "replayed: %"PRIu64"\n",
+                  g_standby.n_suppressed, g_standby.n_replayed);
+    ds_put_format(ds, "  takeovers: %"PRIu64"\n", g_standby.n_takeovers);
+    if (g_standby.n_takeovers) {
+        ds_put_format(ds, "  last takeover: %lld ms ago, latency %lld ms\n",
+                      time_msec() - g_standby.takeover_msec,
+                      g_standby.takeover_latency);
+    }
+
+    ds_put_format(ds, "OVSDB: %s%s\n",
+                  g_conn.alive ? "connected" : "disconnected",
+                  g_conn.resync_pending ? ", resync pending" : "");
+    ds_put_format(ds, "  reconnects: %"PRIu64"\n", g_conn.n_reconnects);
+    if (g_conn.n_reconnects) {
+        ds_put_format(ds, "  last reconnect: %lld ms ago\n",
+                      time_msec() - g_conn.reconnect_msec);
+    }
+
+    ds_put_format(ds, "ops-switchd restart hold: %s\n",
+                  g_hold.active ? "active" : "inactive");
+    ds_put_format(ds, "  windows: %"PRIu64", flushes held: %"PRIu64"\n",
+                  g_hold.n_windows, g_hold.n_held);
+
+    ds_put_format(ds, "Wakeups: %"PRIu64" runs, %"PRIu64" changes, "
+                  "%"PRIu64" skipped\n", g_wakeups.n_runs,
+                  g_wakeups.n_changes, g_wakeups.n_skipped);
+
+    ds_put_format(ds, "Replication:%s\n",
+#ifdef HAVE_IDL_CONDITION
+                  " conditional (system interfaces)"
+#else
+                  " full"
+#endif
+                  );
+    ds_put_format(ds, "  last sync: %lld ms, ready after %lld ms\n",
+                  g_sync_stats.sync_msec, g_sync_stats.ready_msec);
+    ds_put_format(ds, "  rows: %zu interfaces (%zu system), %zu ports, "
+                  "%zu vlans\n", g_sync_stats.n_iface_rows,
+                  g_sync_stats.n_system_ifaces, g_sync_stats.n_port_rows,
+                  g_sync_stats.n_vlan_rows);
+
+    ds_put_format(ds, "Scheduler:\n");
+    ds_put_format(ds, "  backlog: %zu queued, %zu max\n",
+                  g_sched.n_queued, g_sched.max_queued);
+    ds_put_format(ds, "  evaluated: %"PRIu64" items in %"PRIu64" slices, "
+                  "%"PRIu64" over budget\n", g_sched.n_items,
+                  g_sched.n_slices, g_sched.n_slice_budget_hit);
+    ds_put_format(ds, "  dirty set: %"PRIu64" changes, %"PRIu64" deduplicated\n",
+                  g_sched.n_changes, g_sched.n_dedup);
+    ds_put_format(ds, "  delete sweeps: %"PRIu64", %"PRIu64" deduplicated\n",
+                  g_sched.n_sweeps, g_sched.n_sweep_dedup);
+    ds_put_format(ds, "  idl runs: %"PRIu64", %"PRIu64" over budget\n",
+                  g_sched.n_drains, g_sched.n_drain_budget_hit);
+    ds_put_format(ds, "  run latency: %lld ms max, %.2f ms avg\n",
+                  g_sched.run_max_msec,
+                  g_wakeups.n_runs
+                  ? (double) g_sched.run_total_msec / g_wakeups.n_runs : 0.0);
+
+    l2macd_engine_dump(&engine_node_l2macd, ds);
+
+    ds_put_format(ds, "MAC age-time: %d seconds, %zu VLAN overrides%s\n",
+                  g_age.age_time, g_age.n_overrides,
+                  status_pending ? ", not published" : "");
+    ds_put_format(ds, "  status updates: %"PRIu64", invalid settings: "
+                  "%"PRIu64"\n", g_age.n_updates, g_age.n_invalid);
+
+    l2macd_mac_dump(ds);
+
+    if (g_warm.path == NULL) {
+        ds_put_cstr(ds, "Warm MACs: disabled\n");
+    } else {
+        ds_put_format(ds, "Warm MACs: %s\n", g_warm.path);
+        ds_put_format(ds, "  saves: %"PRIu64", last %zu MACs\n",
+                      g_warm.n_saves, g_warm.n_saved);
+        if (g_warm.load_error) {
+            ds_put_format(ds, "  rejected on boot: %s\n",
+                          g_warm.load_error == EINVAL
+                          ? "not a valid MAC snapshot"
+                          : ovs_strerror(g_warm.load_error));
+        }
+        if (g_warm.pending) {
+            ds_put_format(ds, "  pending: %zu MACs saved %lld ms ago\n",
+                          g_warm.snap.n_macs,
+                          time_wall_msec() - g_warm.snap.time_msec);
+        }
+        ds_put_format(ds, "  seeded: %zu, port missing or down: %zu, "
+                      "VLAN missing or down: %zu, learned again: %zu\n",
+                      g_warm.n_seeded, g_warm.n_no_port, g_warm.n_no_vlan,
+                      g_warm.n_present);
+        if (g_warm.seeded) {
+            ds_put_format(ds, "  seed: %s\n", g_warm.seed_path);
+        }
+    }
+
+    l2macd_ckpt_dump(ds);
+} /* l2macd_debug_dump */
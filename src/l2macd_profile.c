@@ -0,0 +1,296 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the ops-l2macd main loop profiler.
+ *
+ ****************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <dynamic-string.h>
+#include "l2macd_metrics.h"
+#include "l2macd_profile.h"
+#include "util.h"
+#include "timeval.h"
+
+/* One bucket per second: the longest window is made of complete seconds,
+ * plus the bucket of the current second. */
+#define PROFILE_MAX_WINDOW 300
+#define PROFILE_N_BUCKETS (PROFILE_MAX_WINDOW + 1)
+
+struct profile_bucket {
+    long long int sec;                          /* Second of the bucket */
+    long long int usec[L2MACD_N_PHASES];
+    uint64_t n_causes[L2MACD_N_WAKEUP_CAUSES];
+};
+
+static const char *phase_names[L2MACD_N_PHASES] = {
+    [L2MACD_PHASE_IDLE] = "idle",
+    [L2MACD_PHASE_IDL] = "idl",
+    [L2MACD_PHASE_CACHE] = "cache",
+    [L2MACD_PHASE_COMMIT] = "commit",
+    [L2MACD_PHASE_UNIXCTL] = "unixctl",
+    [L2MACD_PHASE_WAIT] = "wait",
+};
+
+static const char *cause_names[L2MACD_N_WAKEUP_CAUSES] = {
+    [L2MACD_WAKEUP_IDL] = "idl",
+    [L2MACD_WAKEUP_UNIXCTL] = "unixctl",
+    [L2MACD_WAKEUP_TIMER] = "timer",
+    [L2MACD_WAKEUP_IMMEDIATE] = "immediate",
+    [L2MACD_WAKEUP_OTHER] = "other",
+};
+
+static struct profile_bucket buckets[PROFILE_N_BUCKETS];
+static struct profile_bucket totals;
+static uint64_t n_loops = 0;
+
+static enum l2macd_phase cur_phase = L2MACD_PHASE_CACHE;
+static long long int phase_start_usec = 0;
+static unsigned int cause_mask = 0;     /* Causes of the current wakeup */
+
+/*-----------------------------------------------------------------------------
+ | Function: profile_bucket
+ | Responsibility: Get the bucket of the current second
+ | Parameters:
+ |      now_usec : current time
+ | Return:
+ |      bucket, cleared when reused for a new second
+ ------------------------------------------------------------------------------
+ */
+static struct profile_bucket *
+profile_bucket(long long int now_usec)
+{
+    long long int sec = now_usec / 1000000;
+    struct profile_bucket *bucket = &buckets[sec % PROFILE_N_BUCKETS];
+
+    if (bucket->sec != sec) {
+        memset(bucket, 0, sizeof *bucket);
+        bucket->sec = sec;
+    }
+    return bucket;
+} /* profile_bucket */
+
+/*-----------------------------------------------------------------------------
+ | Function: profile_charge
+ | Responsibility: Charge a time interval to a phase, split across the
+ |                 seconds it spans
+ | Parameters:
+ |      phase : phase
+ |      start_usec : start of the interval
+ |      end_usec : end of the interval
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+profile_charge(enum l2macd_phase phase, long long int start_usec,
+               long long int end_usec)
+{
+    long long int oldest_usec;
+
+    totals.usec[phase] += end_usec - start_usec;
+
+    /* Seconds older than the ring are in no window. */
+    oldest_usec = (end_usec / 1000000 - PROFILE_N_BUCKETS + 1) * 1000000;
+    start_usec = MAX(start_usec, oldest_usec);
+
+    while (start_usec < end_usec) {
+        long long int stop_usec = MIN(end_usec,
+                                      (start_usec / 1000000 + 1) * 1000000);
+
+        profile_bucket(start_usec)->usec[phase] += stop_usec - start_usec;
+        start_usec = stop_usec;
+    }
+} /* profile_charge */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_profile_enter
+ | Responsibility: Charge the elapsed time to the current phase and switch
+ |                 to a new one
+ | Parameters:
+ |      phase : phase starting
+ | Return:
+ |      previous phase
+ ------------------------------------------------------------------------------
+ */
+enum l2macd_phase
+l2macd_profile_enter(enum l2macd_phase phase)
+{
+    enum l2macd_phase prev = cur_phase;
+    long long int now = time_usec();
+
+    if (phase_start_usec) {
+        profile_charge(cur_phase, phase_start_usec, now);
+    }
+    phase_start_usec = now;
+    cur_phase = phase;
+
+    return prev;
+} /* l2macd_profile_enter */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_profile_note
+ | Responsibility: Note a cause of the current wakeup
+ | Parameters:
+ |      cause : wakeup cause
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_profile_note(enum l2macd_wakeup_cause cause)
+{
+    cause_mask |= 1u << cause;
+} /* l2macd_profile_note */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_profile_loop_end
+ | Responsibility: Account the cause of the wakeup ending
+ | Parameters:
+ |      None
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_profile_loop_end(void)
+{
+    enum l2macd_wakeup_cause cause = L2MACD_WAKEUP_OTHER;
+
+    if (cause_mask) {
+        cause = ffs(cause_mask) - 1;
+    }
+    totals.n_causes[cause]++;
+    profile_bucket(time_usec())->n_causes[cause]++;
+
+    cause_mask = 0;
+    n_loops++;
+} /* l2macd_profile_loop_end */
+
+/*-----------------------------------------------------------------------------
+ | Function: profile_window
+ | Responsibility: Sum the buckets of the last complete seconds
+ | Parameters:
+ |      n_secs : window length
+ |      sum : window totals
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+static void
+profile_window(int n_secs, struct profile_bucket *sum)
+{
+    long long int now_sec = time_usec() / 1000000;
+    int i, j;
+
+    memset(sum, 0, sizeof *sum);
+    for (i = 0; i < PROFILE_N_BUCKETS; i++) {
+        const struct profile_bucket *bucket = &buckets[i];
+
+        if (bucket->sec < now_sec - n_secs || bucket->sec >= now_sec) {
+            continue;
+        }
+        for (j = 0; j < L2MACD_N_PHASES; j++) {
+            sum->usec[j] += bucket->usec[j];
+        }
+        for (j = 0; j < L2MACD_N_WAKEUP_CAUSES; j++) {
+            sum->n_causes[j] += bucket->n_causes[j];
+        }
+    }
+} /* profile_window */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_profile_dump
+ | Responsibility: Append the loop statistics to a dynamic string
+ | Parameters:
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_profile_dump(struct ds *ds)
+{
+    static const int windows[] = { 1, 60, PROFILE_MAX_WINDOW };
+    struct profile_bucket sums[ARRAY_SIZE(windows)];
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(windows); i++) {
+        profile_window(windows[i], &sums[i]);
+    }
+
+    ds_put_format(ds, "Main loop: %"PRIu64" iterations\n", n_loops);
+    ds_put_format(ds, "%-12s %14s %10s %10s %10s\n", "Time (ms)", "total",
+                  "1s", "1min", "5min");
+    for (j = 0; j < L2MACD_N_PHASES; j++) {
+        ds_put_format(ds, "  %-10s %14.3f", phase_names[j],
+                      totals.usec[j] / 1000.0);
+        for (i = 0; i < ARRAY_SIZE(windows); i++) {
+            ds_put_format(ds, " %10.3f", sums[i].usec[j] / 1000.0);
+        }
+        ds_put_char(ds, '\n');
+    }
+
+    ds_put_format(ds, "%-12s %14s %10s %10s %10s\n", "Wakeups", "total",
+                  "1s", "1min", "5min");
+    for (j = 0; j < L2MACD_N_WAKEUP_CAUSES; j++) {
+        ds_put_format(ds, "  %-10s %14"PRIu64, cause_names[j],
+                      totals.n_causes[j]);
+        for (i = 0; i < ARRAY_SIZE(windows); i++) {
+            ds_put_format(ds, " %10"PRIu64, sums[i].n_causes[j]);
+        }
+        ds_put_char(ds, '\n');
+    }
+} /* l2macd_profile_dump */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_profile_metrics
+ | Responsibility: Append the loop totals to the exported metrics
+ | Parameters:
+ |      ds : dynamic string
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_profile_metrics(struct ds *ds)
+{
+    int i;
+
+    l2macd_metrics_header(ds, "l2macd_loop_seconds_total", "counter",
+                          "Main loop time by phase.");
+    for (i = 0; i < L2MACD_N_PHASES; i++) {
+        ds_put_format(ds, "l2macd_loop_seconds_total{phase=\"%s\"} %.6f\n",
+                      phase_names[i], totals.usec[i] / 1e6);
+    }
+
+    l2macd_metrics_header(ds, "l2macd_loop_wakeups_total", "counter",
+                          "Main loop wakeups by cause.");
+    for (i = 0; i < L2MACD_N_WAKEUP_CAUSES; i++) {
+        ds_put_format(ds, "l2macd_loop_wakeups_total{cause=\"%s\"} %"PRIu64
+                      "\n", cause_names[i], totals.n_causes[i]);
+    }
+} /* l2macd_profile_metrics */
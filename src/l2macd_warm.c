@@ -0,0 +1,318 @@
+/*
+ *Copyright (C) 2016 Hewlett-Packard Development Company, L.P.
+ *All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ */
+
+/*************************************************************************//**
+ * @ingroup l2macd
+ *
+ * @file
+ * Source file for the warm reboot MAC snapshot of l2macd.
+ *
+ ****************************************************************************/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openvswitch/vlog.h>
+#include "l2macd_crc.h"
+#include "l2macd_warm.h"
+#include "shash.h"
+#include "util.h"
+#include "timeval.h"
+
+VLOG_DEFINE_THIS_MODULE(l2macd_warm);
+
+/* Layout of the snapshot file, followed by the port names and the MACs. */
+struct l2macd_warm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_ports;
+    uint32_t n_macs;
+    int64_t time_msec;                  /* Wall clock time of the save */
+    uint32_t mac_size;                  /* Detects a change of the layout */
+    uint32_t checksum;                  /* CRC-32C of the whole file */
+};
+
+/*-----------------------------------------------------------------------------
+ | Function: warm_checksum
+ | Responsibility: Compute the checksum of a snapshot file
+ | Parameters:
+ |      hdr : file header
+ |      snap : snapshot
+ | Return:
+ |      CRC-32C of the header, with a zero checksum, the port names and the
+ |      MACs
+ ------------------------------------------------------------------------------
+ */
+static uint32_t
+warm_checksum(const struct l2macd_warm_header *hdr,
+              const struct l2macd_warm_snapshot *snap)
+{
+    struct l2macd_warm_header zeroed = *hdr;
+    uint32_t crc;
+
+    zeroed.checksum = 0;
+    crc = l2macd_crc32c(0, &zeroed, sizeof zeroed);
+    crc = l2macd_crc32c(crc, snap->ports, snap->n_ports * sizeof snap->ports[0]);
+    return l2macd_crc32c(crc, snap->macs, snap->n_macs * sizeof snap->macs[0]);
+} /* warm_checksum */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_init
+ | Responsibility: Initialize an empty snapshot
+ | Parameters:
+ |      snap : snapshot
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_warm_init(struct l2macd_warm_snapshot *snap)
+{
+    memset(snap, 0, sizeof *snap);
+    shash_init(&snap->port_index);
+} /* l2macd_warm_init */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_destroy
+ | Responsibility: Free a snapshot
+ | Parameters:
+ |      snap : snapshot
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_warm_destroy(struct l2macd_warm_snapshot *snap)
+{
+    shash_destroy(&snap->port_index);
+    free(snap->ports);
+    free(snap->macs);
+    l2macd_warm_init(snap);
+} /* l2macd_warm_destroy */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_add
+ | Responsibility: Add a MAC to a snapshot
+ | Parameters:
+ |      snap : snapshot
+ |      mac : MAC address
+ |      vid : VLAN ID
+ |      port : port name
+ | Return:
+ |      bool : false if the MAC is not added
+ ------------------------------------------------------------------------------
+ */
+bool
+l2macd_warm_add(struct l2macd_warm_snapshot *snap, const char *mac, int vid,
+                const char *port)
+{
+    struct l2macd_warm_mac *entry;
+    unsigned int b[6];
+    uintptr_t index;
+    int i;
+
+    if (mac == NULL || port == NULL || !L2MACD_WARM_VID_VALID(vid)
+        || sscanf(mac, "%x:%x:%x:%x:%x:%x",
+                  &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6
+        || strlen(port) >= L2MACD_WARM_NAME_LEN
+        || snap->n_macs >= L2MACD_WARM_MAX_MACS) {
+        return false;
+    }
+
+    /* Port names are saved once, the MACs refer to them by index. */
+    index = (uintptr_t) shash_find_data(&snap->port_index, port);
+    if (index == 0) {
+        if (snap->n_ports >= L2MACD_WARM_MAX_PORTS) {
+            return false;
+        }
+        if (snap->n_ports >= snap->allocated_ports) {
+            snap->ports = x2nrealloc(snap->ports, &snap->allocated_ports,
+                                     sizeof snap->ports[0]);
+        }
+        memset(snap->ports[snap->n_ports], 0, sizeof snap->ports[0]);
+        ovs_strlcpy(snap->ports[snap->n_ports], port, sizeof snap->ports[0]);
+        index = ++snap->n_ports;
+        shash_add(&snap->port_index, port, (void *) index);
+    }
+
+    if (snap->n_macs >= snap->allocated_macs) {
+        snap->macs = x2nrealloc(snap->macs, &snap->allocated_macs,
+                                sizeof snap->macs[0]);
+    }
+    entry = &snap->macs[snap->n_macs++];
+    for (i = 0; i < 6; i++) {
+        entry->mac[i] = b[i];
+    }
+    entry->vid = vid;
+    entry->port = index - 1;
+    return true;
+} /* l2macd_warm_add */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_format_mac
+ | Responsibility: Format the address of a saved MAC
+ | Parameters:
+ |      mac : saved MAC
+ |      buf : "xx:xx:xx:xx:xx:xx"
+ | Return:
+ |      None
+ ------------------------------------------------------------------------------
+ */
+void
+l2macd_warm_format_mac(const struct l2macd_warm_mac *mac, char buf[18])
+{
+    snprintf(buf, 18, "%02x:%02x:%02x:%02x:%02x:%02x", mac->mac[0],
+             mac->mac[1], mac->mac[2], mac->mac[3], mac->mac[4], mac->mac[5]);
+} /* l2macd_warm_format_mac */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_write
+ | Responsibility: Write a snapshot to a temporary file and rename it
+ | Parameters:
+ |      snap : snapshot
+ |      path : file path
+ | Return:
+ |      0 on success, errno value otherwise
+ ------------------------------------------------------------------------------
+ */
+int
+l2macd_warm_write(struct l2macd_warm_snapshot *snap, const char *path)
+{
+    struct l2macd_warm_header hdr;
+    char *tmp = xasprintf("%s.tmp", path);
+    int error = 0;
+    FILE *file;
+
+    file = fopen(tmp, "wb");
+    if (file == NULL) {
+        error = errno;
+        VLOG_WARN("%s: open failed (%s)", tmp, ovs_strerror(error));
+        free(tmp);
+        return error;
+    }
+
+    snap->time_msec = time_wall_msec();
+
+    memset(&hdr, 0, sizeof hdr);
+    hdr.magic = L2MACD_WARM_MAGIC;
+    hdr.version = L2MACD_WARM_VERSION;
+    hdr.n_ports = snap->n_ports;
+    hdr.n_macs = snap->n_macs;
+    hdr.time_msec = snap->time_msec;
+    hdr.mac_size = sizeof snap->macs[0];
+    hdr.checksum = warm_checksum(&hdr, snap);
+
+    if (fwrite(&hdr, sizeof hdr, 1, file) != 1
+        || fwrite(snap->ports, sizeof snap->ports[0], snap->n_ports, file)
+           != snap->n_ports
+        || fwrite(snap->macs, sizeof snap->macs[0], snap->n_macs, file)
+           != snap->n_macs
+        || fflush(file) != 0
+        || fsync(fileno(file)) < 0) {
+        error = errno ? errno : EIO;
+    }
+    if (fclose(file) != 0 && !error) {
+        error = errno;
+    }
+
+    /* The previous snapshot is only replaced by a complete one. */
+    if (!error && rename(tmp, path) < 0) {
+        error = errno;
+    }
+    if (error) {
+        VLOG_WARN("%s: write failed (%s)", path, ovs_strerror(error));
+        unlink(tmp);
+    }
+    free(tmp);
+    return error;
+} /* l2macd_warm_write */
+
+/*-----------------------------------------------------------------------------
+ | Function: l2macd_warm_read
+ | Responsibility: Read and check a snapshot file
+ | Parameters:
+ |      snap : snapshot, empty on error
+ |      path : file path
+ | Return:
+ |      0 on success, ENOENT without file, EINVAL if the file is not a
+ |      valid snapshot, errno value otherwise
+ ------------------------------------------------------------------------------
+ */
+int
+l2macd_warm_read(struct l2macd_warm_snapshot *snap, const char *path)
+{
+    struct l2macd_warm_header hdr;
+    int error = 0;
+    FILE *file;
+    size_t i;
+
+    l2macd_warm_init(snap);
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return errno;
+    }
+
+    if (fread(&hdr, sizeof hdr, 1, file) != 1
+        || hdr.magic != L2MACD_WARM_MAGIC
+        || hdr.version != L2MACD_WARM_VERSION
+        || hdr.mac_size != sizeof snap->macs[0]
+        || hdr.n_ports > L2MACD_WARM_MAX_PORTS
+        || hdr.n_macs > L2MACD_WARM_MAX_MACS) {
+        error = EINVAL;
+        goto out;
+    }
+
+    snap->time_msec = hdr.time_msec;
+    snap->n_ports = snap->allocated_ports = hdr.n_ports;
+    snap->ports = xmalloc(MAX(1, hdr.n_ports) * sizeof snap->ports[0]);
+    snap->n_macs = snap->allocated_macs = hdr.n_macs;
+    snap->macs = xmalloc(MAX(1, hdr.n_macs) * sizeof snap->macs[0]);
+
+    if (fread(snap->ports, sizeof snap->ports[0], hdr.n_ports, file)
+        != hdr.n_ports
+        || fread(snap->macs, sizeof snap->macs[0], hdr.n_macs, file)
+           != hdr.n_macs
+        || warm_checksum(&hdr, snap) != hdr.checksum) {
+        error = EINVAL;
+        goto out;
+    }
+
+    for (i = 0; i < snap->n_ports; i++) {
+        snap->ports[i][L2MACD_WARM_NAME_LEN - 1] = '\0';
+    }
+    /* A file with a valid checksum may still be corrupt or forged, every
+     * index is checked before it is used. */
+    for (i = 0; i < snap->n_macs; i++) {
+        if (snap->macs[i].port >= snap->n_ports
+            || !L2MACD_WARM_VID_VALID(snap->macs[i].vid)) {
+            error = EINVAL;
+            goto out;
+        }
+    }
+
+out:
+    fclose(file);
+    if (error) {
+        l2macd_warm_destroy(snap);
+    }
+    return error;
+} /* l2macd_warm_read */